@@ -0,0 +1,77 @@
+﻿#pragma once
+
+#include <chrono>
+#include <algorithm>
+
+/**
+ * @brief The Benchmark namespace holds the microbenchmarks of the engine and the timing they share.
+ *
+ * Usage:
+ * - Each benchmark is a function listed by name in main.cpp. The program runs the benchmarks named on its
+ *   command line, or all of them without arguments, and prints one line per measurement to std::cout.
+ * - Build the Release configuration: the numbers of a Debug build say nothing about the engine.
+ * - Timings are the best of several runs, which is the least disturbed by the rest of the machine.
+ */
+namespace Benchmark {
+
+    /**
+     * @brief Time a piece of work, keeping the fastest of several runs.
+     * @param runs The number of runs.
+     * @param body The work, called once per run.
+     * @return double The time of the fastest run, in milliseconds.
+     */
+    template <typename Body>
+    double bestOf(int runs, Body body) {
+        double best = 0;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = (run == 0) ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+
+    /**
+     * @brief Table::insertRecord throughput into a table with a PRIMARY KEY and a UNIQUE column.
+     */
+    void insert();
+
+    /**
+     * @brief Table::deleteRecord throughput of point deletes by PRIMARY KEY, in tables of 10k, 100k and 1M rows.
+     */
+    void deleteRows();
+
+    /**
+     * @brief Parser throughput on INSERT and SELECT statements, against the regular expressions it replaced.
+     */
+    void parse();
+
+    /**
+     * @brief Single-row INSERT statements/s through the QueryProcessor at each logging level, output to a file.
+     */
+    void logging();
+
+    /**
+     * @brief Encryption MB/s of the AES-256 modes snapshots and logs are sealed with, against the XOR loop they replaced.
+     */
+    void cipher();
+
+    /**
+     * @brief Table::findRecords rows/s over 1M rows without an index, for several WHERE conditions, in both layouts.
+     */
+    void scan();
+
+    /**
+     * @brief FilterKernels values/s on 1M INTEGER and FLOAT values, in each variant the processor supports; exits
+     * with an error if a variant sets other bits than the scalar one.
+     */
+    void filter();
+
+    /**
+     * @brief Heap bytes per row of a 1M-row table in both layouts, against its Records and the string map rows
+     * were stored in before values were typed.
+     */
+    void memory();
+
+} // namespace Benchmark
@@ -0,0 +1,50 @@
+﻿#include "Benchmark.h"
+#include "Table.h"
+#include "Constraint.h"
+#include "Condition.h"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+// Point deletes by PRIMARY KEY, one statement each, from a table that also has an ordered index. Each delete
+// should touch the keys of the record removed and of the one moved into its place only, so the rate should
+// stay flat as the table grows.
+void Benchmark::deleteRows() {
+    const size_t DELETES = 1000;
+    Schema schema;
+    schema.addColumn(Column("id", DataType::INTEGER));
+    schema.addColumn(Column("name", DataType::STRING));
+    schema.addColumn(Column("age", DataType::INTEGER));
+    schema.addConstraint(std::make_shared<PrimaryKeyConstraint>(std::vector<std::string>{ "id" }));
+    for (size_t rows : { size_t(10000), size_t(100000), size_t(1000000) }) {
+        std::vector<Record> records(rows, Record(3));
+        for (size_t i = 0; i < rows; ++i) {
+            records[i].setValue(0, Value(static_cast<int64_t>(i)));
+            records[i].setValue(1, Value("user" + std::to_string(i)));
+            records[i].setValue(2, Value(static_cast<int64_t>((i * 7919) % 100)));
+        }
+        // Spread the deleted keys over the whole table.
+        std::vector<Condition> conditions(DELETES);
+        for (size_t i = 0; i < DELETES; ++i) {
+            conditions[i].kind = Condition::Kind::COMPARE;
+            conditions[i].column = "id";
+            conditions[i].op = "=";
+            conditions[i].values.push_back(Literal{ Literal::Kind::NUMBER, std::to_string(i * (rows / DELETES)) });
+        }
+        // The table is rebuilt for every run; only the deletes are timed.
+        double best = 0;
+        for (int run = 0; run < 3; ++run) {
+            Table table("t", schema);
+            table.loadRecords(records);
+            table.createIndex("ia", { "age" });
+            double ms = bestOf(1, [&table, &conditions] {
+                for (const Condition& condition : conditions)
+                    table.deleteRecord(condition);
+            });
+            best = (run == 0) ? ms : std::min(best, ms);
+        }
+        std::cout << std::setw(8) << rows << " rows  " << std::fixed << std::setprecision(0)
+            << std::setw(10) << DELETES / best * 1000 << " deletes/s\n";
+    }
+}
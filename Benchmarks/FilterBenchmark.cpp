@@ -0,0 +1,79 @@
+﻿#include "Benchmark.h"
+#include "FilterKernels.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using FilterKernels::InstructionSet;
+
+static const char* toString(InstructionSet set) {
+    switch (set) {
+    case InstructionSet::AVX2:
+        return "AVX2";
+    case InstructionSet::SSE42:
+        return "SSE42";
+    default:
+        return "SCALAR";
+    }
+}
+
+// Time one kernel in every variant the processor supports, and check that each sets the bits the scalar loop
+// does; a variant that differs is a bug, so the benchmark stops there.
+template <typename Kernel>
+static void report(const char* type, const char* test, size_t count, Kernel kernel) {
+    std::vector<uint64_t> expected((count + 63) / 64);
+    kernel(expected.data(), InstructionSet::SCALAR);
+    for (InstructionSet set : { InstructionSet::SCALAR, InstructionSet::SSE42, InstructionSet::AVX2 }) {
+        std::cout << std::left << std::setw(8) << type << std::setw(10) << test << std::setw(8) << toString(set);
+        if (set > FilterKernels::getInstructionSet()) {
+            std::cout << "not supported by this processor\n";
+            continue;
+        }
+        std::vector<uint64_t> bits(expected.size());
+        double ms = Benchmark::bestOf(5, [&kernel, &bits, set] { kernel(bits.data(), set); });
+        std::cout << std::right << std::fixed << std::setprecision(0) << std::setw(14) << count / ms * 1000 << " values/s\n";
+        if (bits != expected) {
+            std::cerr << "Error: The " << toString(set) << " kernel sets other bits than the scalar one for " << type
+                << ' ' << test << '.' << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+template <typename T>
+static void run(const char* type, const std::vector<T>& values, T low, T middle, T high) {
+    const T* data = values.data();
+    size_t count = values.size();
+    report(type, "=", count, [data, count, middle](uint64_t* bits, InstructionSet set) {
+        FilterKernels::compare(data, count, Predicate::Op::EQUAL, middle, bits, set);
+    });
+    report(type, "<", count, [data, count, middle](uint64_t* bits, InstructionSet set) {
+        FilterKernels::compare(data, count, Predicate::Op::LESS, middle, bits, set);
+    });
+    report(type, ">", count, [data, count, middle](uint64_t* bits, InstructionSet set) {
+        FilterKernels::compare(data, count, Predicate::Op::GREATER, middle, bits, set);
+    });
+    report(type, "BETWEEN", count, [data, count, low, high](uint64_t* bits, InstructionSet set) {
+        FilterKernels::between(data, count, low, high, bits, set);
+    });
+}
+
+// The kernels alone on 1M values, outside of any table: each operator in each variant, checked against the
+// scalar variant bit for bit.
+void Benchmark::filter() {
+    const size_t VALUES = 1000000;
+    std::vector<int64_t> integers(VALUES);
+    std::vector<double> floats(VALUES);
+    for (size_t i = 0; i < VALUES; ++i) {
+        integers[i] = static_cast<int64_t>((i * 7919) % 1000) - 500;
+        floats[i] = integers[i] * 0.25;
+    }
+    // The extremes of the type, where a wrong lane width or sign would show.
+    integers[1] = INT64_MIN;
+    integers[2] = INT64_MAX;
+    run<int64_t>("INTEGER", integers, -250, 0, 250);
+    run<double>("FLOAT", floats, -62.5, 0, 62.5);
+}
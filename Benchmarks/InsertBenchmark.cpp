@@ -0,0 +1,31 @@
+﻿#include "Benchmark.h"
+#include "Table.h"
+#include "Constraint.h"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+// Single-record inserts are checked against the PRIMARY KEY and UNIQUE hash indexes one at a time, so the
+// rate should stay flat as the table grows; a scan for duplicates would make it fall with the size.
+void Benchmark::insert() {
+    Schema schema;
+    schema.addColumn(Column("id", DataType::INTEGER));
+    schema.addColumn(Column("name", DataType::STRING));
+    schema.addConstraint(std::make_shared<PrimaryKeyConstraint>(std::vector<std::string>{ "id" }));
+    schema.addConstraint(std::make_shared<UniqueConstraint>(std::vector<std::string>{ "name" }));
+    for (size_t rows : { size_t(10000), size_t(100000), size_t(1000000) }) {
+        std::vector<Record> records(rows, Record(2));
+        for (size_t i = 0; i < rows; ++i) {
+            records[i].setValue(0, Value(static_cast<int64_t>(i)));
+            records[i].setValue(1, Value("user" + std::to_string(i)));
+        }
+        double ms = bestOf(rows < 1000000 ? 3 : 1, [&schema, &records] {
+            Table table("t", schema);
+            for (const Record& record : records)
+                table.insertRecord(record);
+        });
+        std::cout << std::setw(8) << rows << " rows  " << std::fixed << std::setprecision(0)
+            << std::setw(10) << rows / ms * 1000 << " rows/s\n";
+    }
+}
@@ -0,0 +1,49 @@
+﻿#include "Benchmark.h"
+#include "QueryProcessor.h"
+#include "Database.h"
+#include "Logger.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Single-row INSERT statements through the QueryProcessor at each logging level, with the console written to a
+// file, so that what is measured is what a script piped to a file pays for its messages.
+void Benchmark::logging() {
+    const int STATEMENTS = 100000;
+    const char* OUTPUT = "benchmark_logging.tmp";
+    std::vector<std::string> inserts;
+    for (int i = 0; i < STATEMENTS; ++i) {
+        std::string n = std::to_string(i);
+        inserts.push_back("INSERT INTO logging (id, name, age) VALUES (" + n + ", 'name" + n + "', "
+            + std::to_string(i * 7919 % 100) + ");");
+    }
+    QueryProcessor processor;
+    std::vector<double> rates;
+    for (LogLevel level : { LogLevel::QUIET, LogLevel::NORMAL, LogLevel::VERBOSE }) {
+        std::ofstream file(OUTPUT);
+        std::streambuf* console = std::cout.rdbuf(file.rdbuf());
+        double ms = bestOf(3, [&processor, &inserts, level] {
+            Logger::setLevel(LogLevel::QUIET);
+            if (Database::getInstance().hasTable("logging"))
+                Database::getInstance().dropTable("logging");
+            processor.execute("CREATE TABLE logging (id INTEGER, name STRING, age INTEGER, PRIMARY KEY (id));");
+            Logger::setLevel(level);
+            for (const auto& insert : inserts)
+                processor.execute(insert);
+            std::cout.flush();
+        });
+        std::cout.rdbuf(console);
+        rates.push_back(STATEMENTS / ms * 1000);
+    }
+    Logger::setLevel(LogLevel::QUIET);
+    Database::getInstance().dropTable("logging");
+    std::remove(OUTPUT);
+    const char* names[] = { "QUIET", "NORMAL", "VERBOSE" };
+    for (size_t i = 0; i < rates.size(); ++i) {
+        std::cout << std::left << std::setw(10) << names[i] << std::right << std::fixed << std::setprecision(0)
+            << std::setw(10) << rates[i] << " inserts/s\n";
+    }
+}
@@ -0,0 +1,101 @@
+﻿#include "Benchmark.h"
+#include "Table.h"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// The bytes the program holds on the heap: those the C library's allocator hands out (headers included) where
+// it tells, else the private bytes the process has committed. Both only grow with what is allocated meanwhile.
+static bool heapBytes(size_t& bytes) {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+        return false;
+    bytes = counters.PrivateUsage;
+    return true;
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    bytes = info.uordblks + info.hblkhd;
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+// Report the heap bytes per row that building something of rows rows takes; it is kept until the report is out.
+template <typename Build>
+static void report(const char* label, size_t rows, Build build) {
+    size_t before = 0, after = 0;
+    bool measured = heapBytes(before);
+    auto built = build();
+    measured = measured && heapBytes(after);
+    std::cout << std::left << std::setw(40) << label << std::right;
+    if (!measured)
+        std::cout << "not measured on this platform\n";
+    else
+        std::cout << std::fixed << std::setprecision(1) << std::setw(10) << (after - before) / static_cast<double>(rows)
+            << " bytes/row\n";
+}
+
+// The heap a 1M-row table takes per row (the rows of the scan benchmark: an INTEGER, a STRING that is NULL
+// in every 97th row, an INTEGER and a FLOAT), in both storage layouts, against the Records it is loaded from
+// and the string map every row was before values were typed.
+void Benchmark::memory() {
+    const size_t ROWS = 1000000;
+    Schema schema;
+    schema.addColumn(Column("id", DataType::INTEGER, false));
+    schema.addColumn(Column("name", DataType::STRING));
+    schema.addColumn(Column("age", DataType::INTEGER));
+    schema.addColumn(Column("score", DataType::FLOAT));
+    auto makeRecords = [&schema, ROWS]() {
+        auto records = std::make_shared<std::vector<Record>>(ROWS, Record(schema.getColumns().size()));
+        for (size_t i = 0; i < ROWS; ++i) {
+            Record& record = (*records)[i];
+            record.setValue(0, Value(static_cast<int64_t>(i)));
+            record.setValue(1, i % 97 == 0 ? Value() : Value("n" + std::to_string(i)));
+            record.setValue(2, Value(static_cast<int64_t>((i * 7919) % 100)));
+            record.setValue(3, Value(((i * 104729) % 1000) / 1000.0));
+        }
+        return records;
+    };
+
+    // The baseline: a map from column name to text per row, with no entry for a NULL.
+    report("unordered_map<string, string> (baseline)", ROWS, [ROWS]() {
+        auto rows = std::make_shared<std::vector<std::unordered_map<std::string, std::string>>>(ROWS);
+        for (size_t i = 0; i < ROWS; ++i) {
+            auto& row = (*rows)[i];
+            row["id"] = std::to_string(i);
+            if (i % 97 != 0)
+                row["name"] = "n" + std::to_string(i);
+            row["age"] = std::to_string((i * 7919) % 100);
+            row["score"] = std::to_string(((i * 104729) % 1000) / 1000.0);
+        }
+        return rows;
+    });
+    report("Record", ROWS, makeRecords);
+    std::shared_ptr<std::vector<Record>> records = makeRecords();
+    for (StorageLayout layout : { StorageLayout::ROW, StorageLayout::COLUMNAR }) {
+        report(layout == StorageLayout::ROW ? "Table, ROW" : "Table, COLUMNAR", ROWS, [&schema, &records, layout]() {
+            auto table = std::make_shared<Table>("memory", schema, layout);
+            table->loadRecords(*records);
+            return table;
+        });
+    }
+}
@@ -0,0 +1,58 @@
+﻿#include "Benchmark.h"
+#include "Table.h"
+#include "Parser.h"
+#include "Statement.h"
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The WHERE clause of a SELECT, as the Parser builds it.
+static Condition where(const std::string& text) {
+    std::string sql = "SELECT * FROM scan WHERE " + text + ";";
+    Parser parser(sql); // The parser refers to the text; it must outlive it.
+    std::unique_ptr<Statement> statement = parser.parse();
+    return static_cast<SelectStatement&>(*statement).where;
+}
+
+// Table::findRecords over 1M rows without an index, in both storage layouts: every condition is bound once,
+// then checked against every row.
+void Benchmark::scan() {
+    const size_t ROWS = 1000000;
+    const char* conditions[] = {
+        "age < 50",
+        "name = 'n123457'",
+        "score > 0.5",
+        "age BETWEEN 10 AND 40",
+        "age IN (3, 17, 42, 99)",
+        "name IS NULL",
+        "age >= 10 AND score < 0.5",
+        "age < 5 OR name = 'n42'",
+        "NOT (age < 50 AND score >= 0.25)",
+    };
+    Schema schema;
+    schema.addColumn(Column("id", DataType::INTEGER, false));
+    schema.addColumn(Column("name", DataType::STRING));
+    schema.addColumn(Column("age", DataType::INTEGER));
+    schema.addColumn(Column("score", DataType::FLOAT));
+    std::vector<Record> records(ROWS, Record(4));
+    for (size_t i = 0; i < ROWS; ++i) {
+        records[i].setValue(0, Value(static_cast<int64_t>(i)));
+        records[i].setValue(1, i % 97 == 0 ? Value() : Value("n" + std::to_string(i)));
+        records[i].setValue(2, Value(static_cast<int64_t>((i * 7919) % 100)));
+        records[i].setValue(3, Value(((i * 104729) % 1000) / 1000.0));
+    }
+    for (StorageLayout layout : { StorageLayout::ROW, StorageLayout::COLUMNAR }) {
+        Table table("scan", schema, layout);
+        table.loadRecords(records);
+        std::cout << (layout == StorageLayout::ROW ? "ROW" : "COLUMNAR") << '\n';
+        for (const char* text : conditions) {
+            Condition condition = where(text);
+            std::vector<size_t> positions;
+            double ms = bestOf(5, [&table, &condition, &positions] { table.findRecords(condition, positions); });
+            std::cout << "  " << std::left << std::setw(36) << text << std::right << std::setw(8) << positions.size()
+                << " rows" << std::fixed << std::setprecision(0) << std::setw(14) << ROWS / ms * 1000 << " rows/s\n";
+        }
+    }
+}
@@ -0,0 +1,52 @@
+﻿#include "Benchmark.h"
+#include "Logger.h"
+#include <iostream>
+#include <cstring>
+
+// The benchmarks, by the name that selects them on the command line.
+static const struct {
+    const char* name;
+    void (*run)();
+} BENCHMARKS[] = {
+    { "insert", Benchmark::insert },
+    { "delete", Benchmark::deleteRows },
+    { "parse", Benchmark::parse },
+    { "logging", Benchmark::logging },
+    { "cipher", Benchmark::cipher },
+    { "scan", Benchmark::scan },
+    { "filter", Benchmark::filter },
+    { "memory", Benchmark::memory },
+};
+
+/**
+ * @brief Run the benchmarks named on the command line, or all of them.
+ * Usage:
+ *   Benchmarks [name ...]
+ */
+int main(int argc, char* argv[]) {
+    // Only the measurements are of interest; the engine reports errors alone.
+    Logger::setLevel(LogLevel::QUIET);
+    for (int i = 1; i < argc; ++i) {
+        bool known = false;
+        for (const auto& benchmark : BENCHMARKS)
+            known = known || std::strcmp(argv[i], benchmark.name) == 0;
+        if (!known) {
+            std::cerr << "Error: Unknown benchmark '" << argv[i] << "'. Available:";
+            for (const auto& benchmark : BENCHMARKS)
+                std::cerr << ' ' << benchmark.name;
+            std::cerr << std::endl;
+            return 1;
+        }
+    }
+    for (const auto& benchmark : BENCHMARKS) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i)
+            selected = selected || std::strcmp(argv[i], benchmark.name) == 0;
+        if (!selected)
+            continue;
+        std::cout << "== " << benchmark.name << '\n';
+        benchmark.run();
+        std::cout << std::endl;
+    }
+    return 0;
+}
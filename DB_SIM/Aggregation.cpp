@@ -0,0 +1,350 @@
+﻿#include "Aggregation.h"
+#include "Schema.h"
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+// The hash of a NULL key column (a value that hashes the same only costs a key comparison).
+static const uint64_t NULL_HASH = 0x6A09E667F3BCC909ull;
+static const size_t MIN_SLOTS = 16;
+
+static inline bool isNull(const uint64_t* nulls, size_t row) {
+    return (nulls[row >> 6] >> (row & 63)) & 1;
+}
+
+static inline uint64_t hashOf(int64_t value) {
+    return static_cast<uint64_t>(value);
+}
+
+static inline uint64_t hashOf(double value) {
+    double folded = (value == 0.0) ? 0.0 : value; // -0.0 and 0.0 are one key.
+    uint64_t bits = 0;
+    std::memcpy(&bits, &folded, sizeof(bits));
+    return bits;
+}
+
+static inline uint64_t hashOf(const std::string* value) {
+    return std::hash<std::string>()(*value);
+}
+
+// Mix the hash of one more key column into a row's hash.
+static inline uint64_t combine(uint64_t hash, uint64_t value) {
+    return ((hash << 27 | hash >> 37) ^ value) * 0x9E3779B97F4A7C15ull;
+}
+
+// The first slot to probe for a hash (the multiplications leave the high bits better mixed than the low ones).
+static inline size_t home(uint64_t hash, size_t mask) {
+    return static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+}
+
+template <typename T>
+static void hashValues(const T* values, const uint64_t* nulls, const uint16_t* selected, size_t count, uint64_t* hashes) {
+    for (size_t k = 0; k < count; ++k) {
+        size_t row = selected[k];
+        hashes[k] = combine(hashes[k], isNull(nulls, row) ? NULL_HASH : hashOf(values[row]));
+    }
+}
+
+// Add to an INTEGER sum, unless the sum would overflow.
+static inline bool addChecked(int64_t& sum, int64_t value) {
+    if (value > 0 ? sum > std::numeric_limits<int64_t>::max() - value : sum < std::numeric_limits<int64_t>::min() - value)
+        return false;
+    sum += value;
+    return true;
+}
+
+// Count the values that are not NULL of the selected rows in the slots of their groups (groups is null for a
+// single group).
+static void countValues(const uint64_t* nulls, const uint16_t* selected, size_t count, const uint32_t* groups, int64_t* counts) {
+    if (!groups) {
+        int64_t n = 0;
+        for (size_t k = 0; k < count; ++k)
+            n += !isNull(nulls, selected[k]);
+        counts[0] += n;
+        return;
+    }
+    for (size_t k = 0; k < count; ++k)
+        counts[groups[k]] += !isNull(nulls, selected[k]);
+}
+
+// Fold the values that are not NULL of the selected rows into the slots of their groups, with
+// step(result, value, first) (false on an overflow). A single group's slot is kept in locals for the batch.
+template <typename T, typename V, typename Step>
+static bool fold(const V* values, const uint64_t* nulls, const uint16_t* selected, size_t count, const uint32_t* groups,
+    int64_t* counts, T* results, Step step) {
+    if (!groups) {
+        int64_t n = counts[0];
+        T result = results[0];
+        bool folded = true;
+        for (size_t k = 0; k < count && folded; ++k) {
+            size_t row = selected[k];
+            if (!isNull(nulls, row)) {
+                folded = step(result, values[row], n == 0);
+                ++n;
+            }
+        }
+        counts[0] = n;
+        results[0] = std::move(result);
+        return folded;
+    }
+    for (size_t k = 0; k < count; ++k) {
+        size_t row = selected[k];
+        if (isNull(nulls, row))
+            continue;
+        uint32_t group = groups[k];
+        if (!step(results[group], values[row], counts[group] == 0))
+            return false;
+        ++counts[group];
+    }
+    return true;
+}
+
+Aggregation::Aggregation(const Schema& schema, const std::vector<size_t>& groupOrdinals, const std::vector<Aggregate>& aggregates)
+    : schema(schema), groupOrdinals(groupOrdinals), aggregates(aggregates), groupCount(0) {
+    const auto& columns = schema.getColumns();
+    keys.resize(groupOrdinals.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        keys[i].type = columns[groupOrdinals[i]].getType();
+    // The running value of an aggregate: a FLOAT sum for AVG, the column's type for SUM, MIN and MAX.
+    results.resize(aggregates.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        Function function = aggregates[i].function;
+        results[i].type = (function == Function::AVG) ? DataType::FLOAT
+            : (function == Function::COUNT_ALL || function == Function::COUNT) ? DataType::INTEGER
+            : columns[aggregates[i].ordinal].getType();
+    }
+    if (groupOrdinals.empty()) {
+        groupCount = 1;
+        hashes.push_back(0);
+        addResults();
+    }
+    else
+        rehash(MIN_SLOTS);
+}
+
+const std::vector<size_t>& Aggregation::getGroupOrdinals() const {
+    return groupOrdinals;
+}
+
+void Aggregation::reserve(size_t groups) {
+    if (groupOrdinals.empty())
+        return;
+    // At most half the slots are used, so that probes stay short.
+    size_t slots = MIN_SLOTS;
+    while (slots / 2 < groups)
+        slots *= 2;
+    if (slots > table.size())
+        rehash(slots);
+}
+
+bool Aggregation::add(Batch& batch) {
+    const std::vector<uint16_t>& selection = batch.getSelection();
+    if (selection.empty())
+        return true;
+    if (!groupOrdinals.empty())
+        group(batch, selection.data(), selection.size());
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        if (!accumulate(i, batch, selection.data(), selection.size()))
+            return false;
+    }
+    return true;
+}
+
+size_t Aggregation::getGroupCount() const {
+    return groupCount;
+}
+
+Value Aggregation::getKey(size_t group, size_t column) const {
+    const Slots& key = keys[column];
+    if (key.nulls[group])
+        return Value();
+    switch (key.type) {
+    case DataType::INTEGER: return Value(key.integers[group]);
+    case DataType::FLOAT: return Value(key.floats[group]);
+    default: return Value(key.strings[group]);
+    }
+}
+
+Value Aggregation::getResult(size_t group, size_t aggregate) const {
+    const Slots& result = results[aggregate];
+    Function function = aggregates[aggregate].function;
+    if (function == Function::COUNT_ALL || function == Function::COUNT)
+        return Value(result.counts[group]);
+    if (result.counts[group] == 0)
+        return Value();
+    if (function == Function::AVG)
+        return Value(result.floats[group] / static_cast<double>(result.counts[group]));
+    switch (result.type) {
+    case DataType::INTEGER: return Value(result.integers[group]);
+    case DataType::FLOAT: return Value(result.floats[group]);
+    default: return Value(result.strings[group]);
+    }
+}
+
+void Aggregation::group(Batch& batch, const uint16_t* selected, size_t count) {
+    // Hash the keys of the rows a column at a time, then look every row up.
+    std::vector<const ColumnVector*> vectors;
+    rowHashes.assign(count, 0);
+    for (size_t ordinal : groupOrdinals) {
+        const ColumnVector& column = batch.getColumn(ordinal);
+        vectors.push_back(&column);
+        switch (column.type) {
+        case DataType::INTEGER: hashValues(column.integers, column.nulls, selected, count, rowHashes.data()); break;
+        case DataType::FLOAT: hashValues(column.floats, column.nulls, selected, count, rowHashes.data()); break;
+        default: hashValues(column.strings, column.nulls, selected, count, rowHashes.data()); break;
+        }
+    }
+    rowGroups.resize(count);
+    for (size_t k = 0; k < count; ++k)
+        rowGroups[k] = findGroup(vectors, selected[k], rowHashes[k]);
+}
+
+uint32_t Aggregation::findGroup(const std::vector<const ColumnVector*>& vectors, size_t row, uint64_t hash) {
+    size_t mask = table.size() - 1;
+    size_t slot = home(hash, mask);
+    for (; table[slot] != 0; slot = (slot + 1) & mask) {
+        uint32_t group = table[slot] - 1;
+        if (hashes[group] == hash && hasKey(group, vectors, row))
+            return group;
+    }
+    // A new group; the table doubles before it is more than half full.
+    if ((groupCount + 1) * 2 > table.size()) {
+        rehash(table.size() * 2);
+        mask = table.size() - 1;
+        slot = home(hash, mask);
+        while (table[slot] != 0)
+            slot = (slot + 1) & mask;
+    }
+    uint32_t group = static_cast<uint32_t>(groupCount++);
+    table[slot] = group + 1;
+    hashes.push_back(hash);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Slots& key = keys[i];
+        const ColumnVector& column = *vectors[i];
+        bool null = isNull(column.nulls, row);
+        key.nulls.push_back(null);
+        switch (key.type) {
+        case DataType::INTEGER: key.integers.push_back(null ? 0 : column.integers[row]); break;
+        case DataType::FLOAT: key.floats.push_back(null ? 0.0 : column.floats[row]); break;
+        default: key.strings.push_back(null ? std::string() : *column.strings[row]); break;
+        }
+    }
+    addResults();
+    return group;
+}
+
+bool Aggregation::hasKey(uint32_t group, const std::vector<const ColumnVector*>& vectors, size_t row) const {
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const Slots& key = keys[i];
+        const ColumnVector& column = *vectors[i];
+        bool null = isNull(column.nulls, row);
+        if (null != (key.nulls[group] != 0))
+            return false;
+        if (null)
+            continue;
+        bool equal = (key.type == DataType::INTEGER) ? column.integers[row] == key.integers[group]
+            : (key.type == DataType::FLOAT) ? column.floats[row] == key.floats[group]
+            : *column.strings[row] == key.strings[group];
+        if (!equal)
+            return false;
+    }
+    return true;
+}
+
+void Aggregation::addResults() {
+    for (size_t i = 0; i < results.size(); ++i) {
+        Slots& result = results[i];
+        result.counts.push_back(0);
+        Function function = aggregates[i].function;
+        if (function == Function::COUNT_ALL || function == Function::COUNT)
+            continue;
+        switch (result.type) {
+        case DataType::INTEGER: result.integers.push_back(0); break;
+        case DataType::FLOAT: result.floats.push_back(0.0); break;
+        default: result.strings.emplace_back(); break;
+        }
+    }
+}
+
+void Aggregation::rehash(size_t slots) {
+    table.assign(slots, 0);
+    size_t mask = slots - 1;
+    for (size_t group = 0; group < groupCount; ++group) {
+        size_t slot = home(hashes[group], mask);
+        while (table[slot] != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = static_cast<uint32_t>(group + 1);
+    }
+}
+
+bool Aggregation::accumulate(size_t aggregate, Batch& batch, const uint16_t* selected, size_t count) {
+    Slots& result = results[aggregate];
+    Function function = aggregates[aggregate].function;
+    const uint32_t* groups = groupOrdinals.empty() ? nullptr : rowGroups.data();
+    if (function == Function::COUNT_ALL) {
+        if (!groups)
+            result.counts[0] += static_cast<int64_t>(count);
+        else {
+            for (size_t k = 0; k < count; ++k)
+                ++result.counts[groups[k]];
+        }
+        return true;
+    }
+
+    // One loop per function and column type, chosen once per batch.
+    const ColumnVector& column = batch.getColumn(aggregates[aggregate].ordinal);
+    const uint64_t* nulls = column.nulls;
+    int64_t* counts = result.counts.data();
+    switch (function) {
+    case Function::COUNT:
+        countValues(nulls, selected, count, groups, counts);
+        return true;
+
+    case Function::SUM:
+        if (column.type == DataType::FLOAT)
+            return fold(column.floats, nulls, selected, count, groups, counts, result.floats.data(),
+                [](double& sum, double value, bool) { sum += value; return true; });
+        if (fold(column.integers, nulls, selected, count, groups, counts, result.integers.data(),
+                [](int64_t& sum, int64_t value, bool) { return addChecked(sum, value); }))
+            return true;
+        std::cerr << "Error: SUM(" << schema.getColumns()[aggregates[aggregate].ordinal].getName()
+            << ") overflows a 64-bit integer." << std::endl;
+        return false;
+
+    case Function::AVG:
+        if (column.type == DataType::FLOAT)
+            return fold(column.floats, nulls, selected, count, groups, counts, result.floats.data(),
+                [](double& sum, double value, bool) { sum += value; return true; });
+        return fold(column.integers, nulls, selected, count, groups, counts, result.floats.data(),
+            [](double& sum, int64_t value, bool) { sum += static_cast<double>(value); return true; });
+
+    default: {
+        // MIN and MAX: the first value of a group, then any value beyond it.
+        bool least = function == Function::MIN;
+        switch (column.type) {
+        case DataType::INTEGER:
+            return fold(column.integers, nulls, selected, count, groups, counts, result.integers.data(),
+                [least](int64_t& extreme, int64_t value, bool first) {
+                    if (first || (least ? value < extreme : value > extreme))
+                        extreme = value;
+                    return true;
+                });
+        case DataType::FLOAT:
+            return fold(column.floats, nulls, selected, count, groups, counts, result.floats.data(),
+                [least](double& extreme, double value, bool first) {
+                    if (first || (least ? value < extreme : value > extreme))
+                        extreme = value;
+                    return true;
+                });
+        default:
+            return fold(column.strings, nulls, selected, count, groups, counts, result.strings.data(),
+                [least](std::string& extreme, const std::string* value, bool first) {
+                    if (first || (least ? *value < extreme : *value > extreme))
+                        extreme = *value;
+                    return true;
+                });
+        }
+    }
+    }
+}
@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Batch.h"
+#include "Value.h"
+
+/**
+ * @brief The Aggregation class computes aggregate functions over the rows of a table, grouped by some columns.
+ *
+ * Responsibilities:
+ * - Consumes the selected rows of a Batch at a time: the group of every row is found first, then each
+ *   aggregate runs as one loop over its column vector, updating the slot of the row's group.
+ * - Finds groups in an open-addressing hash table (linear probing) keyed on the group columns: a row's key is
+ *   hashed column by column from the vectors, and compared with a group's key (kept per column, natively)
+ *   only when the hashes match. The table is sized once from an estimate of the groups (see reserve()) and
+ *   doubles only if the estimate was short.
+ * - Without group columns, every row belongs to a single group, which exists even if no row does; the
+ *   aggregates are then running totals kept in registers, and no key is hashed.
+ *
+ * Aggregates skip NULL values: COUNT of a column counts the values that are not NULL, and SUM, MIN, MAX and AVG
+ * of a group without any value are NULL. SUM keeps the column type (an INTEGER sum that overflows is an
+ * error); AVG is a FLOAT. A NULL key is a key like any other: the rows whose group column is NULL form a group.
+ *
+ * Usage:
+ * - Construct it with the group columns and the aggregates, reserve() room for the groups expected, add()
+ *   every batch, then read the groups, in the order they first appeared, with getKey() and getResult().
+ */
+class Aggregation {
+public:
+    /**
+     * @brief Enumeration for the aggregate functions.
+     */
+    enum class Function {
+        COUNT_ALL, // COUNT(*): the rows.
+        COUNT,     // The values that are not NULL.
+        SUM,       // INTEGER or FLOAT columns.
+        MIN,
+        MAX,
+        AVG,       // INTEGER or FLOAT columns.
+    };
+
+    /**
+     * @brief One aggregate to compute.
+     */
+    struct Aggregate {
+        Function function = Function::COUNT_ALL;
+        size_t ordinal = 0; // The column (not for COUNT_ALL).
+    };
+
+    /**
+     * @brief Construct an aggregation without any group yet (but the single one, if there is no group column).
+     * @param schema The schema of the table (must outlive the aggregation).
+     * @param groupOrdinals The group columns (none for a single group).
+     * @param aggregates The aggregates; SUM and AVG only of INTEGER and FLOAT columns.
+     */
+    Aggregation(const Schema& schema, const std::vector<size_t>& groupOrdinals, const std::vector<Aggregate>& aggregates);
+
+    /**
+     * @brief Get the group columns.
+     * @return const std::vector<size_t>& The column ordinals.
+     */
+    const std::vector<size_t>& getGroupOrdinals() const;
+
+    /**
+     * @brief Size the hash table for a number of groups, so that it need not grow while they are added.
+     * @param groups The number of groups expected.
+     */
+    void reserve(size_t groups);
+
+    /**
+     * @brief Add the selected rows of a batch to their groups; errors are written to std::cerr.
+     * @param batch The batch.
+     * @return true if the rows were added; false if an INTEGER sum overflowed.
+     */
+    bool add(Batch& batch);
+
+    /**
+     * @brief Get the number of groups.
+     * @return size_t The number of groups.
+     */
+    size_t getGroupCount() const;
+
+    /**
+     * @brief Get the value of a group column for a group.
+     * @param group The group, in the order groups first appeared.
+     * @param column The index of the column in the group columns.
+     * @return Value The value (NULL for the NULL group).
+     */
+    Value getKey(size_t group, size_t column) const;
+
+    /**
+     * @brief Get the result of an aggregate for a group.
+     * @param group The group, in the order groups first appeared.
+     * @param aggregate The index of the aggregate.
+     * @return Value The result (NULL for SUM, MIN, MAX and AVG of no value).
+     */
+    Value getResult(size_t group, size_t aggregate) const;
+
+private:
+    // The values of one group column or aggregate, one slot per group, in the array of their type.
+    struct Slots {
+        DataType type = DataType::INTEGER;
+        std::vector<int64_t> integers;
+        std::vector<double> floats;
+        std::vector<std::string> strings;
+        std::vector<char> nulls;     // Group columns: whether the key is NULL.
+        std::vector<int64_t> counts; // Aggregates: the values counted so far.
+    };
+
+    const Schema& schema;
+    std::vector<size_t> groupOrdinals;
+    std::vector<Aggregate> aggregates;
+    std::vector<Slots> keys;      // One per group column.
+    std::vector<Slots> results;   // One per aggregate.
+    std::vector<uint64_t> hashes; // The hash of each group's key.
+    std::vector<uint32_t> table;  // Group + 1 per slot, 0 if empty; a power of two long.
+    size_t groupCount;
+    std::vector<uint64_t> rowHashes;  // The hash of each selected row of the current batch.
+    std::vector<uint32_t> rowGroups;  // The group of each selected row of the current batch.
+
+    // Set the group of every selected row, adding the groups not seen yet.
+    void group(Batch& batch, const uint16_t* selected, size_t count);
+    // Find the group of a row of the batch (vectors holds its group columns), adding it if it is new.
+    uint32_t findGroup(const std::vector<const ColumnVector*>& vectors, size_t row, uint64_t hash);
+    // Check whether a row of the batch has the key of a group.
+    bool hasKey(uint32_t group, const std::vector<const ColumnVector*>& vectors, size_t row) const;
+    // Append the slots of a new group to every aggregate.
+    void addResults();
+    // Rebuild the hash table with a number of slots.
+    void rehash(size_t slots);
+    // Fold the selected rows into one aggregate; false on an INTEGER overflow.
+    bool accumulate(size_t aggregate, Batch& batch, const uint16_t* selected, size_t count);
+};
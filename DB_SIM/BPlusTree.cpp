@@ -0,0 +1,238 @@
+﻿#include "BPlusTree.h"
+#include <algorithm>
+
+// Maximum number of entries in a leaf and of children in an internal node.
+static const size_t MAX_LEAF_ENTRIES = 64;
+static const size_t MAX_CHILDREN = 64;
+
+// A node is either a leaf (entries are data) or internal (entries[i] is the smallest entry of children[i + 1]).
+struct BPlusTree::Node {
+    bool leaf;
+    std::vector<Entry> entries;
+    std::vector<std::unique_ptr<Node>> children;
+    Node* next; // Next leaf, for ordered iteration.
+
+    explicit Node(bool leaf) : leaf(leaf), next(nullptr) {}
+};
+
+// Order entries by key, then by record position.
+static bool entryLess(const BPlusTree::Entry& a, const BPlusTree::Entry& b) {
+    int cmp = a.key.compare(b.key);
+    return cmp < 0 || (cmp == 0 && a.position < b.position);
+}
+
+//----------------------------------------
+// Cursor Implementation
+//----------------------------------------
+
+BPlusTree::Cursor::Cursor(const Node* leaf, size_t index)
+    : leaf(leaf), index(index)
+{
+    skipExhaustedLeaves();
+}
+
+void BPlusTree::Cursor::skipExhaustedLeaves() {
+    // Leaves may be empty after deletions, so keep moving until an entry is found.
+    while (leaf && index >= leaf->entries.size()) {
+        leaf = leaf->next;
+        index = 0;
+    }
+}
+
+bool BPlusTree::Cursor::valid() const {
+    return leaf != nullptr;
+}
+
+const std::string& BPlusTree::Cursor::key() const {
+    return leaf->entries[index].key;
+}
+
+size_t BPlusTree::Cursor::position() const {
+    return leaf->entries[index].position;
+}
+
+void BPlusTree::Cursor::next() {
+    ++index;
+    skipExhaustedLeaves();
+}
+
+//----------------------------------------
+// BPlusTree Implementation
+//----------------------------------------
+
+BPlusTree::BPlusTree()
+    : root(new Node(true)), firstLeaf(nullptr), count(0)
+{
+    firstLeaf = root.get();
+}
+
+BPlusTree::~BPlusTree() {
+    // Nodes are released by their unique_ptr owners.
+}
+
+BPlusTree::BPlusTree(BPlusTree&& other) noexcept
+    : root(std::move(other.root)), firstLeaf(other.firstLeaf), count(other.count)
+{
+    other.root.reset(new Node(true));
+    other.firstLeaf = other.root.get();
+    other.count = 0;
+}
+
+BPlusTree& BPlusTree::operator=(BPlusTree&& other) noexcept {
+    if (this != &other) {
+        root = std::move(other.root);
+        firstLeaf = other.firstLeaf;
+        count = other.count;
+        other.root.reset(new Node(true));
+        other.firstLeaf = other.root.get();
+        other.count = 0;
+    }
+    return *this;
+}
+
+// Insert into the subtree rooted at node. If the node splits, the new right sibling is returned
+// and 'separator' receives its smallest entry.
+std::unique_ptr<BPlusTree::Node> BPlusTree::insertInto(Node* node, Entry&& entry, Entry& separator) {
+    if (node->leaf) {
+        auto it = std::upper_bound(node->entries.begin(), node->entries.end(), entry, entryLess);
+        node->entries.insert(it, std::move(entry));
+        if (node->entries.size() <= MAX_LEAF_ENTRIES)
+            return nullptr;
+
+        std::unique_ptr<Node> right(new Node(true));
+        size_t mid = node->entries.size() / 2;
+        right->entries.assign(std::make_move_iterator(node->entries.begin() + mid),
+            std::make_move_iterator(node->entries.end()));
+        node->entries.resize(mid);
+        right->next = node->next;
+        node->next = right.get();
+        separator = right->entries.front();
+        return right;
+    }
+
+    size_t childIndex = std::upper_bound(node->entries.begin(), node->entries.end(), entry, entryLess) - node->entries.begin();
+    Entry childSeparator;
+    std::unique_ptr<Node> split = insertInto(node->children[childIndex].get(), std::move(entry), childSeparator);
+    if (!split)
+        return nullptr;
+
+    node->entries.insert(node->entries.begin() + childIndex, std::move(childSeparator));
+    node->children.insert(node->children.begin() + childIndex + 1, std::move(split));
+    if (node->children.size() <= MAX_CHILDREN)
+        return nullptr;
+
+    // Split the internal node; the middle separator moves up to the parent.
+    std::unique_ptr<Node> right(new Node(false));
+    size_t mid = node->children.size() / 2;
+    separator = std::move(node->entries[mid - 1]);
+    right->entries.assign(std::make_move_iterator(node->entries.begin() + mid),
+        std::make_move_iterator(node->entries.end()));
+    right->children.assign(std::make_move_iterator(node->children.begin() + mid),
+        std::make_move_iterator(node->children.end()));
+    node->entries.resize(mid - 1);
+    node->children.resize(mid);
+    return right;
+}
+
+void BPlusTree::insert(const std::string& key, size_t position) {
+    Entry separator;
+    std::unique_ptr<Node> split = insertInto(root.get(), Entry{ key, position }, separator);
+    if (split) {
+        // The root split: grow the tree by one level.
+        std::unique_ptr<Node> newRoot(new Node(false));
+        newRoot->entries.push_back(std::move(separator));
+        newRoot->children.push_back(std::move(root));
+        newRoot->children.push_back(std::move(split));
+        root = std::move(newRoot);
+    }
+    ++count;
+}
+
+// Descend to the leaf that holds (or would hold) the target entry.
+const BPlusTree::Node* BPlusTree::findLeaf(const Entry& target) const {
+    const Node* node = root.get();
+    while (!node->leaf) {
+        size_t childIndex = std::upper_bound(node->entries.begin(), node->entries.end(), target, entryLess) - node->entries.begin();
+        node = node->children[childIndex].get();
+    }
+    return node;
+}
+
+bool BPlusTree::erase(const std::string& key, size_t position) {
+    Entry target{ key, position };
+    Node* leaf = const_cast<Node*>(findLeaf(target));
+    auto it = std::lower_bound(leaf->entries.begin(), leaf->entries.end(), target, entryLess);
+    if (it == leaf->entries.end() || it->position != position || it->key != key)
+        return false;
+    leaf->entries.erase(it);
+    --count;
+    return true;
+}
+
+void BPlusTree::bulkLoad(std::vector<Entry>& entries) {
+    std::sort(entries.begin(), entries.end(), entryLess);
+    count = entries.size();
+
+    // Build the leaf level, linking the leaves together.
+    std::vector<std::unique_ptr<Node>> level;
+    std::vector<Entry> firstEntries; // Smallest entry of each node of the current level.
+    Node* previous = nullptr;
+    for (size_t i = 0; i < entries.size(); i += MAX_LEAF_ENTRIES) {
+        std::unique_ptr<Node> leaf(new Node(true));
+        size_t end = std::min(entries.size(), i + MAX_LEAF_ENTRIES);
+        leaf->entries.assign(std::make_move_iterator(entries.begin() + i), std::make_move_iterator(entries.begin() + end));
+        firstEntries.push_back(leaf->entries.front());
+        if (previous)
+            previous->next = leaf.get();
+        previous = leaf.get();
+        level.push_back(std::move(leaf));
+    }
+    entries.clear();
+
+    if (level.empty()) {
+        clear();
+        return;
+    }
+    firstLeaf = level.front().get();
+
+    // Build the internal levels until a single root remains.
+    while (level.size() > 1) {
+        std::vector<std::unique_ptr<Node>> parents;
+        std::vector<Entry> parentFirstEntries;
+        for (size_t i = 0; i < level.size(); i += MAX_CHILDREN) {
+            std::unique_ptr<Node> parent(new Node(false));
+            size_t end = std::min(level.size(), i + MAX_CHILDREN);
+            for (size_t j = i; j < end; ++j) {
+                if (j > i)
+                    parent->entries.push_back(firstEntries[j]);
+                parent->children.push_back(std::move(level[j]));
+            }
+            parentFirstEntries.push_back(firstEntries[i]);
+            parents.push_back(std::move(parent));
+        }
+        level = std::move(parents);
+        firstEntries = std::move(parentFirstEntries);
+    }
+    root = std::move(level.front());
+}
+
+void BPlusTree::clear() {
+    root.reset(new Node(true));
+    firstLeaf = root.get();
+    count = 0;
+}
+
+BPlusTree::Cursor BPlusTree::begin() const {
+    return Cursor(firstLeaf, 0);
+}
+
+BPlusTree::Cursor BPlusTree::lowerBound(const std::string& key) const {
+    Entry target{ key, 0 };
+    const Node* leaf = findLeaf(target);
+    size_t index = std::lower_bound(leaf->entries.begin(), leaf->entries.end(), target, entryLess) - leaf->entries.begin();
+    return Cursor(leaf, index);
+}
+
+size_t BPlusTree::size() const {
+    return count;
+}
@@ -0,0 +1,141 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+/**
+ * @brief The BPlusTree class is an in-memory B+tree of (key, record position) entries.
+ *
+ * Responsibilities:
+ * - Keeps entries ordered by key (byte-wise) and then by record position, so duplicate keys are allowed.
+ * - Provides ordered iteration through linked leaves, starting anywhere via lowerBound().
+ *
+ * Notes:
+ * - Keys are opaque byte strings; callers encode typed values so that byte order equals value order.
+ * - Deletion removes entries from their leaf without merging nodes; rebuild with bulkLoad() to compact.
+ *
+ * Usage:
+ * - Use insert()/erase() to maintain entries, and begin()/lowerBound() to obtain a Cursor.
+ */
+class BPlusTree {
+public:
+    /**
+     * @brief A single entry of the tree.
+     */
+    struct Entry {
+        std::string key;
+        size_t position;
+    };
+
+private:
+    struct Node;
+
+public:
+    /**
+     * @brief A forward cursor over the entries of the tree, in order.
+     */
+    class Cursor {
+    public:
+        /**
+         * @brief Check whether the cursor points at an entry.
+         * @return true if valid; false once past the last entry.
+         */
+        bool valid() const;
+
+        /**
+         * @brief Get the key of the current entry.
+         * @return const std::string& The encoded key.
+         */
+        const std::string& key() const;
+
+        /**
+         * @brief Get the record position of the current entry.
+         * @return size_t The record position.
+         */
+        size_t position() const;
+
+        /**
+         * @brief Advance to the next entry.
+         */
+        void next();
+
+    private:
+        friend class BPlusTree;
+        Cursor(const Node* leaf, size_t index);
+        void skipExhaustedLeaves();
+
+        const Node* leaf;
+        size_t index;
+    };
+
+    /**
+     * @brief Construct an empty BPlusTree object.
+     */
+    BPlusTree();
+
+    /**
+     * @brief Destroy the BPlusTree object.
+     */
+    ~BPlusTree();
+
+    BPlusTree(BPlusTree&& other) noexcept;
+    BPlusTree& operator=(BPlusTree&& other) noexcept;
+
+    /**
+     * @brief Insert an entry.
+     * @param key The encoded key.
+     * @param position The record position.
+     */
+    void insert(const std::string& key, size_t position);
+
+    /**
+     * @brief Remove an entry.
+     * @param key The encoded key.
+     * @param position The record position.
+     * @return true if the entry was found and removed; false otherwise.
+     */
+    bool erase(const std::string& key, size_t position);
+
+    /**
+     * @brief Replace the content of the tree with the given entries, building it bottom-up.
+     * @param entries The entries (sorted in place).
+     */
+    void bulkLoad(std::vector<Entry>& entries);
+
+    /**
+     * @brief Remove all entries.
+     */
+    void clear();
+
+    /**
+     * @brief Get a cursor on the first entry.
+     * @return Cursor The cursor.
+     */
+    Cursor begin() const;
+
+    /**
+     * @brief Get a cursor on the first entry whose key is not less than the given key.
+     * @param key The encoded key.
+     * @return Cursor The cursor.
+     */
+    Cursor lowerBound(const std::string& key) const;
+
+    /**
+     * @brief Get the number of entries.
+     * @return size_t The number of entries.
+     */
+    size_t size() const;
+
+private:
+    std::unique_ptr<Node> root;
+    Node* firstLeaf;
+    size_t count;
+
+    std::unique_ptr<Node> insertInto(Node* node, Entry&& entry, Entry& separator);
+    const Node* findLeaf(const Entry& target) const;
+
+    // Disable copying.
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+};
@@ -0,0 +1,322 @@
+﻿#include "Batch.h"
+#include "FilterKernels.h"
+#include "Schema.h"
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+
+// Keep the selected values that are not NULL and satisfy a predicate, narrowing the selection in place.
+// The loops do not branch on the outcome: every index is written and only the kept ones are counted (the
+// slot of a NULL holds a placeholder, so testing it is harmless).
+template <bool Dense, typename Get, typename Match>
+static size_t keep(const uint64_t* nulls, uint16_t* selected, size_t selectedCount, Get get, Match match) {
+    size_t kept = 0;
+    if (Dense) {
+        // The selection is every row of the batch: values are read in order, a word of the bitmap at a time.
+        for (size_t word = 0; word * 64 < selectedCount; ++word) {
+            uint64_t valid = ~nulls[word];
+            size_t end = std::min(selectedCount, word * 64 + 64);
+            for (size_t i = word * 64; i < end; ++i) {
+                selected[kept] = static_cast<uint16_t>(i);
+                kept += static_cast<size_t>((valid >> (i & 63)) & 1) & static_cast<size_t>(match(get(i)));
+            }
+        }
+        return kept;
+    }
+    for (size_t k = 0; k < selectedCount; ++k) {
+        size_t i = selected[k];
+        selected[kept] = static_cast<uint16_t>(i);
+        kept += static_cast<size_t>(~(nulls[i >> 6] >> (i & 63)) & 1) & static_cast<size_t>(match(get(i)));
+    }
+    return kept;
+}
+
+// Choose the loop for a node once per batch: by its kind and operator, then by the density of the selection.
+template <typename T, typename Get>
+static size_t keepValues(const Predicate::Node& node, const std::vector<T>& bounds, bool dense, const uint64_t* nulls,
+    uint16_t* selected, size_t selectedCount, Get get) {
+    auto run = [&](auto match) {
+        return dense ? keep<true>(nulls, selected, selectedCount, get, match)
+            : keep<false>(nulls, selected, selectedCount, get, match);
+    };
+    if (node.kind == Predicate::Kind::BETWEEN) {
+        const T& low = bounds[0];
+        const T& high = bounds[1];
+        return run([&low, &high](const T& v) { return !(v < low) && !(high < v); });
+    }
+    if (node.kind == Predicate::Kind::IN) {
+        bool negated = node.negated;
+        return run([&bounds, negated](const T& v) { return std::binary_search(bounds.begin(), bounds.end(), v) != negated; });
+    }
+    const T& bound = bounds[0];
+    switch (node.op) {
+    case Predicate::Op::EQUAL: return run([&bound](const T& v) { return v == bound; });
+    case Predicate::Op::NOT_EQUAL: return run([&bound](const T& v) { return v != bound; });
+    case Predicate::Op::LESS: return run([&bound](const T& v) { return v < bound; });
+    case Predicate::Op::LESS_EQUAL: return run([&bound](const T& v) { return v <= bound; });
+    case Predicate::Op::GREATER: return run([&bound](const T& v) { return v > bound; });
+    default: return run([&bound](const T& v) { return v >= bound; });
+    }
+}
+
+static void toNative(const Value& value, int64_t& native) {
+    native = value.getInteger();
+}
+
+static void toNative(const Value& value, double& native) {
+    native = value.getFloat();
+}
+
+static void toNative(const Value& value, std::string& native) {
+    native = value.getString();
+}
+
+// The values of a node as the native type of its column (in the same order, so an IN list stays sorted).
+template <typename T>
+static std::vector<T> nativeBounds(const Predicate::Node& node) {
+    std::vector<T> bounds(node.values.size());
+    for (size_t i = 0; i < bounds.size(); ++i)
+        toNative(node.values[i], bounds[i]);
+    return bounds;
+}
+
+Batch::Batch(const TableStorage& storage, const Schema& schema)
+    : storage(storage), schema(schema), begin(0), rows(nullptr), count(0) {
+    const auto& schemaColumns = schema.getColumns();
+    columns.resize(schemaColumns.size());
+    for (size_t i = 0; i < columns.size(); ++i)
+        columns[i].type = schemaColumns[i].getType();
+    loaded.assign(columns.size(), 0);
+    selection.reserve(SIZE);
+}
+
+void Batch::readRange(size_t first, size_t rowCount) {
+    begin = first;
+    rows = nullptr;
+    count = rowCount;
+    selection.resize(count);
+    std::iota(selection.begin(), selection.end(), static_cast<uint16_t>(0));
+    std::fill(loaded.begin(), loaded.end(), 0);
+}
+
+void Batch::readRows(const size_t* positions, size_t rowCount) {
+    begin = 0;
+    rows = positions;
+    count = rowCount;
+    selection.resize(count);
+    std::iota(selection.begin(), selection.end(), static_cast<uint16_t>(0));
+    std::fill(loaded.begin(), loaded.end(), 0);
+}
+
+size_t Batch::getSelectedCount() const {
+    return selection.size();
+}
+
+const std::vector<uint16_t>& Batch::getSelection() const {
+    return selection;
+}
+
+const ColumnVector& Batch::getColumn(size_t ordinal) {
+    if (!loaded[ordinal]) {
+        if (rows)
+            storage.gatherColumn(ordinal, rows, count, columns[ordinal]);
+        else
+            storage.readColumn(ordinal, begin, count, columns[ordinal]);
+        loaded[ordinal] = 1;
+    }
+    return columns[ordinal];
+}
+
+void Batch::filter(const Predicate::Node& node) {
+    selection.resize(filter(node, selection.data(), selection.size()));
+}
+
+size_t Batch::filter(const Predicate::Node& node, uint16_t* selected, size_t selectedCount) {
+    bool dense = selectedCount == count;
+    if (dense && isMaskable(node)) {
+        uint64_t bits[SIZE / 64];
+        mask(node, bits);
+        return FilterKernels::toSelection(bits, count, selected);
+    }
+    switch (node.kind) {
+    case Predicate::Kind::ALL:
+        return selectedCount;
+    case Predicate::Kind::NONE:
+        return 0;
+    case Predicate::Kind::AND: {
+        // While every row is selected, the operands that can be tested as bits go first, combined in one mask.
+        bool masked = false;
+        if (dense) {
+            uint64_t bits[SIZE / 64];
+            uint64_t operand[SIZE / 64];
+            for (const auto& child : node.children) {
+                if (!isMaskable(child))
+                    continue;
+                mask(child, masked ? operand : bits);
+                if (masked) {
+                    for (size_t word = 0; word * 64 < count; ++word)
+                        bits[word] &= operand[word];
+                }
+                masked = true;
+            }
+            if (masked)
+                selectedCount = FilterKernels::toSelection(bits, count, selected);
+        }
+        for (const auto& child : node.children) {
+            if (selectedCount == 0)
+                break;
+            if (!(masked && isMaskable(child)))
+                selectedCount = filter(child, selected, selectedCount);
+        }
+        return selectedCount;
+    }
+    case Predicate::Kind::OR: {
+        // Every operand is tested on the whole selection, which keeps a dense selection on the dense loops
+        // (cheaper than the scattered reads of testing only the rows not matched yet); matches are flagged.
+        uint16_t hits[SIZE];
+        uint8_t matched[SIZE] = {};
+        for (const auto& child : node.children) {
+            std::copy(selected, selected + selectedCount, hits);
+            size_t hitCount = filter(child, hits, selectedCount);
+            for (size_t k = 0; k < hitCount; ++k)
+                matched[hits[k]] = 1;
+        }
+        size_t kept = 0;
+        for (size_t k = 0; k < selectedCount; ++k) {
+            uint16_t i = selected[k];
+            selected[kept] = i;
+            kept += matched[i];
+        }
+        return kept;
+    }
+    default:
+        break;
+    }
+
+    const ColumnVector& column = getColumn(node.ordinal);
+    const uint64_t* nulls = column.nulls;
+    if (node.kind == Predicate::Kind::IS_NULL || node.kind == Predicate::Kind::IS_NOT_NULL) {
+        uint64_t wanted = node.kind == Predicate::Kind::IS_NULL ? 1 : 0;
+        size_t kept = 0;
+        for (size_t k = 0; k < selectedCount; ++k) {
+            size_t i = dense ? k : selected[k];
+            selected[kept] = static_cast<uint16_t>(i);
+            kept += ((nulls[i >> 6] >> (i & 63)) & 1) == wanted;
+        }
+        return kept;
+    }
+    switch (column.type) {
+    case DataType::INTEGER: {
+        const int64_t* values = column.integers;
+        return keepValues(node, nativeBounds<int64_t>(node), dense, nulls, selected, selectedCount,
+            [values](size_t i) { return values[i]; });
+    }
+    case DataType::FLOAT: {
+        const double* values = column.floats;
+        return keepValues(node, nativeBounds<double>(node), dense, nulls, selected, selectedCount,
+            [values](size_t i) { return values[i]; });
+    }
+    default: {
+        const std::string* const* values = column.strings;
+        return keepValues(node, nativeBounds<std::string>(node), dense, nulls, selected, selectedCount,
+            [values](size_t i) -> const std::string& { return *values[i]; });
+    }
+    }
+}
+
+bool Batch::isMaskable(const Predicate::Node& node) const {
+    switch (node.kind) {
+    case Predicate::Kind::COMPARE:
+    case Predicate::Kind::BETWEEN:
+        return columns[node.ordinal].type != DataType::STRING;
+    case Predicate::Kind::IS_NULL:
+    case Predicate::Kind::IS_NOT_NULL:
+        return true;
+    case Predicate::Kind::AND:
+    case Predicate::Kind::OR:
+        return std::all_of(node.children.begin(), node.children.end(),
+            [this](const Predicate::Node& child) { return isMaskable(child); });
+    default:
+        return false;
+    }
+}
+
+void Batch::mask(const Predicate::Node& node, uint64_t* bits) {
+    size_t words = (count + 63) / 64;
+    if (node.kind == Predicate::Kind::AND || node.kind == Predicate::Kind::OR) {
+        bool conjunction = node.kind == Predicate::Kind::AND;
+        uint64_t operand[SIZE / 64];
+        mask(node.children[0], bits);
+        for (size_t i = 1; i < node.children.size(); ++i) {
+            mask(node.children[i], operand);
+            for (size_t word = 0; word < words; ++word)
+                bits[word] = conjunction ? bits[word] & operand[word] : bits[word] | operand[word];
+        }
+        return;
+    }
+    const ColumnVector& column = getColumn(node.ordinal);
+    const uint64_t* nulls = column.nulls;
+    if (node.kind == Predicate::Kind::IS_NULL || node.kind == Predicate::Kind::IS_NOT_NULL) {
+        uint64_t flip = node.kind == Predicate::Kind::IS_NULL ? 0 : ~uint64_t(0);
+        for (size_t word = 0; word < words; ++word)
+            bits[word] = nulls[word] ^ flip;
+        // The bitmap may go on past the batch.
+        if (count % 64 != 0)
+            bits[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+        return;
+    }
+    if (column.type == DataType::INTEGER) {
+        if (node.kind == Predicate::Kind::BETWEEN)
+            FilterKernels::between(column.integers, count, node.values[0].getInteger(), node.values[1].getInteger(), bits);
+        else
+            FilterKernels::compare(column.integers, count, node.op, node.values[0].getInteger(), bits);
+    }
+    else {
+        if (node.kind == Predicate::Kind::BETWEEN)
+            FilterKernels::between(column.floats, count, node.values[0].getFloat(), node.values[1].getFloat(), bits);
+        else
+            FilterKernels::compare(column.floats, count, node.op, node.values[0].getFloat(), bits);
+    }
+    // The slot of a NULL holds a placeholder, which the kernel may have matched.
+    for (size_t word = 0; word < words; ++word)
+        bits[word] &= ~nulls[word];
+}
+
+void Batch::appendPositions(std::vector<size_t>& positions) const {
+    size_t base = positions.size();
+    positions.resize(base + selection.size());
+    size_t* out = positions.data() + base;
+    if (rows) {
+        for (size_t k = 0; k < selection.size(); ++k)
+            out[k] = rows[selection[k]];
+    }
+    else {
+        for (size_t k = 0; k < selection.size(); ++k)
+            out[k] = begin + selection[k];
+    }
+}
+
+void Batch::format(const std::vector<size_t>& ordinals, std::string& text) {
+    const auto& schemaColumns = schema.getColumns();
+    std::vector<const ColumnVector*> vectors;
+    for (size_t ordinal : ordinals)
+        vectors.push_back(&getColumn(ordinal));
+    char digits[24];
+    for (uint16_t i : selection) {
+        for (size_t j = 0; j < ordinals.size(); ++j) {
+            const ColumnVector& column = *vectors[j];
+            text += schemaColumns[ordinals[j]].getName();
+            text += ": ";
+            if ((column.nulls[i >> 6] >> (i & 63)) & 1)
+                text += "NULL";
+            else if (column.type == DataType::INTEGER)
+                text.append(digits, std::to_chars(digits, digits + sizeof(digits), column.integers[i]).ptr);
+            else if (column.type == DataType::FLOAT)
+                text += Value(column.floats[i]).toString();
+            else
+                text += *column.strings[i];
+            text += " | ";
+        }
+        text += '\n';
+    }
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Predicate.h"
+#include "TableStorage.h"
+
+/**
+ * @brief The Batch class runs the operators of a query over up to SIZE rows of a table at a time.
+ *
+ * Responsibilities:
+ * - Reads the columns a query touches as typed column vectors (see ColumnVector), each at most once per
+ *   batch: a columnar table's arrays are used in place, a row table's values are gathered.
+ * - Keeps the rows still selected in a selection vector (their indexes in the batch, ascending). A filter
+ *   narrows it with one tight loop per comparison over a typed array, dispatched on the column type and the
+ *   operator once per batch rather than once per row: AND narrows it operand by operand, and OR unions what
+ *   each operand keeps of it.
+ * - While every row is selected, compares INTEGER and FLOAT columns (=, <>, <, <=, >, >=, BETWEEN) and tests
+ *   NULL with the SIMD kernels of FilterKernels, one bit per row; the bits of the operands of AND and OR are
+ *   combined word by word, and only the result becomes a selection vector.
+ * - Projects the selected rows, formatting the values of each column straight from its vector.
+ *
+ * Usage:
+ * - Construct it over a table's storage and schema, then call readRange() for each run of rows to scan (or
+ *   readRows() for rows found otherwise), filter() with a bound predicate and collect the rows still selected
+ *   with appendPositions() or format(), or read them with getSelection() and getColumn().
+ */
+class Batch {
+public:
+    /**
+     * @brief The most rows a batch holds.
+     */
+    static const size_t SIZE = 1024;
+
+    /**
+     * @brief Construct an empty batch.
+     * @param storage The rows of the table (must outlive the batch).
+     * @param schema The schema of the table, giving the type of every column.
+     */
+    Batch(const TableStorage& storage, const Schema& schema);
+
+    /**
+     * @brief Make the batch consecutive rows, all selected.
+     * @param begin The first row.
+     * @param count The number of rows (at most SIZE).
+     */
+    void readRange(size_t begin, size_t count);
+
+    /**
+     * @brief Make the batch the given rows, all selected.
+     * @param rows The row positions (must outlive the batch's use of them).
+     * @param count The number of rows (at most SIZE).
+     */
+    void readRows(const size_t* rows, size_t count);
+
+    /**
+     * @brief Get the number of rows still selected.
+     * @return size_t The number of rows.
+     */
+    size_t getSelectedCount() const;
+
+    /**
+     * @brief Get the rows still selected, as their indexes in the batch (ascending).
+     * @return const std::vector<uint16_t>& The indexes.
+     */
+    const std::vector<uint16_t>& getSelection() const;
+
+    /**
+     * @brief Get a column of the rows of the batch, reading it the first time it is asked for.
+     * @param ordinal The column ordinal.
+     * @return const ColumnVector& The column, indexed like the rows of the batch (valid until the next read).
+     */
+    const ColumnVector& getColumn(size_t ordinal);
+
+    /**
+     * @brief Keep selected only the rows that match a node of a bound predicate.
+     * @param node The node.
+     */
+    void filter(const Predicate::Node& node);
+
+    /**
+     * @brief Append the positions of the selected rows, in ascending order of their index in the batch.
+     * @param positions The positions to append to.
+     */
+    void appendPositions(std::vector<size_t>& positions) const;
+
+    /**
+     * @brief Format the selected rows, one line per row, as "name: value | " for each projected column.
+     * @param ordinals The projected column ordinals.
+     * @param text The text to append to.
+     */
+    void format(const std::vector<size_t>& ordinals, std::string& text);
+
+private:
+    const TableStorage& storage;
+    const Schema& schema;
+    size_t begin;
+    const size_t* rows; // The rows of readRows(), or nullptr for a range.
+    size_t count;
+    std::vector<uint16_t> selection;
+    std::vector<ColumnVector> columns;
+    std::vector<char> loaded; // Whether each column has been read for the current rows.
+
+    // Narrow a selection to the rows matching a node; returns the number kept.
+    size_t filter(const Predicate::Node& node, uint16_t* selected, size_t selectedCount);
+    // Whether a node can be tested as bits over the whole batch.
+    bool isMaskable(const Predicate::Node& node) const;
+    // Set the bits of the rows of the batch matching a maskable node, SIZE / 64 words at most.
+    void mask(const Predicate::Node& node, uint64_t* bits);
+};
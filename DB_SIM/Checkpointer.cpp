@@ -0,0 +1,68 @@
+﻿#include "Checkpointer.h"
+
+#include <chrono>
+
+Checkpointer::Checkpointer()
+    : interval(0), logSize(0), stopping(false), requested(false)
+{
+}
+
+Checkpointer::~Checkpointer() {
+    stop();
+}
+
+void Checkpointer::start(unsigned interval, uint64_t logSize, Task task) {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    this->interval = interval;
+    this->logSize = logSize;
+    this->task = std::move(task);
+    if (interval == 0 && logSize == 0)
+        return;
+    stopping = false;
+    requested = false;
+    worker = std::thread(&Checkpointer::run, this);
+}
+
+void Checkpointer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+bool Checkpointer::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return worker.joinable() && !stopping;
+}
+
+void Checkpointer::notifyLogSize(uint64_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (logSize == 0 || size < logSize || requested || stopping || !worker.joinable())
+        return;
+    requested = true;
+    wake.notify_all();
+}
+
+void Checkpointer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        auto due = [this] { return stopping || requested; };
+        if (interval > 0)
+            wake.wait_for(lock, std::chrono::milliseconds(interval), due);
+        else
+            wake.wait(lock, due);
+        if (stopping)
+            break;
+
+        // Statements go on while the checkpoint is written; the ones that push the log past its limit
+        // meanwhile are covered by it, or request the next one once it is done.
+        lock.unlock();
+        task();
+        lock.lock();
+        requested = false;
+    }
+}
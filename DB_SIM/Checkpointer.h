@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @brief The Checkpointer class runs checkpoints on a background thread.
+ *
+ * Responsibilities:
+ * - Runs the checkpoint task once per interval, and as soon as the write-ahead log reaches a size limit.
+ * - Runs one checkpoint at a time, off the thread that executes statements; the task itself captures
+ *   what to write between two statements and decides whether anything changed.
+ *
+ * Usage:
+ * - start() with the triggers and the task; stop() (or the destructor) waits for a running checkpoint to end.
+ * - Report the size of the log with notifyLogSize() after appending to it.
+ */
+class Checkpointer {
+public:
+    /**
+     * @brief Takes one checkpoint; runs on the background thread.
+     */
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Construct a new Checkpointer object, stopped.
+     */
+    Checkpointer();
+
+    /**
+     * @brief Destroy the Checkpointer object, stopping the thread.
+     */
+    ~Checkpointer();
+
+    /**
+     * @brief Start (or restart) the background thread; it stays stopped if neither trigger is set.
+     * @param interval The time between two checkpoints, in milliseconds (0 for none).
+     * @param logSize The log size that triggers a checkpoint, in bytes (0 for none).
+     * @param task Takes one checkpoint.
+     */
+    void start(unsigned interval, uint64_t logSize, Task task);
+
+    /**
+     * @brief Stop the background thread, waiting for a running checkpoint to end.
+     *
+     * Must not be called while holding a lock the task takes.
+     */
+    void stop();
+
+    /**
+     * @brief Check whether the background thread is running.
+     * @return true if checkpoints are taken in the background; false otherwise.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Report the size of the log, waking the thread if it reached the size limit.
+     * @param size The size of the log file in bytes.
+     */
+    void notifyLogSize(uint64_t size);
+
+private:
+    Task task;
+    unsigned interval;
+    uint64_t logSize;
+
+    std::thread worker;
+    bool stopping;
+    bool requested; // The log reached its size limit since the last checkpoint.
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    // The body of the background thread.
+    void run();
+
+    // Disable copying.
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+};
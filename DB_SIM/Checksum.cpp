@@ -0,0 +1,188 @@
+﻿#include "Checksum.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CHECKSUM_SSE42 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC accepts the SSE4.2 intrinsics in any function.
+#define TARGET_SSE42
+#else
+// GCC and Clang compile the intrinsics only in functions that target SSE4.2; the build itself may not.
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace Checksum {
+
+    // The reflected Castagnoli polynomial.
+    static const uint32_t POLYNOMIAL = 0x82F63B78u;
+
+    // Multiply two polynomials modulo the polynomial, in the reflected bit order (x^0 is the top bit).
+    static uint32_t multiply(uint32_t a, uint32_t b) {
+        uint32_t product = 0;
+        for (int i = 0; i < 32; ++i) {
+            if (a & 0x80000000u)
+                product ^= b;
+            a <<= 1;
+            b = (b >> 1) ^ (POLYNOMIAL & (0u - (b & 1)));
+        }
+        return product;
+    }
+
+    // Compute x^(8 * bytes) modulo the polynomial: the operator that appends that many zero bytes to a register.
+    static uint32_t zeros(uint64_t bytes) {
+        uint32_t result = 0x80000000u; // x^0
+        uint32_t square = 0x00800000u; // x^8
+        for (; bytes != 0; bytes >>= 1) {
+            if (bytes & 1)
+                result = multiply(result, square);
+            square = multiply(square, square);
+        }
+        return result;
+    }
+
+    // Slicing-by-8 tables: entries[k][b] is the register after byte b followed by k zero bytes.
+    struct Table {
+        uint32_t entries[8][256];
+
+        Table() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+                entries[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int k = 1; k < 8; ++k)
+                    entries[k][i] = (entries[k - 1][i] >> 8) ^ entries[0][entries[k - 1][i] & 0xFF];
+            }
+        }
+    };
+
+    static uint32_t software(uint32_t crc, const unsigned char* p, size_t size) {
+        static const Table table;
+        const auto& t = table.entries;
+        while (size >= 8) {
+            // The register is little-endian, like the data.
+            uint32_t low = crc ^ (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8
+                | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24);
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+                ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+            crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+#ifdef CHECKSUM_SSE42
+    // Block sizes of the interleaved streams: long blocks for bulk data, short ones for what is left of it.
+    static const size_t LONG_BLOCK = 8192;
+    static const size_t SHORT_BLOCK = 256;
+
+    // Appends a fixed number of zero bytes to a register, one table lookup per register byte.
+    struct Shift {
+        uint32_t entries[4][256];
+
+        explicit Shift(size_t bytes) {
+            uint32_t op = zeros(bytes);
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int k = 0; k < 4; ++k)
+                    entries[k][i] = multiply(i << (8 * k), op);
+            }
+        }
+
+        uint32_t operator()(uint32_t crc) const {
+            return entries[0][crc & 0xFF] ^ entries[1][(crc >> 8) & 0xFF] ^ entries[2][(crc >> 16) & 0xFF]
+                ^ entries[3][crc >> 24];
+        }
+    };
+
+    static bool detectSse42() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+    }
+
+    static inline uint64_t load64(const unsigned char* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // Run three independent streams of a block each, so that the instruction's latency is hidden, then join them.
+    TARGET_SSE42 static uint32_t hardwareBlocks(uint32_t crc, const unsigned char*& p, size_t& size, size_t block,
+        const Shift& shift) {
+        while (size >= 3 * block) {
+            uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+            const unsigned char* end = p + block;
+            do {
+                crc0 = _mm_crc32_u64(crc0, load64(p));
+                crc1 = _mm_crc32_u64(crc1, load64(p + block));
+                crc2 = _mm_crc32_u64(crc2, load64(p + 2 * block));
+                p += 8;
+            } while (p < end);
+            crc = shift(static_cast<uint32_t>(crc0)) ^ static_cast<uint32_t>(crc1);
+            crc = shift(crc) ^ static_cast<uint32_t>(crc2);
+            p += 2 * block;
+            size -= 3 * block;
+        }
+        return crc;
+    }
+
+    TARGET_SSE42 static uint32_t hardware(uint32_t crc, const unsigned char* p, size_t size) {
+        static const Shift longShift(LONG_BLOCK);
+        static const Shift shortShift(SHORT_BLOCK);
+        // Align to 8 bytes for the 64-bit steps.
+        while (size > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+            crc = _mm_crc32_u8(crc, *p++);
+            --size;
+        }
+        crc = hardwareBlocks(crc, p, size, LONG_BLOCK, longShift);
+        crc = hardwareBlocks(crc, p, size, SHORT_BLOCK, shortShift);
+        uint64_t crc64 = crc;
+        while (size >= 8) {
+            crc64 = _mm_crc32_u64(crc64, load64(p));
+            p += 8;
+            size -= 8;
+        }
+        crc = static_cast<uint32_t>(crc64);
+        while (size-- > 0)
+            crc = _mm_crc32_u8(crc, *p++);
+        return crc;
+    }
+#endif
+
+    bool isHardwareAccelerated() {
+#ifdef CHECKSUM_SSE42
+        static const bool supported = detectSse42();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+#ifdef CHECKSUM_SSE42
+        if (isHardwareAccelerated())
+            return ~hardware(~crc, p, size);
+#endif
+        return ~software(~crc, p, size);
+    }
+
+    uint32_t combine(uint32_t first, uint32_t second, uint64_t secondSize) {
+        // The inversions before and after each checksum cancel out, so the registers combine like raw ones.
+        return multiply(first, zeros(secondSize)) ^ second;
+    }
+
+} // namespace Checksum
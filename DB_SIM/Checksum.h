@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief The Checksum namespace computes the checksums that protect data written to disk.
+ *
+ * Usage:
+ * - crc32c() computes the CRC-32C (Castagnoli) of a buffer; pass the previous result to continue a
+ *   checksum over data that arrives in pieces.
+ * - combine() joins the checksums of two adjacent pieces computed separately (e.g. on different threads).
+ *
+ * On x86-64 processors with SSE4.2 the checksum is computed by the CRC32 instruction over three interleaved
+ * streams, which runs at several bytes per cycle; elsewhere a slicing-by-8 table implementation is used.
+ * Both give the same result.
+ */
+namespace Checksum {
+
+    /**
+     * @brief Compute the CRC-32C of a buffer.
+     * @param data The data.
+     * @param size The size of the data in bytes.
+     * @param crc The checksum of the data that precedes this buffer (0 to start a new checksum).
+     * @return uint32_t The checksum of all the data so far.
+     */
+    uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+    /**
+     * @brief Compute the CRC-32C of two adjacent pieces of data from their own checksums.
+     * @param first The checksum of the first piece.
+     * @param second The checksum of the second piece.
+     * @param secondSize The size of the second piece in bytes.
+     * @return uint32_t The checksum of the first piece followed by the second.
+     */
+    uint32_t combine(uint32_t first, uint32_t second, uint64_t secondSize);
+
+    /**
+     * @brief Check whether the checksum is computed by a processor instruction.
+     * @return true if the hardware implementation is in use; false otherwise.
+     */
+    bool isHardwareAccelerated();
+
+} // namespace Checksum
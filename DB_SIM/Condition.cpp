@@ -0,0 +1,66 @@
+﻿#include "Condition.h"
+
+bool Literal::toValue(DataType type, Value& value) const {
+    if (kind == Kind::NULL_VALUE) {
+        value = Value();
+        return true;
+    }
+    return Value::convert(type, text, value);
+}
+
+std::string Literal::toString() const {
+    switch (kind) {
+    case Kind::NULL_VALUE:
+        return "NULL";
+    case Kind::NUMBER:
+        return text;
+    default: {
+        // Quote the string, doubling any apostrophe inside it.
+        std::string quoted = "'";
+        for (char c : text) {
+            quoted += c;
+            if (c == '\'')
+                quoted += '\'';
+        }
+        quoted += '\'';
+        return quoted;
+    }
+    }
+}
+
+bool Condition::matchesAll() const {
+    return kind == Kind::ALL;
+}
+
+std::string Condition::toString() const {
+    switch (kind) {
+    case Kind::ALL:
+        return "";
+    case Kind::COMPARE:
+        return column + " " + op + " " + values[0].toString();
+    case Kind::BETWEEN:
+        return column + (negated ? " NOT BETWEEN " : " BETWEEN ") + values[0].toString() + " AND " + values[1].toString();
+    case Kind::IN: {
+        std::string text = column + (negated ? " NOT IN (" : " IN (");
+        for (size_t i = 0; i < values.size(); ++i)
+            text += (i > 0 ? ", " : "") + values[i].toString();
+        return text + ")";
+    }
+    case Kind::IS_NULL:
+        return column + (negated ? " IS NOT NULL" : " IS NULL");
+    case Kind::NOT:
+        return "NOT (" + children[0].toString() + ")";
+    default: {
+        // AND binds tighter than OR: an OR inside an AND (or either inside the other) is parenthesized.
+        std::string text;
+        for (size_t i = 0; i < children.size(); ++i) {
+            const Condition& child = children[i];
+            bool nested = child.kind == Kind::AND || child.kind == Kind::OR;
+            if (i > 0)
+                text += kind == Kind::AND ? " AND " : " OR ";
+            text += nested ? "(" + child.toString() + ")" : child.toString();
+        }
+        return text;
+    }
+    }
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include "Value.h"
+
+/**
+ * @brief A literal value as written in a query: NULL, a number or a quoted string.
+ *
+ * The literal is untyped until it meets a column: toValue() converts it to the column's type,
+ * so that '30' and 30 both fit an INTEGER column while the unquoted keyword NULL is always NULL.
+ */
+struct Literal {
+    enum class Kind {
+        NULL_VALUE,
+        NUMBER,
+        STRING,
+    };
+
+    Kind kind = Kind::NULL_VALUE;
+    std::string text; // The number as written, or the string without quotes.
+
+    /**
+     * @brief Convert the literal to a value of a column's type.
+     * @param type The data type of the column.
+     * @param value Receives the converted value.
+     * @return true if the literal is valid for the type; false otherwise.
+     */
+    bool toValue(DataType type, Value& value) const;
+
+    /**
+     * @brief Format the literal as SQL text (strings quoted, NULL as the keyword).
+     * @return std::string The SQL text.
+     */
+    std::string toString() const;
+};
+
+/**
+ * @brief A WHERE condition as written in a query: comparisons of columns with literals, joined by AND, OR
+ * and NOT.
+ *
+ * The tree is untyped, like its literals: Predicate binds it to the columns of a table. A condition of kind
+ * ALL matches every record (no WHERE clause).
+ */
+struct Condition {
+    enum class Kind {
+        ALL,     // No WHERE clause.
+        COMPARE, // column op value
+        BETWEEN, // column [NOT] BETWEEN low AND high
+        IN,      // column [NOT] IN (value, ...)
+        IS_NULL, // column IS [NOT] NULL
+        AND,
+        OR,
+        NOT,
+    };
+
+    Kind kind = Kind::ALL;
+    std::string column;
+    std::string op;                  // COMPARE: "=", "<>", "<", "<=", ">" or ">=".
+    std::vector<Literal> values;     // COMPARE: the value; BETWEEN: the low and high bounds; IN: the list.
+    bool negated = false;            // NOT BETWEEN, NOT IN or IS NOT NULL.
+    std::vector<Condition> children; // AND, OR: the operands; NOT: the negated condition.
+
+    /**
+     * @brief Check whether the condition matches every record.
+     * @return true if there is no WHERE clause; false otherwise.
+     */
+    bool matchesAll() const;
+
+    /**
+     * @brief Format the condition as SQL text.
+     * @return std::string The SQL text, or an empty string if the condition matches every record.
+     */
+    std::string toString() const;
+};
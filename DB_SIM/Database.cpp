@@ -2,6 +2,14 @@
 #include "Table.h"
 #include "Record.h"
 #include "Utility.h"
+#include "Logger.h"
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include "Encoding.h"
+#include "EncryptionHelper.h"
+#include "Parallel.h"
+#include "Batch.h"
+#include "Aggregation.h"
 
 #include <fstream>
 #include <sstream>
@@ -10,35 +18,108 @@
 #include <algorithm>
 #include <cctype>
 #include <vector>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <filesystem>
 
 using namespace Utility;
+using namespace Encoding;
 
+// Operation codes of the write-ahead log records; each is followed by the arguments of the matching function.
+// Codes 1, 7 and 8 were operations of older logs, which are no longer read.
+enum class LogOperation : uint8_t {
+    DROP_TABLE = 2,
+    CREATE_INDEX = 3,
+    DROP_INDEX = 4,
+    DROP_COLUMN = 5,
+    INSERT = 6,
+    CREATE_TABLE = 9,
+    UPDATE = 10,
+    DELETE_FROM = 11,
+};
 
-// Helper function to evaluate a simple condition of the form "column = value" for a record.
-static bool evaluateCondition(const Record& record, const std::string& condition) {
-    std::string cond = trim(condition);
-    if (cond.empty()) return true; // No condition means record qualifies.
+static void putLiteral(std::string& out, const Literal& literal) {
+    putU8(out, static_cast<uint8_t>(literal.kind));
+    putString(out, literal.text);
+}
 
-    // Assume condition is in the form "column = value"
-    size_t pos = cond.find('=');
-    if (pos == std::string::npos) {
-        std::cerr << "Error: Invalid condition format: " << condition << std::endl;
+static bool readLiteral(Cursor& cursor, Literal& literal) {
+    uint8_t kind = 0;
+    if (!cursor.u8(kind) || kind > static_cast<uint8_t>(Literal::Kind::STRING) || !cursor.string(literal.text))
         return false;
-    }
-    std::string col = trim(cond.substr(0, pos));
-    std::string val = trim(cond.substr(pos + 1));
-    // Remove surrounding apostrophes if present.
-    val = removeApostrophe(val);
+    literal.kind = static_cast<Literal::Kind>(kind);
+    return true;
+}
 
-    try {
-        const std::string& recordVal = record.getValue(col);
-        return recordVal == val;
+// A condition node: its kind, column, operator, negation, literals and operands (recursively).
+static void putCondition(std::string& out, const Condition& condition) {
+    putU8(out, static_cast<uint8_t>(condition.kind));
+    putString(out, condition.column);
+    putString(out, condition.op);
+    putU8(out, condition.negated ? 1 : 0);
+    putU32(out, static_cast<uint32_t>(condition.values.size()));
+    for (const auto& literal : condition.values)
+        putLiteral(out, literal);
+    putU32(out, static_cast<uint32_t>(condition.children.size()));
+    for (const auto& child : condition.children)
+        putCondition(out, child);
+}
+
+static bool readCondition(Cursor& cursor, Condition& condition) {
+    uint8_t kind = 0;
+    uint8_t negated = 0;
+    uint32_t valueCount = 0;
+    uint32_t childCount = 0;
+    if (!cursor.u8(kind) || kind > static_cast<uint8_t>(Condition::Kind::NOT) || !cursor.string(condition.column)
+        || !cursor.string(condition.op) || !cursor.u8(negated) || !cursor.u32(valueCount)
+        || valueCount > static_cast<size_t>(cursor.end - cursor.pos))
+        return false;
+    condition.kind = static_cast<Condition::Kind>(kind);
+    condition.negated = negated != 0;
+    condition.values.resize(valueCount);
+    for (auto& literal : condition.values) {
+        if (!readLiteral(cursor, literal))
+            return false;
     }
-    catch (const std::runtime_error&) {
+    if (!cursor.u32(childCount) || childCount > static_cast<size_t>(cursor.end - cursor.pos))
         return false;
+    condition.children.resize(childCount);
+    for (auto& child : condition.children) {
+        if (!readCondition(cursor, child))
+            return false;
+    }
+    // Each kind has the literals and operands it is evaluated with.
+    switch (condition.kind) {
+    case Condition::Kind::COMPARE:
+        return valueCount == 1 && childCount == 0;
+    case Condition::Kind::BETWEEN:
+        return valueCount == 2 && childCount == 0;
+    case Condition::Kind::IN:
+        return valueCount > 0 && childCount == 0;
+    case Condition::Kind::NOT:
+        return valueCount == 0 && childCount == 1;
+    case Condition::Kind::AND:
+    case Condition::Kind::OR:
+        return valueCount == 0 && childCount > 0;
+    default:
+        return valueCount == 0 && childCount == 0;
     }
 }
 
+// A fresh identifier ties a snapshot to the log that continues it.
+static uint64_t newLogId() {
+    static std::mt19937_64 generator(std::random_device{}()
+        ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    uint64_t id;
+    do {
+        id = generator();
+    } while (id == 0);
+    return id;
+}
+
+
 //---------------------------------------------------------------------
 // Singleton Instance
 //---------------------------------------------------------------------
@@ -51,142 +132,353 @@ Database& Database::getInstance() {
 // Constructor & Destructor
 //---------------------------------------------------------------------
 Database::Database() {
-    // Initialize if necessary.
+    // The background checkpoint encrypts until the destructor stops it, so the cipher library must outlive the database.
+    EncryptionHelper::initialize();
 }
 
 Database::~Database() {
-    // Clean up resources if necessary.
+    // A checkpoint still being written is finished before the tables go away.
+    checkpointer.stop();
 }
 
 //---------------------------------------------------------------------
 // File IO & Encryption: Flush (serialize) database to a file (including schema constraints)
 //---------------------------------------------------------------------
 bool Database::flushToFile(const std::string& filename, const std::string& key) {
-    std::ostringstream oss;
+    std::lock_guard<std::mutex> writing(checkpointing);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    CheckpointJob job;
+    captureCheckpoint(filename, key, false, job);
+    bool written = writeCheckpoint(job);
+    return completeCheckpoint(job, written);
+}
+
+void Database::captureCheckpoint(const std::string& filename, const std::string& key, bool keepLog, CheckpointJob& job) {
+    job.filename = filename;
+    job.key = key;
+    // A checkpoint of the file the tables came from appends the tables that changed, unless the sections no
+    // longer used there already outweigh the live ones: the file is then written anew, which reclaims them.
+    if (checkpoint.filename == filename && checkpoint.key == key) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(filename, error);
+        job.append = !error && size == checkpoint.fileSize && size - checkpoint.liveSize <= checkpoint.liveSize;
+        if (!job.append && Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Writing " << filename << " anew to reclaim " << (error ? 0 : size - std::min(size, checkpoint.liveSize))
+                << " unused byte(s).\n";
+    }
+    // A checkpoint is encrypted like the file it is appended to; a file written anew gets a nonce of its own.
+    if (job.append) {
+        job.cipher = checkpoint.cipher;
+        job.chunks = checkpoint.chunks;
+    }
+    else
+        getCipher(key, std::string(), job.cipher);
+    job.generation = job.append ? checkpoint.generation + 1 : 1;
+    job.start = job.append ? checkpoint.fileSize : 0;
+    // A background checkpoint keeps the current log, whose later records it does not include; a flush
+    // includes every change so far and starts a new log.
+    uint64_t logId = log.getLogId();
+    job.logId = keepLog && logId != 0 && log.getFilename() == filename + ".wal" ? logId : newLogId();
+    job.logPosition = log.getPosition();
+    job.logSize = log.getSize();
 
-    // Iterate over each table in the database.
+    // The tables that still match their section in the file are referred to where they are; otherwise
+    // pending tables are copied without being decoded.
     for (const auto& tablePair : tables) {
-        const std::string& tableName = tablePair.first;
-        std::shared_ptr<Table> table = tablePair.second;
-        // Write the table marker.
-        oss << "TABLE:" << tableName << "\n";
-
-        // Write the list of columns (in the order defined in the schema).
-        const auto& columns = table->getSchema().getColumns();
-        oss << "COLUMNS:";
-        for (size_t i = 0; i < columns.size(); ++i) {
-            oss << columns[i].getName();
-            if (i != columns.size() - 1)
-                oss << ",";
-        }
-        oss << "\n";
-
-        // Write the list of constraints.
-        const auto& constraints = table->getSchema().getConstraints();
-        oss << "CONSTRAINTS:";
-        bool firstConstraint = true;
-        for (const auto& constraint : constraints) {
-            if (auto pk = dynamic_cast<PrimaryKeyConstraint*>(constraint.get())) {
-                if (!firstConstraint) oss << ";";
-                oss << "PK(";
-                const auto& cols = pk->getColumnNames();
-                for (size_t i = 0; i < cols.size(); ++i) {
-                    oss << cols[i];
-                    if (i != cols.size() - 1)
-                        oss << ",";
-                }
-                oss << ")";
-                firstConstraint = false;
-            }
-            else if (auto uq = dynamic_cast<UniqueConstraint*>(constraint.get())) {
-                if (!firstConstraint) oss << ";";
-                oss << "UQ(";
-                const auto& cols = uq->getColumnNames();
-                for (size_t i = 0; i < cols.size(); ++i) {
-                    oss << cols[i];
-                    if (i != cols.size() - 1)
-                        oss << ",";
-                }
-                oss << ")";
-                firstConstraint = false;
-            }
-            else if (auto fk = dynamic_cast<ForeignKeyConstraint*>(constraint.get())) {
-                if (!firstConstraint) oss << ";";
-                oss << "FK(";
-                const auto& localCols = fk->getColumnNames();
-                for (size_t i = 0; i < localCols.size(); ++i) {
-                    oss << localCols[i];
-                    if (i != localCols.size() - 1)
-                        oss << ",";
-                }
-                oss << ")->" << fk->getReferencedTable() << "(";
-                const auto& refCols = fk->getReferencedColumns();
-                for (size_t i = 0; i < refCols.size(); ++i) {
-                    oss << refCols[i];
-                    if (i != refCols.size() - 1)
-                        oss << ",";
-                }
-                oss << ")";
-                firstConstraint = false;
-            }
+        CapturedTable captured = { tablePair.first, nullptr, false, SnapshotSection(), 0, tablePair.second->getVersion() };
+        auto saved = checkpoint.sections.find(tablePair.first);
+        if (job.append && saved != checkpoint.sections.end() && saved->second.version == captured.version) {
+            captured.reuse = true;
+            captured.section = saved->second.section;
         }
-        oss << "\n";
-
-        // Write the number of records.
-        const auto& records = table->getRecords();
-        oss << "RECORDS:" << records.size() << "\n";
-
-        // Write each record: output the values in the order of the columns.
-        for (const auto& record : records) {
-            for (size_t i = 0; i < columns.size(); ++i) {
-                std::string value;
-                if (record.hasColumn(columns[i].getName()))
-                    value = record.getValue(columns[i].getName());
-                oss << value;
-                if (i != columns.size() - 1)
-                    oss << "|";
-            }
-            oss << "\n";
+        else {
+            captured.table = tablePair.second;
         }
-        oss << "END_TABLE\n";
+        job.tables.push_back(std::move(captured));
+    }
+    for (const auto& pending : pendingTables) {
+        CapturedTable captured = { pending.first, nullptr, false, SnapshotSection(), pending.second, 0 };
+        auto saved = checkpoint.sections.find(pending.first);
+        if (job.append && saved != checkpoint.sections.end()) {
+            captured.reuse = true;
+            captured.section = saved->second.section;
+        }
+        else {
+            job.source = snapshot;
+        }
+        job.tables.push_back(std::move(captured));
+    }
+}
+
+bool Database::writeCheckpoint(CheckpointJob& job) {
+    if (!job.key.empty() && job.cipher.parameters.empty())
+        return false; // The key could not be derived.
+
+    // A checkpoint goes after the end of the file, so nothing the current checkpoint uses is overwritten;
+    // a snapshot written anew goes to a temporary file, so a failed write leaves the previous file intact.
+    std::string target = job.append ? job.filename : job.filename + ".tmp";
+    FILE* file = std::fopen(target.c_str(), job.append ? "ab" : "wb");
+    if (file == nullptr) {
+        std::cerr << "Error: Cannot open file for writing: " << target << std::endl;
+        return false;
     }
 
-    std::string serializedData = oss.str();
-    // Encrypt the serialized data.
-    std::string encryptedData = encryptData(serializedData, key);
+    // Serialize the tables into the binary snapshot format (one section per table), streaming it into the file
+    // a buffer at a time; the writer seals the chunks of the buffer on every core first.
+    SnapshotWriter writer([&](std::string& chunk) {
+        return std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+    }, job.start, job.cipher.parameters, slotCipher(job.cipher, true), chunkCipher(job.cipher, true), job.chunks);
+    // The tables that changed are encoded on every core, one table per thread; the others are referred to or
+    // copied after them.
+    std::vector<std::pair<std::string, const Table*>> changed;
+    for (const auto& captured : job.tables) {
+        if (captured.table)
+            changed.emplace_back(captured.name, captured.table.get());
+    }
+    bool written = writer.writeTables(changed);
+    job.rewritten += changed.size();
+    for (const auto& captured : job.tables) {
+        if (!written)
+            break;
+        if (captured.reuse)
+            writer.addSection(captured.section);
+        else if (!captured.table)
+            written = job.source->copySection(captured.pending, writer);
+    }
+    written = written && writer.finish() && std::fflush(file) == 0;
+
+    // The slot of the new generation makes the checkpoint current, so an appended checkpoint is on disk before
+    // the slot is written; a new file is forced to disk once, before it replaces the previous one.
+    if (written && job.append) {
+        written = syncFile(file);
+        written = std::fclose(file) == 0 && written;
+        file = written ? std::fopen(target.c_str(), "r+b") : nullptr;
+        written = file != nullptr;
+    }
+    if (written) {
+        std::string slot = writer.checkpoint(job.generation, job.logId, job.logPosition);
+        written = !slot.empty() && std::fseek(file, static_cast<long>(SnapshotWriter::checkpointOffset(job.generation)), SEEK_SET) == 0
+            && std::fwrite(slot.data(), 1, slot.size(), file) == slot.size()
+            && std::fflush(file) == 0 && syncFile(file);
+    }
+    if (file != nullptr)
+        written = std::fclose(file) == 0 && written;
+    if (!written) {
+        std::cerr << "Error: Failed to write file: " << target << std::endl;
+        if (!job.append)
+            std::remove(target.c_str());
+        return false;
+    }
+    job.sections = writer.getSections();
+    job.chunks = writer.getChunks();
+    job.fileSize = writer.getSize();
+    job.liveSize = writer.getLiveSize();
+    return true;
+}
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error: Cannot open file for writing: " << filename << std::endl;
+bool Database::completeCheckpoint(CheckpointJob& job, bool written) {
+    job.source.reset();
+    if (!written) {
+        // The previous checkpoint is still the current one; the next flush writes the file anew.
+        if (job.append)
+            checkpoint = Checkpoint();
         return false;
     }
 
-    file << encryptedData;
-    file.close();
+    if (!job.append) {
+        // The pending tables now live in the new file as well: release the mapping of the old one (which may be
+        // the file being replaced) and read them from the new one.
+        std::string tempName = job.filename + ".tmp";
+        std::unordered_map<std::string, size_t> pending;
+        pending.swap(pendingTables);
+        snapshot.reset();
+        checkpoint = Checkpoint();
+
+        // Replace the previous file (rename does not overwrite an existing file on every platform).
+        if (std::rename(tempName.c_str(), job.filename.c_str()) != 0
+            && (std::remove(job.filename.c_str()) != 0 || std::rename(tempName.c_str(), job.filename.c_str()) != 0)) {
+            std::cerr << "Error: Cannot replace file: " << job.filename << std::endl;
+            if (!pending.empty())
+                reattachPendingTables(tempName, job.key, pending);
+            return false;
+        }
+        if (!pending.empty() && !reattachPendingTables(job.filename, job.key, pending))
+            return false;
+    }
+    // Otherwise pending tables keep reading their sections through the current mapping: they did not move.
+    rememberCheckpoint(job);
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        if (job.append)
+            std::cout << "Checkpoint written to file: " << job.filename << " (" << job.rewritten << " of "
+                << job.sections.size() << " table(s) changed).\n";
+        else
+            std::cout << "Database flushed to file: " << job.filename << "\n";
+    }
+
+    // The log the checkpoint continues only needs the records written since it was captured.
+    if (job.logId == log.getLogId()) {
+        log.discard(job.logSize);
+        return true;
+    }
+    return startLog(job.filename, job.cipher, job.logId);
+}
+
+// Record the checkpoint just written, and which table version each of its sections holds.
+void Database::rememberCheckpoint(const CheckpointJob& job) {
+    std::unordered_map<std::string, uint64_t> versions;
+    for (const auto& captured : job.tables)
+        versions[captured.name] = captured.version;
+    std::unordered_map<std::string, SavedSection> sections;
+    for (const auto& section : job.sections) {
+        uint64_t version = versions[section.name];
+        // A table pending at the capture and decoded since still matches its section if the section did not move.
+        auto saved = checkpoint.sections.find(section.name);
+        if (version == 0 && saved != checkpoint.sections.end() && saved->second.section.offset == section.offset)
+            version = saved->second.version;
+        sections[section.name] = { section, version };
+    }
+    checkpoint.filename = job.filename;
+    checkpoint.key = job.key;
+    checkpoint.cipher = job.cipher;
+    checkpoint.generation = job.generation;
+    checkpoint.fileSize = job.fileSize;
+    checkpoint.liveSize = job.liveSize;
+    checkpoint.sections.swap(sections);
+    checkpoint.chunks = job.chunks;
+}
 
-    std::cout << "Database flushed to file: " << filename << std::endl;
+// Take a checkpoint in the background: the tables are captured between two statements, then written while
+// statements go on.
+void Database::runCheckpoint() {
+    std::lock_guard<std::mutex> writing(checkpointing);
+    CheckpointJob job;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (checkpoint.filename.empty() || isCheckpointCurrent())
+            return;
+        captureCheckpoint(checkpoint.filename, checkpoint.key, true, job);
+        for (const auto& captured : job.tables) {
+            if (captured.table)
+                frozenTables.insert(captured.table.get());
+        }
+    }
+    bool written = writeCheckpoint(job);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    frozenTables.clear();
+    completeCheckpoint(job, written);
+}
+
+bool Database::isCheckpointCurrent() const {
+    if (checkpoint.sections.size() != tables.size() + pendingTables.size())
+        return false;
+    for (const auto& tablePair : tables) {
+        auto saved = checkpoint.sections.find(tablePair.first);
+        if (saved == checkpoint.sections.end() || saved->second.version != tablePair.second->getVersion())
+            return false;
+    }
+    for (const auto& pending : pendingTables) {
+        if (checkpoint.sections.count(pending.first) == 0)
+            return false;
+    }
     return true;
 }
 
+// The snapshot includes every change so far: later changes go to a new log next to it. A stale log
+// left there carries another identifier, so it can never be replayed on top of this snapshot.
+bool Database::startLog(const std::string& filename, const SnapshotCipher& cipher, uint64_t logId) {
+    return log.create(filename + ".wal", logId, log.getPosition(), logCipher(cipher));
+}
+
+void Database::logChange(const std::string& record) {
+    if (log.append(record))
+        checkpointer.notifyLogSize(log.getSize());
+}
+
 //---------------------------------------------------------------------
 // File IO & Encryption: Load (deserialize) database from a file (including schema constraints)
 //---------------------------------------------------------------------
 bool Database::loadFromFile(const std::string& filename, const std::string& key) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error: Cannot open file for reading: " << filename << std::endl;
+    std::lock_guard<std::mutex> writing(checkpointing);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename))
         return false;
+
+    // Snapshots start with a readable header. Files written before the binary snapshot format are encrypted
+    // whole: they are read whole and imported through the text parser.
+    std::string head(file->data(), file->data() + std::min<uint64_t>(file->size(), 8));
+    if (!SnapshotReader::isSnapshot(head)) {
+        std::string decryptedData(file->data(), file->data() + file->size());
+        decryptLegacyChunk(decryptedData, 0, key);
+        if (!decryptedData.empty() && decryptedData.compare(0, 6, "TABLE:") != 0) {
+            std::cerr << "Error: " << filename << " is not a database file, or the key is wrong." << std::endl;
+            return false;
+        }
+        std::unordered_map<std::string, std::shared_ptr<Table>> loaded;
+        if (!loadLegacyText(decryptedData, loaded)) {
+            std::cerr << "Error: " << filename << " is damaged; the database was left unchanged." << std::endl;
+            return false;
+        }
+        log.close();
+        clearTables();
+        tables.swap(loaded);
+        if (Logger::isEnabled(LogLevel::NORMAL))
+            std::cout << "Note: " << filename << " predates the write-ahead log; changes are logged once it is flushed.\n";
     }
+    else {
+        // Check the whole file before anything is replaced, so that a damaged file leaves the database as it was.
+        SnapshotCipher cipher;
+        std::unique_ptr<SnapshotReader> reader = createReader(file, filename, key, &cipher);
+        if (!reader)
+            return false;
+        if (!reader->open() || !reader->verify()) {
+            std::cerr << "Error: " << filename << " is damaged; the database was left unchanged." << std::endl;
+            return false;
+        }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
+        // Swap the new tables in; they are decoded by getTable() on first access.
+        log.close();
+        clearTables();
+        uint64_t logId = reader->getLogId();
+        uint64_t logPosition = reader->getLogPosition();
+        for (size_t i = 0; i < reader->getTableCount(); ++i)
+            pendingTables[reader->getTableName(i)] = i;
+        // Every table matches its section until it changes, so the next flush to this file appends a checkpoint.
+        checkpoint.filename = filename;
+        checkpoint.key = key;
+        checkpoint.cipher = cipher;
+        checkpoint.generation = reader->getGeneration();
+        checkpoint.fileSize = file->size();
+        checkpoint.liveSize = reader->getLiveSize();
+        for (size_t i = 0; i < reader->getTableCount(); ++i)
+            checkpoint.sections[reader->getTableName(i)] = { reader->getSection(i), 0 };
+        checkpoint.chunks = reader->getChunks();
+        if (!pendingTables.empty())
+            snapshot = std::move(reader);
+        if (Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Mapped " << pendingTables.size() << " table(s); each is decoded on first access.\n";
 
-    std::string encryptedData = buffer.str();
-    std::string decryptedData = decryptData(encryptedData, key);
+        // Recover the changes logged after the snapshot was written, then keep logging to the same file.
+        if (logId != 0) {
+            size_t replayed = 0;
+            bool opened = log.open(filename + ".wal", logId, logPosition, logCipher(cipher),
+                [this](const std::string& record) { return replayChange(record); }, &replayed);
+            if (opened && replayed > 0 && Logger::isEnabled(LogLevel::NORMAL))
+                std::cout << "Recovered " << replayed << " logged change(s) from " << filename << ".wal.\n";
+        }
+    }
 
-    // Clear existing tables before loading new data.
-    tables.clear();
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Database loaded from file: " << filename << "\n";
+    return true;
+}
+
+// Import the legacy text format: TABLE/COLUMNS/CONSTRAINTS/[INDEXES]/[STORAGE]/RECORDS sections with '|'-joined rows.
+bool Database::loadLegacyText(const std::string& decryptedData, std::unordered_map<std::string, std::shared_ptr<Table>>& loaded) {
+    auto truncated = []() {
+        std::cerr << "Error: File ends in the middle of a table." << std::endl;
+        return false;
+    };
 
     // Use istringstream to parse the data.
     std::istringstream iss(decryptedData);
@@ -201,7 +493,7 @@ bool Database::loadFromFile(const std::string& filename, const std::string& key)
             std::string tableName = trim(line.substr(6));
 
             // Read the "COLUMNS:" line.
-            if (!std::getline(iss, line)) break;
+            if (!std::getline(iss, line)) return truncated();
             line = trim(line);
             if (line.rfind("COLUMNS:", 0) != 0) {
                 std::cerr << "Error: Expected COLUMNS: line" << std::endl;
@@ -217,7 +509,7 @@ bool Database::loadFromFile(const std::string& filename, const std::string& key)
             }
 
             // Read the "CONSTRAINTS:" line.
-            if (!std::getline(iss, line)) break;
+            if (!std::getline(iss, line)) return truncated();
             line = trim(line);
             if (line.rfind("CONSTRAINTS:", 0) != 0) {
                 std::cerr << "Error: Expected CONSTRAINTS: line" << std::endl;
@@ -269,9 +561,38 @@ bool Database::loadFromFile(const std::string& filename, const std::string& key)
                 }
             }
 
-            // Read the "RECORDS:" line.
-            if (!std::getline(iss, line)) break;
+            // Read the optional "INDEXES:" line (absent in files written before secondary indexes existed).
+            if (!std::getline(iss, line)) return truncated();
             line = trim(line);
+            std::vector<std::pair<std::string, std::vector<std::string>>> indexDefs;
+            if (line.rfind("INDEXES:", 0) == 0) {
+                std::string indexesStr = trim(line.substr(8));
+                if (!indexesStr.empty()) {
+                    for (const auto& token : split(indexesStr, ';')) {
+                        size_t posParen = token.find('(');
+                        if (posParen == std::string::npos || token.back() != ')') {
+                            std::cerr << "Warning: Unknown index format: " << token << std::endl;
+                            continue;
+                        }
+                        std::string indexName = trim(token.substr(0, posParen));
+                        std::string cols = token.substr(posParen + 1, token.size() - posParen - 2);
+                        indexDefs.emplace_back(indexName, split(cols, ','));
+                    }
+                }
+                if (!std::getline(iss, line)) return truncated();
+                line = trim(line);
+            }
+
+            // Read the optional "STORAGE:" line (absent in files written before columnar storage existed).
+            StorageLayout layout = StorageLayout::ROW;
+            if (line.rfind("STORAGE:", 0) == 0) {
+                if (trim(line.substr(8)) == "COLUMNAR")
+                    layout = StorageLayout::COLUMNAR;
+                if (!std::getline(iss, line)) return truncated();
+                line = trim(line);
+            }
+
+            // Read the "RECORDS:" line.
             if (line.rfind("RECORDS:", 0) != 0) {
                 std::cerr << "Error: Expected RECORDS: line" << std::endl;
                 return false;
@@ -279,36 +600,42 @@ bool Database::loadFromFile(const std::string& filename, const std::string& key)
             int recordCount = std::stoi(trim(line.substr(8)));
 
             // Create a new table with the loaded schema.
-            std::shared_ptr<Table> table = std::make_shared<Table>(tableName, schema);
+            std::shared_ptr<Table> table = std::make_shared<Table>(tableName, schema, layout);
 
             // Read each record.
             for (int i = 0; i < recordCount; ++i) {
-                if (!std::getline(iss, line)) break;
+                if (!std::getline(iss, line)) return truncated();
                 line = trim(line);
                 std::vector<std::string> values = split(line, '|');
-                Record record;
-                for (size_t j = 0; j < columnNames.size(); ++j) {
-                    std::string value = (j < values.size()) ? values[j] : "";
-                    record.setValue(columnNames[j], value);
+                Record record(columnNames.size());
+                for (size_t j = 0; j < columnNames.size() && j < values.size(); ++j) {
+                    Value value;
+                    if (values[j] != "\\N")
+                        Value::convert(schema.getColumns()[j].getType(), values[j], value);
+                    record.setValue(j, std::move(value));
                 }
                 table->insertRecord(record);
             }
 
+            // Build the secondary indexes once all records are in place.
+            for (const auto& def : indexDefs) {
+                table->createIndex(def.first, def.second);
+            }
+
             // Read the table termination marker "END_TABLE".
-            if (!std::getline(iss, line)) break;
+            if (!std::getline(iss, line)) return truncated();
             line = trim(line);
             if (line != "END_TABLE") {
                 std::cerr << "Error: Expected END_TABLE line" << std::endl;
                 return false;
             }
 
-            // Add the newly created table to the database.
-            addTable(tableName, table);
-            std::cout << "Loaded table: " << tableName << " with " << recordCount << " record(s).\n";
+            // Keep the table aside until the whole file has been read.
+            loaded[tableName] = table;
+            if (Logger::isEnabled(LogLevel::VERBOSE))
+                std::cout << "Loaded table: " << tableName << " with " << recordCount << " record(s).\n";
         }
     }
-
-    std::cout << "Database loaded from file: " << filename << std::endl;
     return true;
 }
 
@@ -328,76 +655,296 @@ bool Database::executeQuery(const std::string& sql) {
 //---------------------------------------------------------------------
 
 // Insert: Add a record to the specified table.
-bool Database::insert(const std::string& tableName, const std::vector<std::string>& columns, const std::vector<std::string>& values) {
-    auto table = getTable(tableName);
+bool Database::insert(const std::string& tableName, const std::vector<std::string>& columns,
+    const std::vector<std::vector<Literal>>& rows, size_t* affected) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto table = getWritableTable(tableName);
     if (!table) {
         std::cerr << "Error: Table not found: " << tableName << std::endl;
         return false;
     }
-    if (columns.size() != values.size()) {
-        std::cerr << "Error: Number of columns and values do not match." << std::endl;
-        return false;
-    }
-    Record newRecord;
+    // Resolve the column names to ordinals once for the whole statement.
+    const auto& schemaColumns = table->getSchema().getColumns();
+    std::vector<size_t> ordinals(columns.size());
+    std::vector<char> provided(schemaColumns.size(), 0);
     for (size_t i = 0; i < columns.size(); ++i) {
-        newRecord.setValue(columns[i], removeApostrophe(values[i]));
+        int ordinal = table->getSchema().getColumnIndex(columns[i]);
+        if (ordinal < 0) {
+            std::cerr << "Error: Column '" << columns[i] << "' does not exist in table " << tableName << std::endl;
+            return false;
+        }
+        ordinals[i] = static_cast<size_t>(ordinal);
+        provided[ordinal] = 1;
+    }
+    // Columns not listed take their default value, or NULL.
+    Record defaults(schemaColumns.size());
+    for (size_t i = 0; i < schemaColumns.size(); ++i) {
+        Value value;
+        if (!provided[i] && !schemaColumns[i].getDefaultValue().empty()
+            && Value::parse(schemaColumns[i].getType(), schemaColumns[i].getDefaultValue(), value))
+            defaults.setValue(i, std::move(value));
+    }
+    // Convert each literal to its column's type.
+    std::vector<Record> records;
+    records.reserve(rows.size());
+    for (const auto& values : rows) {
+        if (columns.size() != values.size()) {
+            std::cerr << "Error: Number of columns and values do not match." << std::endl;
+            return false;
+        }
+        records.push_back(defaults);
+        Record& newRecord = records.back();
+        for (size_t i = 0; i < columns.size(); ++i) {
+            Value value;
+            if (!values[i].toValue(schemaColumns[ordinals[i]].getType(), value)) {
+                std::cerr << "Error: Invalid value for column '" << columns[i] << "': " << values[i].toString() << std::endl;
+                return false;
+            }
+            newRecord.setValue(ordinals[i], std::move(value));
+        }
     }
-    if (table->insertRecord(newRecord)) {
-        std::cout << "Record inserted into table " << tableName << std::endl;
+    if (table->insertRecords(records)) {
+        if (affected)
+            *affected = records.size();
+        if (Logger::isEnabled(LogLevel::VERBOSE)) {
+            if (records.size() == 1)
+                std::cout << "Record inserted into table " << tableName << "\n";
+            else
+                std::cout << records.size() << " records inserted into table " << tableName << "\n";
+        }
+        if (log.isOpen()) {
+            std::string record;
+            putU8(record, static_cast<uint8_t>(LogOperation::INSERT));
+            putString(record, tableName);
+            putStrings(record, columns);
+            putU32(record, static_cast<uint32_t>(rows.size()));
+            for (const auto& values : rows) {
+                for (const auto& literal : values)
+                    putLiteral(record, literal);
+            }
+            logChange(record);
+        }
         return true;
     }
     else {
         std::cerr << "Error: Failed to insert record into table " << tableName << std::endl;
         return false;
     }
-}// Select: Retrieve records from the specified table, filtering by condition if provided.
-bool Database::select(const std::string& tableName, const std::vector<std::string>& columns, const std::string& condition) {
-    auto table = getTable(tableName);
-    if (!table) {
-        std::cerr << "Error: Table not found: " << tableName << std::endl;
-        return false;
+}
+
+// Select the groups of the matching records with their aggregates (see Database::select).
+static bool selectGroups(const Table& table, const std::string& tableName, const std::vector<SelectItem>& items,
+    const Condition& condition, const std::vector<std::string>& groupBy, const std::string& orderBy, bool descending,
+    size_t* affected) {
+    const Schema& schema = table.getSchema();
+    const auto& schemaColumns = schema.getColumns();
+    std::vector<size_t> groupOrdinals;
+    for (const auto& col : groupBy) {
+        int ordinal = schema.getColumnIndex(col);
+        if (ordinal < 0) {
+            std::cerr << "Error: Column '" << col << "' does not exist in table " << tableName << std::endl;
+            return false;
+        }
+        groupOrdinals.push_back(static_cast<size_t>(ordinal));
     }
-    const auto& records = table->getRecords();
-    std::cout << "Selected records from table " << tableName << ":" << std::endl;
-    for (const auto& record : records) {
-        // If a condition is provided, evaluate it.
-        if (!condition.empty() && !evaluateCondition(record, condition))
+    // Each item is either a group column (by its index in groupBy) or an aggregate (by its index in aggregates).
+    std::vector<Aggregation::Aggregate> aggregates;
+    std::vector<std::pair<bool, size_t>> sources;
+    for (const auto& item : items) {
+        if (item.function == SelectItem::Function::NONE) {
+            auto found = std::find(groupBy.begin(), groupBy.end(), item.column);
+            if (found == groupBy.end()) {
+                std::cerr << "Error: Column '" << item.column << "' must appear in GROUP BY or be used in an aggregate function" << std::endl;
+                return false;
+            }
+            sources.emplace_back(false, static_cast<size_t>(found - groupBy.begin()));
             continue;
-        const auto& data = record.getData();
-        // If columns contain only "*" then print all columns.
-        if (columns.size() == 1 && columns[0] == "*") {
-            for (const auto& p : data) {
-                std::cout << p.first << ": " << p.second << " | ";
+        }
+        Aggregation::Aggregate aggregate;
+        if (item.column == "*") {
+            aggregate.function = Aggregation::Function::COUNT_ALL;
+        }
+        else {
+            int ordinal = schema.getColumnIndex(item.column);
+            if (ordinal < 0) {
+                std::cerr << "Error: Column '" << item.column << "' does not exist in table " << tableName << std::endl;
+                return false;
+            }
+            aggregate.ordinal = static_cast<size_t>(ordinal);
+            switch (item.function) {
+            case SelectItem::Function::COUNT: aggregate.function = Aggregation::Function::COUNT; break;
+            case SelectItem::Function::SUM: aggregate.function = Aggregation::Function::SUM; break;
+            case SelectItem::Function::MIN: aggregate.function = Aggregation::Function::MIN; break;
+            case SelectItem::Function::MAX: aggregate.function = Aggregation::Function::MAX; break;
+            default: aggregate.function = Aggregation::Function::AVG; break;
+            }
+            bool numeric = schemaColumns[ordinal].getType() != DataType::STRING;
+            if (!numeric && (aggregate.function == Aggregation::Function::SUM || aggregate.function == Aggregation::Function::AVG)) {
+                std::cerr << "Error: " << item.name << " requires an INTEGER or FLOAT column" << std::endl;
+                return false;
             }
         }
+        sources.emplace_back(true, aggregates.size());
+        aggregates.push_back(aggregate);
+    }
+    // ORDER BY names an item, or else a group column that is not selected.
+    std::pair<bool, size_t> sortSource(false, 0);
+    if (!orderBy.empty()) {
+        auto item = std::find_if(items.begin(), items.end(), [&orderBy](const SelectItem& i) { return i.name == orderBy; });
+        auto group = std::find(groupBy.begin(), groupBy.end(), orderBy);
+        if (item != items.end()) {
+            sortSource = sources[item - items.begin()];
+        }
+        else if (group != groupBy.end()) {
+            sortSource = std::make_pair(false, static_cast<size_t>(group - groupBy.begin()));
+        }
         else {
-            for (const auto& col : columns) {
-                auto it = data.find(col);
-                if (it != data.end()) {
-                    std::cout << col << ": " << it->second << " | ";
-                }
+            std::cerr << "Error: ORDER BY " << orderBy << " is neither a selected item nor a GROUP BY column" << std::endl;
+            return false;
+        }
+    }
+
+    Aggregation aggregation(schema, groupOrdinals, aggregates);
+    if (!table.aggregate(condition, aggregation))
+        return false;
+    auto valueOf = [&aggregation](size_t group, const std::pair<bool, size_t>& source) {
+        return source.first ? aggregation.getResult(group, source.second) : aggregation.getKey(group, source.second);
+    };
+    std::vector<size_t> groups(aggregation.getGroupCount());
+    for (size_t i = 0; i < groups.size(); ++i)
+        groups[i] = i;
+    if (!orderBy.empty()) {
+        // Fetch the sort values once, then sort by them (NULL first), like Table::sortRecords.
+        std::vector<std::pair<Value, size_t>> keyed;
+        keyed.reserve(groups.size());
+        for (size_t group : groups)
+            keyed.emplace_back(valueOf(group, sortSource), group);
+        std::stable_sort(keyed.begin(), keyed.end(), [descending](const std::pair<Value, size_t>& a, const std::pair<Value, size_t>& b) {
+            int cmp = a.first.compare(b.first);
+            return descending ? cmp > 0 : cmp < 0;
+            });
+        for (size_t i = 0; i < keyed.size(); ++i)
+            groups[i] = keyed[i].second;
+    }
+
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Selected groups from table " << tableName << ":\n";
+    std::string text;
+    for (size_t begin = 0; begin < groups.size(); begin += Batch::SIZE) {
+        text.clear();
+        size_t end = std::min(groups.size(), begin + Batch::SIZE);
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = 0; j < items.size(); ++j) {
+                text += items[j].name;
+                text += ": ";
+                text += valueOf(groups[i], sources[j]).toString();
+                text += " | ";
             }
+            text += '\n';
         }
-        std::cout << std::endl;
+        std::cout << text;
     }
+    if (affected)
+        *affected = groups.size();
     return true;
 }
 
-// Update: Update records in the specified table that match the condition.
-bool Database::update(const std::string& tableName, const std::vector<std::pair<std::string, std::string>>& assignments, const std::string& condition) {
+// Select: Retrieve records from the specified table, filtering by condition if provided.
+bool Database::select(const std::string& tableName, const std::vector<SelectItem>& columns, const Condition& condition,
+    const std::vector<std::string>& groupBy, const std::string& orderBy, bool descending, size_t* affected) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     auto table = getTable(tableName);
     if (!table) {
         std::cerr << "Error: Table not found: " << tableName << std::endl;
         return false;
     }
-    Record updateRecord;
+    bool aggregated = !groupBy.empty() || std::any_of(columns.begin(), columns.end(),
+        [](const SelectItem& item) { return item.function != SelectItem::Function::NONE; });
+    if (aggregated)
+        return selectGroups(*table, tableName, columns, condition, groupBy, orderBy, descending, affected);
+    // Resolve the matching records first; equality on an indexed column is a single lookup.
+    std::vector<size_t> positions;
+    if (!table->findRecords(condition, positions))
+        return false;
+    if (!orderBy.empty() && !table->sortRecords(positions, orderBy, descending))
+        return false;
+    // Resolve the projected columns to ordinals once; "*" selects every column in schema order.
+    const auto& schemaColumns = table->getSchema().getColumns();
+    std::vector<size_t> ordinals;
+    if (columns.size() == 1 && columns[0].column == "*") {
+        for (size_t i = 0; i < schemaColumns.size(); ++i)
+            ordinals.push_back(i);
+    }
+    else {
+        for (const auto& col : columns) {
+            int ordinal = table->getSchema().getColumnIndex(col.column);
+            if (ordinal < 0) {
+                std::cerr << "Error: Column '" << col.column << "' does not exist in table " << tableName << std::endl;
+                return false;
+            }
+            ordinals.push_back(static_cast<size_t>(ordinal));
+        }
+    }
+
+    // The selected records are the query result and are written at every logging level, a batch at a time.
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Selected records from table " << tableName << ":\n";
+    std::string text;
+    for (size_t begin = 0; begin < positions.size(); begin += Batch::SIZE) {
+        text.clear();
+        table->formatRecords(positions.data() + begin, std::min(positions.size(), begin + Batch::SIZE) - begin, ordinals, text);
+        std::cout << text;
+    }
+    if (affected)
+        *affected = positions.size();
+    return true;
+}
+
+// Update: Update records in the specified table that match the condition.
+bool Database::update(const std::string& tableName, const std::vector<std::pair<std::string, Literal>>& assignments, const Condition& condition,
+    size_t* affected) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto table = getWritableTable(tableName);
+    if (!table) {
+        std::cerr << "Error: Table not found: " << tableName << std::endl;
+        return false;
+    }
+    // Resolve the assigned columns to ordinals and convert the new values to their column's type.
+    const auto& schemaColumns = table->getSchema().getColumns();
+    std::vector<std::pair<size_t, Value>> typedAssignments;
     for (const auto& assignment : assignments) {
-        updateRecord.setValue(assignment.first, assignment.second);
+        int ordinal = table->getSchema().getColumnIndex(assignment.first);
+        if (ordinal < 0) {
+            std::cerr << "Error: Column '" << assignment.first << "' does not exist in table " << tableName << std::endl;
+            return false;
+        }
+        Value value;
+        if (!assignment.second.toValue(schemaColumns[ordinal].getType(), value)) {
+            std::cerr << "Error: Invalid value for column '" << assignment.first << "': " << assignment.second.toString() << std::endl;
+            return false;
+        }
+        typedAssignments.emplace_back(static_cast<size_t>(ordinal), std::move(value));
     }
-    // The Table::updateRecord function is expected to iterate through records and apply the update
-    // based on the condition. Here we pass the condition as is; the Table class will use our helper function.
-    if (table->updateRecord(updateRecord, condition)) {
-        std::cout << "Records updated in table " << tableName << std::endl;
+    // The Table::updateRecord function finds the records matching the condition and applies the update.
+    size_t updated = 0;
+    if (table->updateRecord(typedAssignments, condition, &updated)) {
+        if (affected)
+            *affected = updated;
+        if (Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Records updated in table " << tableName << "\n";
+        // An update that matched nothing changed nothing, and is not logged.
+        if (updated > 0 && log.isOpen()) {
+            std::string record;
+            putU8(record, static_cast<uint8_t>(LogOperation::UPDATE));
+            putString(record, tableName);
+            putU32(record, static_cast<uint32_t>(assignments.size()));
+            for (const auto& assignment : assignments) {
+                putString(record, assignment.first);
+                putLiteral(record, assignment.second);
+            }
+            putCondition(record, condition);
+            logChange(record);
+        }
         return true;
     }
     else {
@@ -407,15 +954,27 @@ bool Database::update(const std::string& tableName, const std::vector<std::pair<
 }
 
 // Remove: Delete records from the specified table that match the condition.
-bool Database::remove(const std::string& tableName, const std::string& condition) {
-    auto table = getTable(tableName);
+bool Database::remove(const std::string& tableName, const Condition& condition, size_t* affected) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto table = getWritableTable(tableName);
     if (!table) {
         std::cerr << "Error: Table not found: " << tableName << std::endl;
         return false;
     }
     // The Table::deleteRecord function will handle deletion using the condition.
-    if (table->deleteRecord(condition)) {
-        std::cout << "Records deleted from table " << tableName << std::endl;
+    size_t deleted = 0;
+    if (table->deleteRecord(condition, &deleted)) {
+        if (affected)
+            *affected = deleted;
+        if (Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Records deleted from table " << tableName << "\n";
+        if (deleted > 0 && log.isOpen()) {
+            std::string record;
+            putU8(record, static_cast<uint8_t>(LogOperation::DELETE_FROM));
+            putString(record, tableName);
+            putCondition(record, condition);
+            logChange(record);
+        }
         return true;
     }
     else {
@@ -428,59 +987,490 @@ bool Database::remove(const std::string& tableName, const std::string& condition
 // Table Management
 //---------------------------------------------------------------------
 void Database::addTable(const std::string& tableName, std::shared_ptr<Table> table) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     tables[tableName] = table;
-    std::cout << "Table added: " << tableName << std::endl;
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Table added: " << tableName << "\n";
+}
+
+bool Database::createTable(const std::string& tableName, const Schema& schema, StorageLayout layout) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (hasTable(tableName)) {
+        std::cerr << "Error: Table '" << tableName << "' already exists." << std::endl;
+        return false;
+    }
+    addTable(tableName, std::make_shared<Table>(tableName, schema, layout));
+    if (log.isOpen()) {
+        std::string record;
+        putU8(record, static_cast<uint8_t>(LogOperation::CREATE_TABLE));
+        putString(record, tableName);
+        putU8(record, static_cast<uint8_t>(layout));
+        putSchema(record, schema);
+        logChange(record);
+    }
+    return true;
 }
 
 std::shared_ptr<Table> Database::getTable(const std::string& tableName) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     auto it = tables.find(tableName);
     if (it != tables.end()) {
         return it->second;
     }
-    std::cerr << "Error: Table not found: " << tableName << std::endl;
-    return nullptr;
+    auto pending = pendingTables.find(tableName);
+    if (pending == pendingTables.end())
+        return nullptr;
+
+    // First access since the load: decode the table's section. A section that fails to decode stays
+    // pending (and is still written back by a flush), so no data is lost.
+    std::shared_ptr<Table> table = snapshot->readTable(pending->second);
+    if (table)
+        adoptPendingTable(tableName, table);
+    return table;
+}
+
+void Database::adoptPendingTable(const std::string& tableName, const std::shared_ptr<Table>& table) {
+    pendingTables.erase(tableName);
+    tables[tableName] = table;
+    auto saved = checkpoint.sections.find(tableName);
+    if (saved != checkpoint.sections.end() && saved->second.version == 0)
+        saved->second.version = table->getVersion(); // The section holds the table as just decoded.
+    if (pendingTables.empty())
+        snapshot.reset(); // Every table is decoded; release the mapping.
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Loaded table: " << tableName << " with " << table->getRecordCount() << " record(s).\n";
+}
+
+std::shared_ptr<Table> Database::getWritableTable(const std::string& tableName) {
+    std::shared_ptr<Table> table = getTable(tableName);
+    if (table && frozenTables.count(table.get()) > 0) {
+        // The checkpoint keeps writing the table as it was captured; the statement modifies a copy.
+        table = table->clone();
+        tables[tableName] = table;
+        if (Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Copied table " << tableName << ": a checkpoint is writing it.\n";
+    }
+    return table;
+}
+
+bool Database::hasTable(const std::string& tableName) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return tables.count(tableName) > 0 || pendingTables.count(tableName) > 0;
+}
+
+bool Database::loadPendingTables() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (pendingTables.size() == 1)
+        return getTable(pendingTables.begin()->first) != nullptr;
+
+    // The directory locates every section, so the tables are decoded on every core, one table per thread
+    // (which reads its section serially). Tables whose section fails to decode stay pending.
+    std::vector<std::pair<std::string, size_t>> pending(pendingTables.begin(), pendingTables.end());
+    std::vector<std::shared_ptr<Table>> decoded(pending.size());
+    std::shared_ptr<SnapshotReader> source = snapshot;
+    Parallel::forEach(pending.size(), [&](size_t i) {
+        decoded[i] = source->readTable(pending[i].second, false);
+    });
+    bool loaded = true;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (decoded[i])
+            adoptPendingTable(pending[i].first, decoded[i]);
+        else
+            loaded = false;
+    }
+    return loaded;
+}
+
+void Database::clearTables() {
+    tables.clear();
+    pendingTables.clear();
+    snapshot.reset();
+    checkpoint = Checkpoint();
 }
 
 bool Database::dropTable(const std::string& tableName) {
-    auto table = getTable(tableName);
-    if (!table) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!hasTable(tableName)) {
         std::cerr << "Error: Table '" << tableName << "' not found." << std::endl;
         return false;
     }
+    // Foreign keys referencing the table may be declared by tables that are still pending.
+    if (!loadPendingTables())
+        return false;
     // Iterate over all tables to remove foreign key constraints referencing this table.
     for (auto& pair : tables) {
-        auto otherTable = pair.second;
-        // Access the constraints of the other table's schema.
-        auto& constraints = const_cast<std::vector<std::shared_ptr<Constraint>>&>(otherTable->getSchema().getConstraints());
-        constraints.erase(std::remove_if(constraints.begin(), constraints.end(),
-            [tableName](const std::shared_ptr<Constraint>& c) {
-                if (auto fk = dynamic_cast<ForeignKeyConstraint*>(c.get())) {
-                    return fk->getReferencedTable() == tableName;
-                }
-                return false;
-            }), constraints.end());
+        const auto& constraints = pair.second->getSchema().getConstraints();
+        bool references = std::any_of(constraints.begin(), constraints.end(), [&tableName](const std::shared_ptr<Constraint>& c) {
+            auto fk = dynamic_cast<ForeignKeyConstraint*>(c.get());
+            return fk != nullptr && fk->getReferencedTable() == tableName;
+        });
+        if (references)
+            getWritableTable(pair.first)->dropForeignKeys(tableName);
     }
     tables.erase(tableName);
-    std::cout << "DROP TABLE: Table '" << tableName << "' dropped." << std::endl;
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Table '" << tableName << "' dropped.\n";
+    if (log.isOpen()) {
+        std::string record;
+        putU8(record, static_cast<uint8_t>(LogOperation::DROP_TABLE));
+        putString(record, tableName);
+        logChange(record);
+    }
+    return true;
+}
+
+bool Database::createIndex(const std::string& indexName, const std::string& tableName, const std::vector<std::string>& columns) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto table = getWritableTable(tableName);
+    if (!table) {
+        std::cerr << "Error: Table not found: " << tableName << std::endl;
+        return false;
+    }
+    // Index names are unique across the database, including the tables that are still pending.
+    if (!loadPendingTables())
+        return false;
+    for (const auto& pair : tables) {
+        if (pair.second->hasIndex(indexName)) {
+            std::cerr << "Error: Index '" << indexName << "' already exists on table '" << pair.first << "'." << std::endl;
+            return false;
+        }
+    }
+    if (!table->createIndex(indexName, columns))
+        return false;
+    if (log.isOpen()) {
+        std::string record;
+        putU8(record, static_cast<uint8_t>(LogOperation::CREATE_INDEX));
+        putString(record, indexName);
+        putString(record, tableName);
+        putStrings(record, columns);
+        logChange(record);
+    }
+    return true;
+}
+
+bool Database::dropIndex(const std::string& indexName) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!loadPendingTables())
+        return false;
+    for (auto& pair : tables) {
+        if (pair.second->hasIndex(indexName)) {
+            getWritableTable(pair.first)->dropIndex(indexName);
+            if (log.isOpen()) {
+                std::string record;
+                putU8(record, static_cast<uint8_t>(LogOperation::DROP_INDEX));
+                putString(record, indexName);
+                logChange(record);
+            }
+            return true;
+        }
+    }
+    std::cerr << "Error: Index '" << indexName << "' not found." << std::endl;
+    return false;
+}
+
+bool Database::dropColumn(const std::string& tableName, const std::string& columnName) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto table = getWritableTable(tableName);
+    if (!table) {
+        std::cerr << "Error: Table '" << tableName << "' not found." << std::endl;
+        return false;
+    }
+    if (!table->dropColumn(columnName))
+        return false;
+    if (log.isOpen()) {
+        std::string record;
+        putU8(record, static_cast<uint8_t>(LogOperation::DROP_COLUMN));
+        putString(record, tableName);
+        putString(record, columnName);
+        logChange(record);
+    }
     return true;
 }
 
+void Database::setSyncPolicy(SyncPolicy policy, unsigned interval) {
+    log.setSyncPolicy(policy, interval);
+}
+
+void Database::setCheckpointPolicy(unsigned interval, uint64_t logSize) {
+    // Not under the statement lock: stopping waits for a running checkpoint, which takes it.
+    checkpointer.start(interval, logSize, [this]() { runCheckpoint(); });
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (checkpointer.isRunning() && checkpoint.filename.empty() && Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "Note: Checkpoints are taken once the database is loaded from or flushed to a file.\n";
+}
+
+//---------------------------------------------------------------------
+// Write-Ahead Log Recovery
+//---------------------------------------------------------------------
+bool Database::replayChange(const std::string& record) {
+    Cursor cursor = { record.data(), record.data() + record.size() };
+    uint8_t operation = 0;
+    std::string tableName;
+    if (!cursor.u8(operation))
+        return false;
+
+    switch (static_cast<LogOperation>(operation)) {
+    case LogOperation::CREATE_TABLE: {
+        uint8_t layout = 0;
+        Schema schema;
+        if (!cursor.string(tableName) || !cursor.u8(layout) || layout > static_cast<uint8_t>(StorageLayout::COLUMNAR)
+            || !readSchema(cursor, schema))
+            return false;
+        return createTable(tableName, schema, static_cast<StorageLayout>(layout));
+    }
+    case LogOperation::DROP_TABLE:
+        return cursor.string(tableName) && dropTable(tableName);
+    case LogOperation::CREATE_INDEX: {
+        std::string indexName;
+        std::vector<std::string> columns;
+        return cursor.string(indexName) && cursor.string(tableName) && cursor.strings(columns)
+            && createIndex(indexName, tableName, columns);
+    }
+    case LogOperation::DROP_INDEX: {
+        std::string indexName;
+        return cursor.string(indexName) && dropIndex(indexName);
+    }
+    case LogOperation::DROP_COLUMN: {
+        std::string columnName;
+        return cursor.string(tableName) && cursor.string(columnName) && dropColumn(tableName, columnName);
+    }
+    case LogOperation::INSERT: {
+        std::vector<std::string> columns;
+        uint32_t rowCount = 0;
+        if (!cursor.string(tableName) || !cursor.strings(columns) || !cursor.u32(rowCount)
+            || rowCount > static_cast<size_t>(cursor.end - cursor.pos))
+            return false;
+        std::vector<std::vector<Literal>> rows(rowCount, std::vector<Literal>(columns.size()));
+        for (auto& values : rows) {
+            for (auto& literal : values) {
+                if (!readLiteral(cursor, literal))
+                    return false;
+            }
+        }
+        return insert(tableName, columns, rows);
+    }
+    case LogOperation::UPDATE: {
+        uint32_t assignmentCount = 0;
+        if (!cursor.string(tableName) || !cursor.u32(assignmentCount) || assignmentCount > static_cast<size_t>(cursor.end - cursor.pos))
+            return false;
+        std::vector<std::pair<std::string, Literal>> assignments(assignmentCount);
+        for (auto& assignment : assignments) {
+            if (!cursor.string(assignment.first) || !readLiteral(cursor, assignment.second))
+                return false;
+        }
+        Condition condition;
+        return readCondition(cursor, condition) && update(tableName, assignments, condition);
+    }
+    case LogOperation::DELETE_FROM: {
+        Condition condition;
+        return cursor.string(tableName) && readCondition(cursor, condition) && remove(tableName, condition);
+    }
+    default:
+        return false;
+    }
+}
+
+//---------------------------------------------------------------------
+// Encryption/Decryption
+//---------------------------------------------------------------------
+// Files written before AES encryption were XORed with the key, repeated from the start of the file.
+void Database::decryptLegacyChunk(std::string& chunk, uint64_t offset, const std::string& key) {
+    if (key.empty())
+        return;
+    size_t k = static_cast<size_t>(offset % key.size());
+    if (chunk.size() < 4096) {
+        // Walk the key alongside the data instead of taking a modulo per byte.
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            chunk[i] ^= key[k];
+            if (++k == key.size())
+                k = 0;
+        }
+        return;
+    }
+    // Large chunks are XORed a word at a time, block by block, with the key repeated over a whole number of
+    // key lengths (so every block starts at the same point of the key).
+    size_t block = key.size() * ((4096 + key.size() - 1) / key.size());
+    std::string pattern;
+    pattern.reserve(block + key.size());
+    while (pattern.size() < block + key.size())
+        pattern.append(key);
+    const char* stream = pattern.data() + k;
+    for (size_t start = 0; start < chunk.size(); start += block) {
+        size_t length = std::min(block, chunk.size() - start);
+        char* data = &chunk[start];
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            uint64_t word, mask;
+            std::memcpy(&word, data + i, 8);
+            std::memcpy(&mask, stream + i, 8);
+            word ^= mask;
+            std::memcpy(data + i, &word, 8);
+        }
+        for (; i < length; ++i)
+            data[i] ^= stream[i];
+    }
+}
+
+bool Database::getCipher(const std::string& key, const std::string& parameters, SnapshotCipher& cipher) {
+    cipher = SnapshotCipher();
+    if (key.empty())
+        return true;
+    // The parameters are the salt of the key, the uint64 nonce of the file, then 8 bytes that tell whether a
+    // key is the right one: an HMAC under a subkey used for nothing else.
+    std::string salt;
+    if (parameters.empty()) {
+        // A new file keeps the salt of the last key derived from the passphrase, so that the key is not derived
+        // again; the nonce alone keeps its keystream apart from other files.
+        salt = derivedKey.passphrase == key && !derivedKey.salt.empty() ? derivedKey.salt
+            : EncryptionHelper::randomBytes(EncryptionHelper::SALT_SIZE);
+        cipher.nonce = EncryptionHelper::newNonce();
+    }
+    else {
+        salt = parameters.substr(0, EncryptionHelper::SALT_SIZE);
+        Cursor cursor = { parameters.data() + salt.size(), parameters.data() + parameters.size() };
+        cursor.u64(cipher.nonce);
+    }
+    std::string derived = deriveKey(key, salt);
+    if (derived.empty())
+        return false;
+    cipher.key = EncryptionHelper::deriveSubkey(derived, "DBSIM snapshot");
+    cipher.logKey = EncryptionHelper::deriveSubkey(derived, "DBSIM log");
+    std::string checkKey = EncryptionHelper::deriveSubkey(derived, "DBSIM key check");
+    if (cipher.key.empty() || cipher.logKey.empty() || checkKey.empty())
+        return false;
+    std::string check = EncryptionHelper::deriveSubkey(checkKey, "key-check").substr(0, 8);
+    cipher.parameters = salt;
+    putU64(cipher.parameters, cipher.nonce);
+    cipher.parameters.append(check);
+    return parameters.empty() || cipher.parameters == parameters;
+}
+
+std::string Database::deriveKey(const std::string& passphrase, const std::string& salt) {
+    if (derivedKey.key.empty() || derivedKey.passphrase != passphrase || derivedKey.salt != salt) {
+        std::string key = EncryptionHelper::deriveKey(passphrase, salt);
+        if (key.empty())
+            return key;
+        derivedKey = { passphrase, salt, key };
+    }
+    return derivedKey.key;
+}
+
+// A sealed slot is a random GCM nonce, then the slot (padded to fill the rest) encrypted, then its tag; the tag
+// also covers the encryption parameters of the header.
+SnapshotWriter::SlotCipher Database::slotCipher(const SnapshotCipher& cipher, bool sealing) {
+    if (cipher.key.empty())
+        return SnapshotWriter::SlotCipher();
+    size_t nonceSize = EncryptionHelper::NONCE_SIZE;
+    size_t dataSize = SnapshotWriter::SLOT_SIZE - nonceSize - EncryptionHelper::TAG_SIZE;
+    if (sealing) {
+        return [cipher, nonceSize, dataSize](std::string& slot) {
+            std::string nonce = EncryptionHelper::randomBytes(nonceSize);
+            slot.resize(dataSize, '\0');
+            if (!EncryptionHelper::seal(slot, cipher.key, nonce, cipher.parameters))
+                return false;
+            slot.insert(0, nonce);
+            return true;
+        };
+    }
+    return [cipher, nonceSize](std::string& slot) {
+        if (slot.size() < nonceSize)
+            return false;
+        std::string sealed = slot.substr(nonceSize);
+        if (!EncryptionHelper::open(sealed, cipher.key, slot.substr(0, nonceSize), cipher.parameters))
+            return false;
+        slot.swap(sealed);
+        return true;
+    };
+}
+
+// A chunk is sealed under the nonce of the file followed by the chunk's file offset: a file is only ever
+// appended to (even by a checkpoint that stopped half-way), so no two chunks share a GCM nonce, and a chunk
+// cannot be moved. The tag also covers the encryption parameters of the header.
+SnapshotWriter::ChunkCipher Database::chunkCipher(const SnapshotCipher& cipher, bool sealing) {
+    if (cipher.key.empty())
+        return SnapshotWriter::ChunkCipher();
+    return [cipher, sealing](char* data, size_t size, uint64_t offset, char* tag) {
+        std::string nonce;
+        putU64(nonce, cipher.nonce);
+        putU64(nonce, offset);
+        return sealing ? EncryptionHelper::seal(data, size, cipher.key, nonce, cipher.parameters, tag)
+            : EncryptionHelper::open(data, size, cipher.key, nonce, cipher.parameters, tag);
+    };
+}
+
+// The records of the log are sealed with the log key of its snapshot.
+WriteAheadLog::Cipher Database::logCipher(const SnapshotCipher& cipher) {
+    WriteAheadLog::Cipher logged;
+    std::string aesKey = cipher.logKey;
+    if (aesKey.empty())
+        return logged;
+    logged.seal = [aesKey](char* data, size_t size, const std::string& nonce, const std::string& header, char* tag) {
+        return EncryptionHelper::seal(data, size, aesKey, nonce, header, tag);
+    };
+    logged.open = [aesKey](char* data, size_t size, const std::string& nonce, const std::string& header, char* tag) {
+        return EncryptionHelper::open(data, size, aesKey, nonce, header, tag);
+    };
+    return logged;
+}
 
 //---------------------------------------------------------------------
-// Simple XOR Encryption/Decryption (Demo Only)
+// Lazy Loading
 //---------------------------------------------------------------------
-std::string Database::encryptData(const std::string& data, const std::string& key) {
-    std::string encrypted = data;
-    for (size_t i = 0; i < data.size(); ++i) {
-        encrypted[i] = data[i] ^ key[i % key.size()];
+std::unique_ptr<SnapshotReader> Database::createReader(std::shared_ptr<MappedFile> file, const std::string& filename,
+    const std::string& key, SnapshotCipher* fileCipher) {
+    uint64_t size = file->size();
+    uint64_t prefixSize = SnapshotReader::PREFIX_SIZE;
+    std::string head(file->data(), file->data() + std::min(size, prefixSize));
+    std::string parameters;
+    uint32_t version = 0;
+    if (fileCipher)
+        *fileCipher = SnapshotCipher();
+    if (!SnapshotReader::readEncryption(head, parameters, version)) {
+        if (head.size() < prefixSize)
+            std::cerr << "Error: Snapshot is truncated or is not a database file." << std::endl;
+        else
+            std::cerr << "Error: " << filename << " is a snapshot of version " << version << ", which this build does "
+                << "not read (it reads version " << SnapshotReader::VERSION << ")." << std::endl;
+        return nullptr;
+    }
+
+    SnapshotCipher cipher;
+    if (parameters.empty() != key.empty() || !getCipher(key, parameters, cipher)) {
+        std::cerr << "Error: " << filename << " is not a database file, or the key is wrong." << std::endl;
+        return nullptr;
     }
-    return encrypted;
+    if (fileCipher)
+        *fileCipher = cipher;
+    // The reader fetches ranges straight out of the mapping; only the bytes it asks for are paged in, and of an
+    // encrypted snapshot only the chunks they fall in are opened.
+    return std::unique_ptr<SnapshotReader>(new SnapshotReader(size,
+        [file](uint64_t offset, size_t length, std::string& out) {
+            out.assign(file->data() + offset, length);
+        }, slotCipher(cipher, false), chunkCipher(cipher, false)));
 }
 
-std::string Database::decryptData(const std::string& data, const std::string& key) {
-    std::string decrypted = data;
-    for (size_t i = 0; i < data.size(); ++i) {
-        decrypted[i] = data[i] ^ key[i % key.size()];
+bool Database::reattachPendingTables(const std::string& filename, const std::string& key,
+    const std::unordered_map<std::string, size_t>& pending) {
+    auto file = std::make_shared<MappedFile>();
+    std::unique_ptr<SnapshotReader> reader;
+    if (file->open(filename)) {
+        reader = createReader(file, filename, key);
+        if (reader && !reader->open())
+            reader.reset();
+    }
+    if (reader) {
+        for (size_t i = 0; i < reader->getTableCount(); ++i) {
+            if (pending.count(reader->getTableName(i)) > 0)
+                pendingTables[reader->getTableName(i)] = i;
+        }
+    }
+    if (pendingTables.size() != pending.size()) {
+        std::cerr << "Error: Tables not accessed since the last load could not be read back from " << filename
+            << "; load the file again." << std::endl;
+        pendingTables.clear();
+        return false;
     }
-    return decrypted;
+    if (!pendingTables.empty())
+        snapshot = std::move(reader);
+    return true;
 }
@@ -2,12 +2,23 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <utility>
+#include <cstdint>
+#include "Condition.h"
+#include "Statement.h"
+#include "TableStorage.h"
+#include "WriteAheadLog.h"
+#include "Snapshot.h"
+#include "Checkpointer.h"
 
 // Forward declaration of Table to avoid circular dependency.
 class Table;
+class Schema;
+class MappedFile;
 
 /**
  * @brief The Database class represents the database system.
@@ -16,12 +27,15 @@ class Table;
  * - Manage a collection of tables.
  * - Perform basic operations (insert, select, update, delete) on tables; inputs are pre-parsed by the QueryProcessor.
  * - Load data from a file (with encryption) and flush data to a file.
+ * - Log every change made since the last flush to a write-ahead log next to the file, and replay it on load.
+ * - Optionally take checkpoints of that file on a background thread while statements go on.
  * - Manage relationships between tables through constraints.
  *
  * Usage:
  * - Obtain the database instance using getInstance().
  * - Add or retrieve tables by name.
  * - The insert, select, update, and delete functions are called by the QueryProcessor.
+ * - Every public function runs as one statement: statements are serialized with the background checkpointer.
  */
 class Database {
 public:
@@ -33,6 +47,13 @@ public:
 
     /**
      * @brief Load the database from a file using the provided encryption key.
+     *
+     * Reads the binary snapshot format written by flushToFile(); files in the older text format are imported as well.
+     * A snapshot is mapped into memory rather than read, and only its directory is decoded: each table is decoded
+     * on first access through getTable(), so the cost of a load does not grow with the size of the file, and
+     * tables that are never used are never decoded.
+     * The changes logged since the snapshot was written ("<filename>.wal") are then replayed, and later changes
+     * are appended to that log.
      * @param filename The file name.
      * @param key The encryption key.
      * @return true if successful; false otherwise.
@@ -41,6 +62,12 @@ public:
 
     /**
      * @brief Flush (save) the database to a file using the provided encryption key.
+     *
+     * The file holds a binary snapshot with one section per table (see SnapshotWriter). Tables still pending
+     * from a load are copied section by section without being decoded, and are read from the new file afterwards.
+     * A flush to the file the tables were loaded from or last flushed to appends a checkpoint instead: only the
+     * tables modified since are written, and the file is written anew only once most of it is no longer used.
+     * The snapshot includes every change so far, so an empty write-ahead log ("<filename>.wal") is started next to it.
      * @param filename The file name.
      * @param key The encryption key.
      * @return true if successful; false otherwise.
@@ -63,53 +90,127 @@ public:
     void addTable(const std::string& tableName, std::shared_ptr<Table> table);
 
     /**
-     * @brief Retrieve a table by its name.
+     * @brief Create an empty table.
      * @param tableName The table name.
-     * @return std::shared_ptr<Table> A pointer to the table, or nullptr if not found.
+     * @param schema The columns and constraints.
+     * @param layout The storage layout.
+     * @return true if the table was created; false if a table of that name exists.
+     */
+    bool createTable(const std::string& tableName, const Schema& schema, StorageLayout layout);
+
+    /**
+     * @brief Retrieve a table by its name, decoding it first if it is still pending from a load.
+     * @param tableName The table name.
+     * @return std::shared_ptr<Table> A pointer to the table, or nullptr if not found (or its section is invalid).
      */
     std::shared_ptr<Table> getTable(const std::string& tableName);
 
+    /**
+     * @brief Check whether a table exists, without decoding it.
+     * @param tableName The table name.
+     * @return true if the table exists; false otherwise.
+     */
+    bool hasTable(const std::string& tableName) const;
+
     /**
      * @brief Remove a table from the database.
      * @param tableName The table name.
      */
     bool dropTable(const std::string& tableName);
 
+    /**
+     * @brief Create a secondary index on a table.
+     * @param indexName The index name (unique across the database).
+     * @param tableName The table name.
+     * @param columns The indexed column(s), in key order.
+     * @return true if the index was created; false otherwise.
+     */
+    bool createIndex(const std::string& indexName, const std::string& tableName, const std::vector<std::string>& columns);
+
+    /**
+     * @brief Drop a secondary index from whichever table holds it.
+     * @param indexName The index name.
+     * @return true if the index was dropped; false if it does not exist.
+     */
+    bool dropIndex(const std::string& indexName);
+
+    /**
+     * @brief Drop a column from a table.
+     * @param tableName The table name.
+     * @param columnName The column name.
+     * @return true if the column was dropped; false otherwise.
+     */
+    bool dropColumn(const std::string& tableName, const std::string& columnName);
+
+    /**
+     * @brief Set when the write-ahead log forces changes to disk.
+     * @param policy The sync policy.
+     * @param interval The interval of the GROUP policy, in milliseconds.
+     */
+    void setSyncPolicy(SyncPolicy policy, unsigned interval = WriteAheadLog::DEFAULT_GROUP_INTERVAL);
+
+    /**
+     * @brief Set when checkpoints of the file last loaded or flushed are taken in the background.
+     *
+     * A background checkpoint captures the tables between two statements and writes the ones modified since the
+     * last checkpoint while statements go on; a table modified before it is written is copied first, so the
+     * checkpoint holds the tables as captured. The records of the write-ahead log it includes are then dropped.
+     * @param interval The time between two checkpoints, in milliseconds (0 for none).
+     * @param logSize The size of the write-ahead log that triggers a checkpoint, in bytes (0 for none).
+     */
+    void setCheckpointPolicy(unsigned interval, uint64_t logSize);
+
     // Functions called by QueryProcessor after parsing.
     /**
-     * @brief Insert a record into the specified table.
+     * @brief Insert one or more records into the specified table.
+     *
+     * All rows are converted and validated before any is inserted; if one fails, none is inserted.
      * @param tableName The table name.
      * @param columns A vector of column names.
-     * @param values A vector of corresponding values.
+     * @param rows One vector of literals, corresponding to the columns, per record.
+     * @param affected If not null, receives the number of records inserted.
      * @return true if insertion is successful; false otherwise.
      */
-    bool insert(const std::string& tableName, const std::vector<std::string>& columns, const std::vector<std::string>& values);
+    bool insert(const std::string& tableName, const std::vector<std::string>& columns,
+        const std::vector<std::vector<Literal>>& rows, size_t* affected = nullptr);
 
     /**
-     * @brief Select records from the specified table.
+     * @brief Select records from the specified table, or aggregates of them.
+     *
+     * With GROUP BY columns or an aggregate among the items, one row is selected per group (a single one
+     * without GROUP BY); a plain column item must then be a GROUP BY column.
      * @param tableName The table name.
-     * @param columns A vector of column names to retrieve (or \"*\" for all).
-     * @param condition A condition string.
+     * @param columns The items to retrieve: columns (or a single \"*\" for all) and aggregates.
+     * @param condition The WHERE condition.
+     * @param groupBy The columns to group by (none for no grouping).
+     * @param orderBy The item or column to order the result by (empty for table order, or group order).
+     * @param descending Whether to order in descending order.
+     * @param affected If not null, receives the number of records (or groups) selected.
      * @return true if selection is successful; false otherwise.
      */
-    bool select(const std::string& tableName, const std::vector<std::string>& columns, const std::string& condition);
+    bool select(const std::string& tableName, const std::vector<SelectItem>& columns, const Condition& condition,
+        const std::vector<std::string>& groupBy = {}, const std::string& orderBy = "", bool descending = false,
+        size_t* affected = nullptr);
 
     /**
      * @brief Update records in the specified table.
      * @param tableName The table name.
      * @param assignments A vector of (column, new value) pairs.
-     * @param condition A condition string.
-     * @return true if update is successful; false otherwise.
+     * @param condition The WHERE condition.
+     * @param affected If not null, receives the number of records updated.
+     * @return true if update is successful (even if no record matched); false otherwise.
      */
-    bool update(const std::string& tableName, const std::vector<std::pair<std::string, std::string>>& assignments, const std::string& condition);
+    bool update(const std::string& tableName, const std::vector<std::pair<std::string, Literal>>& assignments, const Condition& condition,
+        size_t* affected = nullptr);
 
     /**
      * @brief Delete records from the specified table.
      * @param tableName The table name.
-     * @param condition A condition string.
-     * @return true if deletion is successful; false otherwise.
+     * @param condition The WHERE condition.
+     * @param affected If not null, receives the number of records deleted.
+     * @return true if deletion is successful (even if no record matched); false otherwise.
      */
-    bool remove(const std::string& tableName, const std::string& condition);
+    bool remove(const std::string& tableName, const Condition& condition, size_t* affected = nullptr);
 
 private:
     // Private constructor and destructor for singleton pattern.
@@ -119,9 +220,139 @@ private:
     // Map of table names to Table objects.
     std::unordered_map<std::string, std::shared_ptr<Table>> tables;
 
+    // Tables of the loaded snapshot that have not been decoded yet, by name, with their directory position.
+    std::unordered_map<std::string, size_t> pendingTables;
+    // The snapshot the pending tables are read from (null once none is pending).
+    std::shared_ptr<SnapshotReader> snapshot;
+
+    // The section of a table in the checkpoint file, with the table version it holds (0 while the table is pending).
+    struct SavedSection {
+        SnapshotSection section;
+        uint64_t version;
+    };
+    // How a snapshot is encrypted: the parameters in its header (the salt of the key and the nonce of the file;
+    // empty if it is not encrypted), the AES key of the snapshot and the one of its log, both subkeys of the key
+    // derived from the passphrase.
+    struct SnapshotCipher {
+        std::string parameters;
+        std::string key;
+        std::string logKey;
+        uint64_t nonce = 0;
+    };
+    // The snapshot file the tables were last loaded from or flushed to, if it can take checkpoints.
+    struct Checkpoint {
+        std::string filename; // Empty if there is no such file.
+        std::string key;
+        SnapshotCipher cipher;
+        uint64_t generation = 0;
+        uint64_t fileSize = 0;
+        uint64_t liveSize = 0; // Bytes of the file the current checkpoint uses.
+        std::unordered_map<std::string, SavedSection> sections;
+        std::vector<SnapshotChunk> chunks; // The chunk table of the file, if it is encrypted.
+    };
+    Checkpoint checkpoint;
+
+    // One table of a checkpoint, as captured between two statements.
+    struct CapturedTable {
+        std::string name;
+        std::shared_ptr<const Table> table; // The table to write, if its section has to be written.
+        bool reuse;                         // Otherwise, whether to refer to its section where it is...
+        SnapshotSection section;
+        size_t pending;                     // ...or to copy the section of a pending table.
+        uint64_t version;                   // The table version the section holds (0 for a pending table).
+    };
+    // A checkpoint: captured between two statements, written (possibly on the background thread), then completed.
+    struct CheckpointJob {
+        std::string filename;
+        std::string key;
+        SnapshotCipher cipher;   // The encryption of the file: the file's own when appending, a new one otherwise.
+        bool append = false;     // Appended to the file, rather than written to a new file that replaces it.
+        uint64_t generation = 0;
+        uint64_t start = 0;      // The file offset the checkpoint is written at.
+        uint64_t logId = 0;      // The log that continues the checkpoint: the current one, or a new one.
+        uint64_t logPosition = 0;
+        uint64_t logSize = 0;    // The size of the current log at the capture.
+        std::vector<CapturedTable> tables;
+        std::shared_ptr<SnapshotReader> source; // The snapshot the pending sections are copied from.
+        std::vector<SnapshotChunk> chunks;      // The chunk table of the file appended to; then the one written.
+        // Filled in by writeCheckpoint().
+        std::vector<SnapshotSection> sections;
+        uint64_t fileSize = 0;
+        uint64_t liveSize = 0;
+        size_t rewritten = 0;
+    };
+
+    // The log of the changes made since the file was loaded or flushed (detached before either happens).
+    WriteAheadLog log;
+    // Apply one change read back from the log.
+    bool replayChange(const std::string& record);
+
     // Internal helper functions for encryption and decryption.
-    std::string encryptData(const std::string& data, const std::string& key);
-    std::string decryptData(const std::string& data, const std::string& key);
+    // Decrypt, in place, the chunk of a file written before AES encryption (the legacy XOR cipher).
+    void decryptLegacyChunk(std::string& chunk, uint64_t offset, const std::string& key);
+    // Get the cipher of a snapshot from its parameters, or of a new snapshot (parameters empty).
+    bool getCipher(const std::string& key, const std::string& parameters, SnapshotCipher& cipher);
+    // Derive the key of a passphrase and salt; the last key is remembered, so that a file loaded or flushed
+    // again with the same passphrase does not derive it again.
+    std::string deriveKey(const std::string& passphrase, const std::string& salt);
+    struct DerivedKey {
+        std::string passphrase;
+        std::string salt;
+        std::string key;
+    };
+    DerivedKey derivedKey;
+    // The ciphers of the checkpoint slots, of the chunks and of the write-ahead log next to a snapshot.
+    static SnapshotWriter::SlotCipher slotCipher(const SnapshotCipher& cipher, bool sealing);
+    static SnapshotWriter::ChunkCipher chunkCipher(const SnapshotCipher& cipher, bool sealing);
+    static WriteAheadLog::Cipher logCipher(const SnapshotCipher& cipher);
+
+    // Create a reader over a mapped snapshot that decrypts the ranges it fetches; null if the key does not
+    // fit the file. cipher, if not null, receives the encryption of the file.
+    std::unique_ptr<SnapshotReader> createReader(std::shared_ptr<MappedFile> file, const std::string& filename,
+        const std::string& key, SnapshotCipher* cipher = nullptr);
+    // Map a snapshot written by flushToFile() and make the given pending tables read from it.
+    bool reattachPendingTables(const std::string& filename, const std::string& key,
+        const std::unordered_map<std::string, size_t>& pending);
+    // Decode every pending table (for operations that look at all tables), in parallel.
+    bool loadPendingTables();
+    // Move a decoded table from the pending tables to the tables.
+    void adoptPendingTable(const std::string& tableName, const std::shared_ptr<Table>& table);
+    // Forget every table, decoded or pending.
+    void clearTables();
+
+    // Capture a checkpoint of every table: appended to the file if it can take one, written anew otherwise.
+    // keepLog continues the current log after the checkpoint instead of starting a new one.
+    void captureCheckpoint(const std::string& filename, const std::string& key, bool keepLog, CheckpointJob& job);
+    // Write a captured checkpoint to disk; reads nothing but the job, so it may run while statements go on.
+    bool writeCheckpoint(CheckpointJob& job);
+    // Make a written checkpoint the current one: replace the file if it was written anew, then shorten or
+    // restart the log.
+    bool completeCheckpoint(CheckpointJob& job, bool written);
+    // Record the checkpoint a job wrote, and which table version each of its sections holds.
+    void rememberCheckpoint(const CheckpointJob& job);
+    // Take a checkpoint of the checkpoint file if any table changed since the last one (background thread).
+    void runCheckpoint();
+    // Check whether every table still matches its section in the checkpoint file.
+    bool isCheckpointCurrent() const;
+    // Start an empty write-ahead log next to a snapshot just written.
+    bool startLog(const std::string& filename, const SnapshotCipher& cipher, uint64_t logId);
+    // Append a change to the write-ahead log, and wake the checkpointer if the log reached its size limit.
+    void logChange(const std::string& record);
+
+    // Statements and the background checkpointer take turns on the tables (recursive: replaying the log
+    // runs statements).
+    mutable std::recursive_mutex mutex;
+    // Held by a checkpoint from its capture to its completion, so that a FLUSH or LOAD waits for the one
+    // running in the background. Always taken before mutex.
+    std::mutex checkpointing;
+    // The tables the background checkpoint is writing; they are copied before being modified.
+    std::unordered_set<const Table*> frozenTables;
+    Checkpointer checkpointer;
+    // Get a table to modify, copying it first if the background checkpoint is writing it.
+    std::shared_ptr<Table> getWritableTable(const std::string& tableName);
+
+    // Read the decrypted content of a file in the legacy text format into a set of tables.
+    bool loadLegacyText(const std::string& decryptedData, std::unordered_map<std::string, std::shared_ptr<Table>>& loaded);
 
     // Disable copying.
     Database(const Database&) = delete;
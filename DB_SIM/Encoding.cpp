@@ -0,0 +1,94 @@
+﻿#include "Encoding.h"
+#include "Schema.h"
+#include "Constraint.h"
+
+namespace Encoding {
+
+    // Constraint kinds as stored in the encoding.
+    static const uint8_t CONSTRAINT_PRIMARY_KEY = 1;
+    static const uint8_t CONSTRAINT_UNIQUE = 2;
+    static const uint8_t CONSTRAINT_FOREIGN_KEY = 3;
+    // Column flags as stored in the encoding.
+    static const uint8_t COLUMN_NOT_NULL = 1;
+
+    void putSchema(std::string& out, const Schema& schema) {
+        const auto& columns = schema.getColumns();
+        putU32(out, static_cast<uint32_t>(columns.size()));
+        for (const auto& column : columns) {
+            putString(out, column.getName());
+            putU8(out, static_cast<uint8_t>(column.getType()));
+            putU8(out, column.isNullable() ? 0 : COLUMN_NOT_NULL);
+            putString(out, column.getDefaultValue());
+        }
+
+        // Constraints: a kind, the local columns and, for a foreign key, the referenced table and columns.
+        std::string constraints;
+        uint32_t constraintCount = 0;
+        for (const auto& constraint : schema.getConstraints()) {
+            if (auto pk = dynamic_cast<PrimaryKeyConstraint*>(constraint.get())) {
+                putU8(constraints, CONSTRAINT_PRIMARY_KEY);
+                putStrings(constraints, pk->getColumnNames());
+            }
+            else if (auto uq = dynamic_cast<UniqueConstraint*>(constraint.get())) {
+                putU8(constraints, CONSTRAINT_UNIQUE);
+                putStrings(constraints, uq->getColumnNames());
+            }
+            else if (auto fk = dynamic_cast<ForeignKeyConstraint*>(constraint.get())) {
+                putU8(constraints, CONSTRAINT_FOREIGN_KEY);
+                putStrings(constraints, fk->getColumnNames());
+                putString(constraints, fk->getReferencedTable());
+                putStrings(constraints, fk->getReferencedColumns());
+            }
+            else {
+                continue;
+            }
+            ++constraintCount;
+        }
+        putU32(out, constraintCount);
+        out.append(constraints);
+    }
+
+    bool readSchema(Cursor& cursor, Schema& schema) {
+        uint32_t columnCount = 0;
+        if (!cursor.u32(columnCount))
+            return false;
+        for (uint32_t i = 0; i < columnCount; ++i) {
+            std::string columnName;
+            uint8_t type = 0;
+            uint8_t flags = 0;
+            std::string defaultValue;
+            if (!cursor.string(columnName) || !cursor.u8(type) || type > static_cast<uint8_t>(DataType::STRING)
+                || !cursor.u8(flags) || (flags & ~COLUMN_NOT_NULL) != 0 || !cursor.string(defaultValue))
+                return false;
+            schema.addColumn(Column(columnName, static_cast<DataType>(type), (flags & COLUMN_NOT_NULL) == 0, defaultValue));
+        }
+
+        uint32_t constraintCount = 0;
+        if (!cursor.u32(constraintCount))
+            return false;
+        for (uint32_t i = 0; i < constraintCount; ++i) {
+            uint8_t kind = 0;
+            std::vector<std::string> columnNames;
+            if (!cursor.u8(kind) || !cursor.strings(columnNames))
+                return false;
+            if (kind == CONSTRAINT_PRIMARY_KEY) {
+                schema.addConstraint(std::make_shared<PrimaryKeyConstraint>(columnNames));
+            }
+            else if (kind == CONSTRAINT_UNIQUE) {
+                schema.addConstraint(std::make_shared<UniqueConstraint>(columnNames));
+            }
+            else if (kind == CONSTRAINT_FOREIGN_KEY) {
+                std::string referencedTable;
+                std::vector<std::string> referencedColumns;
+                if (!cursor.string(referencedTable) || !cursor.strings(referencedColumns))
+                    return false;
+                schema.addConstraint(std::make_shared<ForeignKeyConstraint>(columnNames, referencedTable, referencedColumns));
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace Encoding
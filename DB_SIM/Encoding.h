@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Schema;
+
+/**
+ * @brief The Encoding namespace holds the binary encoding shared by snapshots and the write-ahead log.
+ *
+ * Every integer is little-endian; every string is a uint32 length followed by its bytes.
+ *
+ * Usage:
+ * - The put functions append one value to a buffer.
+ * - A Cursor reads values back from a region and fails (returns false) instead of reading past its end.
+ * - putSchema() and readSchema() encode the columns and constraints of a table.
+ */
+namespace Encoding {
+
+    inline void putU8(std::string& out, uint8_t value) {
+        out.push_back(static_cast<char>(value));
+    }
+
+    inline void putU32(std::string& out, uint32_t value) {
+        char bytes[4];
+        for (int i = 0; i < 4; ++i)
+            bytes[i] = static_cast<char>(value >> (8 * i));
+        out.append(bytes, 4);
+    }
+
+    inline void putU64(std::string& out, uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i)
+            bytes[i] = static_cast<char>(value >> (8 * i));
+        out.append(bytes, 8);
+    }
+
+    inline void putString(std::string& out, const std::string& value) {
+        putU32(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    inline void putStrings(std::string& out, const std::vector<std::string>& values) {
+        putU32(out, static_cast<uint32_t>(values.size()));
+        for (const auto& value : values)
+            putString(out, value);
+    }
+
+    /**
+     * @brief A bounds-checked cursor over one region of encoded data.
+     */
+    struct Cursor {
+        const char* pos;
+        const char* end;
+
+        bool bytes(size_t count, const char*& start) {
+            if (static_cast<size_t>(end - pos) < count)
+                return false;
+            start = pos;
+            pos += count;
+            return true;
+        }
+
+        bool u8(uint8_t& value) {
+            const char* p;
+            if (!bytes(1, p))
+                return false;
+            value = static_cast<uint8_t>(*p);
+            return true;
+        }
+
+        bool u32(uint32_t& value) {
+            const char* p;
+            if (!bytes(4, p))
+                return false;
+            value = 0;
+            for (int i = 0; i < 4; ++i)
+                value |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+            return true;
+        }
+
+        bool u64(uint64_t& value) {
+            const char* p;
+            if (!bytes(8, p))
+                return false;
+            value = 0;
+            for (int i = 0; i < 8; ++i)
+                value |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+            return true;
+        }
+
+        bool string(std::string& value) {
+            uint32_t length;
+            const char* p;
+            if (!u32(length) || !bytes(length, p))
+                return false;
+            value.assign(p, length);
+            return true;
+        }
+
+        bool strings(std::vector<std::string>& values) {
+            uint32_t count;
+            if (!u32(count) || count > static_cast<size_t>(end - pos) / 4)
+                return false;
+            values.resize(count);
+            for (auto& value : values) {
+                if (!string(value))
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Append the columns and the constraints of a schema.
+     *
+     * Each column is its name, a uint8 type, uint8 flags (bit 0: NOT NULL) and its default value
+     * (empty if it has none).
+     * Each constraint is a uint8 kind (1 = PRIMARY KEY, 2 = UNIQUE, 3 = FOREIGN KEY) and its columns,
+     * followed for a foreign key by the referenced table and columns.
+     * @param out The buffer.
+     * @param schema The schema.
+     */
+    void putSchema(std::string& out, const Schema& schema);
+
+    /**
+     * @brief Read a schema written by putSchema().
+     * @param cursor The cursor, positioned at the schema.
+     * @param schema Receives the columns and constraints.
+     * @return true if the schema was read; false if the data is truncated or invalid.
+     */
+    bool readSchema(Cursor& cursor, Schema& schema);
+
+} // namespace Encoding
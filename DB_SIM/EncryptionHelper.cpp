@@ -0,0 +1,223 @@
+﻿#include "EncryptionHelper.h"
+
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <random>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define ENCRYPTION_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// EVP takes lengths as int: larger buffers go through it in pieces of this size.
+static const size_t MAX_PIECE = 1 << 30;
+static const size_t BLOCK_SIZE = 16;
+
+namespace {
+    struct ContextDeleter {
+        void operator()(EVP_CIPHER_CTX* context) const {
+            EVP_CIPHER_CTX_free(context);
+        }
+    };
+    using Context = std::unique_ptr<EVP_CIPHER_CTX, ContextDeleter>;
+}
+
+// Run data through an initialized context, in place.
+static bool update(EVP_CIPHER_CTX* context, bool encrypting, unsigned char* data, size_t size) {
+    for (size_t done = 0; done < size; ) {
+        int length = static_cast<int>(std::min(size - done, MAX_PIECE));
+        int out = 0;
+        int ok = encrypting ? EVP_EncryptUpdate(context, data + done, &out, data + done, length)
+            : EVP_DecryptUpdate(context, data + done, &out, data + done, length);
+        if (ok != 1 || out != length)
+            return false;
+        done += static_cast<size_t>(length);
+    }
+    return true;
+}
+
+// Start a GCM context with a key and a nonce of any length (a length other than 12 bytes must be set first).
+static bool start(EVP_CIPHER_CTX* context, bool encrypting, const std::string& key, const std::string& nonce) {
+    auto init = encrypting ? EVP_EncryptInit_ex : EVP_DecryptInit_ex;
+    return init(context, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) == 1
+        && EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(nonce.size()), nullptr) == 1
+        && init(context, nullptr, nullptr, reinterpret_cast<const unsigned char*>(key.data()),
+            reinterpret_cast<const unsigned char*>(nonce.data())) == 1;
+}
+
+// Feed associated data to a GCM context (its output is only the tag).
+static bool associate(EVP_CIPHER_CTX* context, bool encrypting, const std::string& associated) {
+    if (associated.empty())
+        return true;
+    int out = 0;
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(associated.data());
+    int length = static_cast<int>(associated.size());
+    return (encrypting ? EVP_EncryptUpdate(context, nullptr, &out, data, length)
+        : EVP_DecryptUpdate(context, nullptr, &out, data, length)) == 1;
+}
+
+void EncryptionHelper::initialize() {
+    OPENSSL_init_crypto(OPENSSL_INIT_ADD_ALL_CIPHERS | OPENSSL_INIT_ADD_ALL_DIGESTS, nullptr);
+}
+
+std::string EncryptionHelper::encrypt(const std::string& plainText, const std::string& key) {
+    std::string salt = randomBytes(SALT_SIZE);
+    std::string nonce = randomBytes(NONCE_SIZE);
+    std::string derived = deriveKey(key, salt);
+    std::string data = plainText;
+    if (derived.empty() || !seal(data, derived, nonce, std::string()))
+        return std::string();
+    return salt + nonce + data;
+}
+
+bool EncryptionHelper::decrypt(const std::string& cipherText, const std::string& key, std::string& plainText) {
+    if (cipherText.size() < SALT_SIZE + NONCE_SIZE + TAG_SIZE)
+        return false;
+    std::string derived = deriveKey(key, cipherText.substr(0, SALT_SIZE));
+    std::string data = cipherText.substr(SALT_SIZE + NONCE_SIZE);
+    if (derived.empty() || !open(data, derived, cipherText.substr(SALT_SIZE, NONCE_SIZE), std::string()))
+        return false;
+    plainText.swap(data);
+    return true;
+}
+
+std::string EncryptionHelper::deriveKey(const std::string& passphrase, const std::string& salt) {
+    std::string key(KEY_SIZE, '\0');
+    if (PKCS5_PBKDF2_HMAC(passphrase.data(), static_cast<int>(passphrase.size()),
+            reinterpret_cast<const unsigned char*>(salt.data()), static_cast<int>(salt.size()),
+            static_cast<int>(KEY_ITERATIONS), EVP_sha256(), static_cast<int>(KEY_SIZE),
+            reinterpret_cast<unsigned char*>(&key[0])) != 1) {
+        std::cerr << "Error: Cannot derive the encryption key." << std::endl;
+        return std::string();
+    }
+    return key;
+}
+
+std::string EncryptionHelper::deriveSubkey(const std::string& key, const std::string& label) {
+    std::string subkey(KEY_SIZE, '\0');
+    unsigned int length = 0;
+    if (HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), reinterpret_cast<const unsigned char*>(label.data()),
+            label.size(), reinterpret_cast<unsigned char*>(&subkey[0]), &length) == nullptr || length != KEY_SIZE) {
+        std::cerr << "Error: Cannot derive the encryption key." << std::endl;
+        return std::string();
+    }
+    return subkey;
+}
+
+bool EncryptionHelper::seal(std::string& data, const std::string& key, const std::string& nonce, const std::string& associated) {
+    char tag[TAG_SIZE];
+    if (!seal(&data[0], data.size(), key, nonce, associated, tag))
+        return false;
+    data.append(tag, TAG_SIZE);
+    return true;
+}
+
+bool EncryptionHelper::open(std::string& data, const std::string& key, const std::string& nonce, const std::string& associated) {
+    if (data.size() < TAG_SIZE)
+        return false;
+    std::string text = data.substr(0, data.size() - TAG_SIZE);
+    if (!open(&text[0], text.size(), key, nonce, associated, data.data() + text.size()))
+        return false;
+    data.swap(text);
+    return true;
+}
+
+bool EncryptionHelper::seal(char* data, size_t size, const std::string& key, const std::string& nonce,
+    const std::string& associated, char* tag) {
+    Context context(EVP_CIPHER_CTX_new());
+    unsigned char last[BLOCK_SIZE];
+    int out = 0;
+    bool sealed = context && key.size() == KEY_SIZE && nonce.size() >= NONCE_SIZE
+        && start(context.get(), true, key, nonce)
+        && associate(context.get(), true, associated)
+        && update(context.get(), true, reinterpret_cast<unsigned char*>(data), size)
+        && EVP_EncryptFinal_ex(context.get(), last, &out) == 1
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_GET_TAG, static_cast<int>(TAG_SIZE), tag) == 1;
+    if (!sealed)
+        std::cerr << "Error: Encryption failed." << std::endl;
+    return sealed;
+}
+
+bool EncryptionHelper::open(char* data, size_t size, const std::string& key, const std::string& nonce,
+    const std::string& associated, const char* tag) {
+    if (key.size() != KEY_SIZE || nonce.size() < NONCE_SIZE)
+        return false;
+    unsigned char expected[TAG_SIZE];
+    std::copy(tag, tag + TAG_SIZE, reinterpret_cast<char*>(expected));
+    Context context(EVP_CIPHER_CTX_new());
+    unsigned char last[BLOCK_SIZE];
+    int out = 0;
+    // A wrong tag fails the final step.
+    return context
+        && start(context.get(), false, key, nonce)
+        && associate(context.get(), false, associated)
+        && update(context.get(), false, reinterpret_cast<unsigned char*>(data), size)
+        && EVP_CIPHER_CTX_ctrl(context.get(), EVP_CTRL_GCM_SET_TAG, static_cast<int>(TAG_SIZE), expected) == 1
+        && EVP_DecryptFinal_ex(context.get(), last, &out) == 1;
+}
+
+bool EncryptionHelper::crypt(char* data, size_t size, const std::string& key, uint64_t nonce, uint64_t offset) {
+    if (size == 0)
+        return true;
+    // The counter block: the nonce, then the big-endian index of the block the offset falls in.
+    unsigned char counter[BLOCK_SIZE];
+    uint64_t block = offset / BLOCK_SIZE;
+    for (int i = 0; i < 8; ++i) {
+        counter[i] = static_cast<unsigned char>(nonce >> (8 * i));
+        counter[15 - i] = static_cast<unsigned char>(block >> (8 * i));
+    }
+    Context context(EVP_CIPHER_CTX_new());
+    unsigned char skipped[BLOCK_SIZE] = {};
+    bool done = context && key.size() == KEY_SIZE
+        && EVP_EncryptInit_ex(context.get(), EVP_aes_256_ctr(), nullptr,
+            reinterpret_cast<const unsigned char*>(key.data()), counter) == 1
+        // Skip the keystream bytes of the block that come before the offset.
+        && update(context.get(), true, skipped, static_cast<size_t>(offset % BLOCK_SIZE))
+        && update(context.get(), true, reinterpret_cast<unsigned char*>(data), size);
+    if (!done)
+        std::cerr << "Error: Encryption failed." << std::endl;
+    return done;
+}
+
+std::string EncryptionHelper::randomBytes(size_t count) {
+    std::string bytes(count, '\0');
+    if (count > 0 && RAND_bytes(reinterpret_cast<unsigned char*>(&bytes[0]), static_cast<int>(count)) != 1) {
+        // Fall back on the standard library's source, which is the same one on most platforms.
+        std::random_device device;
+        for (auto& byte : bytes)
+            byte = static_cast<char>(device());
+    }
+    return bytes;
+}
+
+uint64_t EncryptionHelper::newNonce() {
+    uint64_t nonce = 0;
+    while (nonce == 0) {
+        std::string bytes = randomBytes(8);
+        for (int i = 0; i < 8; ++i)
+            nonce |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+    }
+    return nonce;
+}
+
+bool EncryptionHelper::isHardwareAccelerated() {
+#ifdef ENCRYPTION_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 25)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") != 0;
+#endif
+#else
+    return false;
+#endif
+}
@@ -1,36 +1,177 @@
 ﻿#pragma once
 
 #include <string>
+#include <cstdint>
+#include <cstddef>
 
 /**
  * @brief The EncryptionHelper class provides functions for encrypting and decrypting data.
  *
  * Responsibilities:
- * - Encrypt data before saving to a file.
- * - Decrypt data when loading from a file.
+ * - Derive a 256-bit key from a passphrase (PBKDF2-HMAC-SHA256, with a random salt kept next to the data),
+ *   and subkeys from it, one per purpose (HMAC-SHA256).
+ * - Encrypt and authenticate messages with AES-256-GCM: encrypt() and decrypt() for a self-contained message
+ *   under a passphrase, seal() and open() under a derived key and an explicit nonce.
+ * - Encrypt file contents by offset with AES-256 in counter mode (crypt()), the keystream GCM is built on:
+ *   any range of a file can be encrypted or decrypted on its own, so a mapped file is decrypted only where
+ *   it is read, and a file can be appended to.
  *
- * Note:
- * - You may use libraries such as OpenSSL or Crypto++ to implement robust encryption algorithms (e.g., AES-256).
+ * The ciphers come from OpenSSL's EVP interface, which uses the AES-NI and carry-less multiply instructions
+ * where the processor has them. Counter mode needs a nonce that is never used twice with the same key for
+ * the same offset, so every file gets a new nonce when it is written anew.
  *
  * Usage:
  * - Call encrypt() with the plaintext and key to obtain the ciphertext.
- * - Call decrypt() with the ciphertext and key to obtain the plaintext.
+ * - Call decrypt() with the ciphertext and key to obtain the plaintext; it fails if either was altered.
  */
 class EncryptionHelper {
 public:
+    /**
+     * @brief The size of a derived key in bytes (AES-256).
+     */
+    static const size_t KEY_SIZE = 32;
+
+    /**
+     * @brief The size of the salt a key is derived with.
+     */
+    static const size_t SALT_SIZE = 16;
+
+    /**
+     * @brief The size of a GCM nonce.
+     */
+    static const size_t NONCE_SIZE = 12;
+
+    /**
+     * @brief The size of a GCM authentication tag.
+     */
+    static const size_t TAG_SIZE = 16;
+
+    /**
+     * @brief The number of PBKDF2 iterations a key is derived with.
+     */
+    static const unsigned KEY_ITERATIONS = 100000;
+
+    /**
+     * @brief Initialize the cipher library.
+     *
+     * The library shuts itself down at exit, before whatever was constructed after it was first used; an object
+     * that uses it from a thread of its own calls this from its constructor, so that the library outlives it.
+     */
+    static void initialize();
+
     /**
      * @brief Encrypt the given plaintext using the provided key.
+     *
+     * The ciphertext holds everything decrypt() needs besides the key: the salt, the nonce, the encrypted
+     * plaintext and the authentication tag.
      * @param plainText The plaintext to encrypt.
-     * @param key The encryption key.
-     * @return std::string The encrypted ciphertext.
+     * @param key The encryption key (a passphrase of any length).
+     * @return std::string The encrypted ciphertext, or an empty string if the cipher failed.
      */
     static std::string encrypt(const std::string& plainText, const std::string& key);
 
     /**
      * @brief Decrypt the given ciphertext using the provided key.
-     * @param cipherText The ciphertext to decrypt.
+     * @param cipherText The ciphertext, as returned by encrypt().
      * @param key The decryption key.
-     * @return std::string The decrypted plaintext.
+     * @param plainText Receives the decrypted plaintext.
+     * @return true if the ciphertext was decrypted; false if it is damaged or the key is wrong.
+     */
+    static bool decrypt(const std::string& cipherText, const std::string& key, std::string& plainText);
+
+    /**
+     * @brief Derive an AES-256 key from a passphrase.
+     * @param passphrase The passphrase.
+     * @param salt The salt (SALT_SIZE random bytes, stored with the data).
+     * @return std::string The KEY_SIZE-byte key, or an empty string if the derivation failed.
+     */
+    static std::string deriveKey(const std::string& passphrase, const std::string& salt);
+
+    /**
+     * @brief Derive a key for one purpose from a derived key (HMAC-SHA256 of a label), so that no two purposes
+     * share a key, and nothing computed with one tells anything about the others.
+     * @param key The key derived from the passphrase.
+     * @param label The purpose of the subkey.
+     * @return std::string The KEY_SIZE-byte subkey, or an empty string if the derivation failed.
+     */
+    static std::string deriveSubkey(const std::string& key, const std::string& label);
+
+    /**
+     * @brief Encrypt and authenticate data in place with AES-256-GCM, appending the tag.
+     * @param data The plaintext; receives the ciphertext followed by the tag.
+     * @param key A KEY_SIZE-byte key.
+     * @param nonce A NONCE_SIZE-byte nonce, never used twice with the key.
+     * @param associated Data the tag covers without it being encrypted (e.g. a file header).
+     * @return true if the data was sealed; false if the cipher failed.
+     */
+    static bool seal(std::string& data, const std::string& key, const std::string& nonce, const std::string& associated);
+
+    /**
+     * @brief Check and decrypt data in place that seal() produced, removing the tag.
+     * @param data The ciphertext followed by the tag; receives the plaintext.
+     * @param key The key.
+     * @param nonce The nonce the data was sealed with.
+     * @param associated The associated data it was sealed with.
+     * @return true if the data is authentic; false if it, the key or the associated data differ.
+     */
+    static bool open(std::string& data, const std::string& key, const std::string& nonce, const std::string& associated);
+
+    /**
+     * @brief Encrypt and authenticate a buffer in place with AES-256-GCM, keeping the tag apart from it.
+     * @param data The plaintext; receives the ciphertext.
+     * @param size The size of the buffer.
+     * @param key A KEY_SIZE-byte key.
+     * @param nonce A nonce never used twice with the key: NONCE_SIZE bytes, or longer (GCM then hashes it).
+     * @param associated Data the tag covers without it being encrypted.
+     * @param tag Receives the TAG_SIZE-byte tag.
+     * @return true if the buffer was sealed; false if the cipher failed.
+     */
+    static bool seal(char* data, size_t size, const std::string& key, const std::string& nonce, const std::string& associated,
+        char* tag);
+
+    /**
+     * @brief Check and decrypt a buffer in place that the other seal() produced.
+     * @param data The ciphertext; receives the plaintext (left undefined if it is not authentic).
+     * @param size The size of the buffer.
+     * @param key The key.
+     * @param nonce The nonce the buffer was sealed with.
+     * @param associated The associated data it was sealed with.
+     * @param tag The tag seal() returned.
+     * @return true if the buffer is authentic; false otherwise.
+     */
+    static bool open(char* data, size_t size, const std::string& key, const std::string& nonce, const std::string& associated,
+        const char* tag);
+
+    /**
+     * @brief Encrypt or decrypt, in place, a range of a file with AES-256 in counter mode.
+     *
+     * The keystream at file offset o is block o / 16 of the counter that starts from the nonce, so a range
+     * gives the same bytes however the file is split into calls.
+     * @param data The bytes of the range.
+     * @param size The size of the range.
+     * @param key A KEY_SIZE-byte key.
+     * @param nonce The nonce of the file.
+     * @param offset The file offset of the first byte.
+     * @return true if the range was transformed; false if the cipher failed.
+     */
+    static bool crypt(char* data, size_t size, const std::string& key, uint64_t nonce, uint64_t offset);
+
+    /**
+     * @brief Get random bytes from the operating system's generator, e.g. for a salt or a nonce.
+     * @param count The number of bytes.
+     * @return std::string The bytes.
+     */
+    static std::string randomBytes(size_t count);
+
+    /**
+     * @brief Get a random, nonzero file nonce for crypt().
+     * @return uint64_t The nonce.
+     */
+    static uint64_t newNonce();
+
+    /**
+     * @brief Check whether the processor has the AES instructions OpenSSL uses.
+     * @return true if AES runs in hardware; false otherwise.
      */
-    static std::string decrypt(const std::string& cipherText, const std::string& key);
+    static bool isHardwareAccelerated();
 };
@@ -0,0 +1,345 @@
+﻿#include "FilterKernels.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define FILTER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+// MSVC accepts the AVX2 and SSE4.2 intrinsics in any function.
+#define TARGET_AVX2
+#define TARGET_SSE42
+#else
+// GCC and Clang compile the intrinsics only in functions that target the instructions; the build itself may not.
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace FilterKernels {
+
+    // The comparisons the kernels run; the other operators are their complements.
+    enum class Base {
+        EQUAL,
+        LESS,
+        GREATER,
+    };
+
+    // Get the comparison an operator is run as, and whether its bits are inverted afterwards.
+    static Base toBase(Predicate::Op op, bool& inverted) {
+        inverted = op == Predicate::Op::NOT_EQUAL || op == Predicate::Op::GREATER_EQUAL || op == Predicate::Op::LESS_EQUAL;
+        switch (op) {
+        case Predicate::Op::EQUAL:
+        case Predicate::Op::NOT_EQUAL:
+            return Base::EQUAL;
+        case Predicate::Op::LESS:
+        case Predicate::Op::GREATER_EQUAL:
+            return Base::LESS;
+        default:
+            return Base::GREATER;
+        }
+    }
+
+    // Invert the bits of count values, keeping the bits past the last one clear.
+    static void invert(uint64_t* bits, size_t count) {
+        size_t words = (count + 63) / 64;
+        for (size_t word = 0; word < words; ++word)
+            bits[word] = ~bits[word];
+        if (count % 64 != 0)
+            bits[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+    }
+
+    template <Base B, typename T>
+    static bool test(T value, T bound) {
+        return B == Base::EQUAL ? value == bound : B == Base::LESS ? value < bound : value > bound;
+    }
+
+    // The scalar kernels, which also finish the values past the last full word for the others.
+    template <Base B, typename T>
+    static void scalarCompare(const T* values, size_t count, T bound, uint64_t* bits) {
+        for (size_t word = 0; word * 64 < count; ++word) {
+            const T* v = values + word * 64;
+            size_t n = std::min(count - word * 64, size_t(64));
+            uint64_t w = 0;
+            for (size_t i = 0; i < n; ++i)
+                w |= uint64_t(test<B>(v[i], bound)) << i;
+            bits[word] = w;
+        }
+    }
+
+    // Set the bits of the values outside [low, high]; BETWEEN is the complement.
+    template <typename T>
+    static void scalarOutside(const T* values, size_t count, T low, T high, uint64_t* bits) {
+        for (size_t word = 0; word * 64 < count; ++word) {
+            const T* v = values + word * 64;
+            size_t n = std::min(count - word * 64, size_t(64));
+            uint64_t w = 0;
+            for (size_t i = 0; i < n; ++i)
+                w |= uint64_t((v[i] < low) | (v[i] > high)) << i;
+            bits[word] = w;
+        }
+    }
+
+#ifdef FILTER_X86
+    static bool detectAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        // The instructions are usable only if the operating system saves the AVX registers (OSXSAVE and XCR0).
+        if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+
+    static bool detectSse42() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+    }
+
+    // AVX2: four values per comparison, one bit per value out of the sign bits of the result.
+    TARGET_AVX2 static inline __m256i load4(const int64_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    TARGET_AVX2 static inline __m256d load4(const double* p) {
+        return _mm256_loadu_pd(p);
+    }
+
+    TARGET_AVX2 static inline __m256i broadcast4(int64_t value) {
+        return _mm256_set1_epi64x(value);
+    }
+
+    TARGET_AVX2 static inline __m256d broadcast4(double value) {
+        return _mm256_set1_pd(value);
+    }
+
+    template <Base B>
+    TARGET_AVX2 static inline uint64_t test4(__m256i v, __m256i bound) {
+        __m256i r = B == Base::EQUAL ? _mm256_cmpeq_epi64(v, bound)
+            : B == Base::LESS ? _mm256_cmpgt_epi64(bound, v) : _mm256_cmpgt_epi64(v, bound);
+        return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(r)));
+    }
+
+    template <Base B>
+    TARGET_AVX2 static inline uint64_t test4(__m256d v, __m256d bound) {
+        __m256d r = B == Base::EQUAL ? _mm256_cmp_pd(v, bound, _CMP_EQ_OQ)
+            : B == Base::LESS ? _mm256_cmp_pd(v, bound, _CMP_LT_OQ) : _mm256_cmp_pd(v, bound, _CMP_GT_OQ);
+        return static_cast<uint64_t>(_mm256_movemask_pd(r));
+    }
+
+    template <Base B, typename T>
+    TARGET_AVX2 static void avx2Compare(const T* values, size_t count, T bound, uint64_t* bits) {
+        auto b = broadcast4(bound);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            const T* v = values + word * 64;
+            uint64_t w = 0;
+            for (size_t i = 0; i < 64; i += 4)
+                w |= test4<B>(load4(v + i), b) << i;
+            bits[word] = w;
+        }
+        scalarCompare<B>(values + words * 64, count % 64, bound, bits + words);
+    }
+
+    template <typename T>
+    TARGET_AVX2 static void avx2Outside(const T* values, size_t count, T low, T high, uint64_t* bits) {
+        auto l = broadcast4(low);
+        auto h = broadcast4(high);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            const T* v = values + word * 64;
+            uint64_t w = 0;
+            for (size_t i = 0; i < 64; i += 4) {
+                auto x = load4(v + i);
+                w |= (test4<Base::LESS>(x, l) | test4<Base::GREATER>(x, h)) << i;
+            }
+            bits[word] = w;
+        }
+        scalarOutside(values + words * 64, count % 64, low, high, bits + words);
+    }
+
+    // SSE4.2 (for the 64-bit integer comparisons): two values per comparison.
+    TARGET_SSE42 static inline __m128i load2(const int64_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    TARGET_SSE42 static inline __m128d load2(const double* p) {
+        return _mm_loadu_pd(p);
+    }
+
+    TARGET_SSE42 static inline __m128i broadcast2(int64_t value) {
+        return _mm_set1_epi64x(value);
+    }
+
+    TARGET_SSE42 static inline __m128d broadcast2(double value) {
+        return _mm_set1_pd(value);
+    }
+
+    template <Base B>
+    TARGET_SSE42 static inline uint64_t test2(__m128i v, __m128i bound) {
+        __m128i r = B == Base::EQUAL ? _mm_cmpeq_epi64(v, bound)
+            : B == Base::LESS ? _mm_cmpgt_epi64(bound, v) : _mm_cmpgt_epi64(v, bound);
+        return static_cast<uint64_t>(_mm_movemask_pd(_mm_castsi128_pd(r)));
+    }
+
+    template <Base B>
+    TARGET_SSE42 static inline uint64_t test2(__m128d v, __m128d bound) {
+        __m128d r = B == Base::EQUAL ? _mm_cmpeq_pd(v, bound)
+            : B == Base::LESS ? _mm_cmplt_pd(v, bound) : _mm_cmpgt_pd(v, bound);
+        return static_cast<uint64_t>(_mm_movemask_pd(r));
+    }
+
+    template <Base B, typename T>
+    TARGET_SSE42 static void sse42Compare(const T* values, size_t count, T bound, uint64_t* bits) {
+        auto b = broadcast2(bound);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            const T* v = values + word * 64;
+            uint64_t w = 0;
+            for (size_t i = 0; i < 64; i += 2)
+                w |= test2<B>(load2(v + i), b) << i;
+            bits[word] = w;
+        }
+        scalarCompare<B>(values + words * 64, count % 64, bound, bits + words);
+    }
+
+    template <typename T>
+    TARGET_SSE42 static void sse42Outside(const T* values, size_t count, T low, T high, uint64_t* bits) {
+        auto l = broadcast2(low);
+        auto h = broadcast2(high);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            const T* v = values + word * 64;
+            uint64_t w = 0;
+            for (size_t i = 0; i < 64; i += 2) {
+                auto x = load2(v + i);
+                w |= (test2<Base::LESS>(x, l) | test2<Base::GREATER>(x, h)) << i;
+            }
+            bits[word] = w;
+        }
+        scalarOutside(values + words * 64, count % 64, low, high, bits + words);
+    }
+#endif
+
+    template <Base B, typename T>
+    static void compareBase(const T* values, size_t count, T bound, uint64_t* bits, InstructionSet set) {
+        switch (set) {
+#ifdef FILTER_X86
+        case InstructionSet::AVX2:
+            avx2Compare<B>(values, count, bound, bits);
+            return;
+        case InstructionSet::SSE42:
+            sse42Compare<B>(values, count, bound, bits);
+            return;
+#endif
+        default:
+            scalarCompare<B>(values, count, bound, bits);
+            return;
+        }
+    }
+
+    template <typename T>
+    static void compareValues(const T* values, size_t count, Predicate::Op op, T bound, uint64_t* bits, InstructionSet set) {
+        bool inverted = false;
+        switch (toBase(op, inverted)) {
+        case Base::EQUAL:
+            compareBase<Base::EQUAL>(values, count, bound, bits, set);
+            break;
+        case Base::LESS:
+            compareBase<Base::LESS>(values, count, bound, bits, set);
+            break;
+        default:
+            compareBase<Base::GREATER>(values, count, bound, bits, set);
+            break;
+        }
+        if (inverted)
+            invert(bits, count);
+    }
+
+    template <typename T>
+    static void betweenValues(const T* values, size_t count, T low, T high, uint64_t* bits, InstructionSet set) {
+        switch (set) {
+#ifdef FILTER_X86
+        case InstructionSet::AVX2:
+            avx2Outside(values, count, low, high, bits);
+            break;
+        case InstructionSet::SSE42:
+            sse42Outside(values, count, low, high, bits);
+            break;
+#endif
+        default:
+            scalarOutside(values, count, low, high, bits);
+            break;
+        }
+        invert(bits, count);
+    }
+
+    // Get the index of the lowest bit set in a word that is not zero.
+    static inline unsigned lowestBit(uint64_t word) {
+#ifdef _MSC_VER
+        unsigned long index;
+#if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanForward64(&index, word);
+#else
+        if (!_BitScanForward(&index, static_cast<unsigned long>(word))) {
+            _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+            index += 32;
+        }
+#endif
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+    }
+
+    InstructionSet getInstructionSet() {
+#ifdef FILTER_X86
+        static const InstructionSet set = detectAvx2() ? InstructionSet::AVX2
+            : detectSse42() ? InstructionSet::SSE42 : InstructionSet::SCALAR;
+        return set;
+#else
+        return InstructionSet::SCALAR;
+#endif
+    }
+
+    void compare(const int64_t* values, size_t count, Predicate::Op op, int64_t bound, uint64_t* bits, InstructionSet set) {
+        compareValues(values, count, op, bound, bits, set);
+    }
+
+    void compare(const double* values, size_t count, Predicate::Op op, double bound, uint64_t* bits, InstructionSet set) {
+        compareValues(values, count, op, bound, bits, set);
+    }
+
+    void between(const int64_t* values, size_t count, int64_t low, int64_t high, uint64_t* bits, InstructionSet set) {
+        betweenValues(values, count, low, high, bits, set);
+    }
+
+    void between(const double* values, size_t count, double low, double high, uint64_t* bits, InstructionSet set) {
+        betweenValues(values, count, low, high, bits, set);
+    }
+
+    size_t toSelection(const uint64_t* bits, size_t count, uint16_t* selected) {
+        size_t kept = 0;
+        for (size_t word = 0; word * 64 < count; ++word) {
+            for (uint64_t w = bits[word]; w != 0; w &= w - 1)
+                selected[kept++] = static_cast<uint16_t>(word * 64 + lowestBit(w));
+        }
+        return kept;
+    }
+
+} // namespace FilterKernels
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "Predicate.h"
+
+/**
+ * @brief The FilterKernels namespace compares arrays of numbers with a bound, producing one bit per value.
+ *
+ * Usage:
+ * - compare() and between() set bit i of bits (word i / 64, bit i % 64) when values[i] matches, like the
+ *   null bitmaps of ColumnVector; the bits past the last value are cleared. They read the values only: NULL
+ *   slots are tested like any value and are for the caller to clear.
+ * - toSelection() turns such bits into the ascending indexes of the bits set.
+ *
+ * On x86-64 processors the comparisons run on four values at a time with AVX2 or on two with SSE4.2,
+ * whichever the processor supports (detected once, at the first call); elsewhere a scalar loop is used. All
+ * give the same bits: a FLOAT value is never NaN, so every operator is exact in every variant.
+ */
+namespace FilterKernels {
+
+    /**
+     * @brief Enumeration for the variants of the kernels.
+     */
+    enum class InstructionSet {
+        SCALAR,
+        SSE42,
+        AVX2,
+    };
+
+    /**
+     * @brief Get the fastest variant the processor supports.
+     * @return InstructionSet The variant used by default.
+     */
+    InstructionSet getInstructionSet();
+
+    /**
+     * @brief Compare integers with a bound.
+     * @param values The values.
+     * @param count The number of values.
+     * @param op The operator (value op bound).
+     * @param bound The bound.
+     * @param bits The bits to set, (count + 63) / 64 words.
+     * @param set The variant to run (one the processor supports).
+     */
+    void compare(const int64_t* values, size_t count, Predicate::Op op, int64_t bound, uint64_t* bits,
+        InstructionSet set = getInstructionSet());
+
+    /**
+     * @brief Compare floating-point numbers with a bound.
+     * @param values The values (not NaN).
+     * @param count The number of values.
+     * @param op The operator (value op bound).
+     * @param bound The bound.
+     * @param bits The bits to set, (count + 63) / 64 words.
+     * @param set The variant to run (one the processor supports).
+     */
+    void compare(const double* values, size_t count, Predicate::Op op, double bound, uint64_t* bits,
+        InstructionSet set = getInstructionSet());
+
+    /**
+     * @brief Test integers for low <= value <= high.
+     * @param values The values.
+     * @param count The number of values.
+     * @param low The low bound.
+     * @param high The high bound.
+     * @param bits The bits to set, (count + 63) / 64 words.
+     * @param set The variant to run (one the processor supports).
+     */
+    void between(const int64_t* values, size_t count, int64_t low, int64_t high, uint64_t* bits,
+        InstructionSet set = getInstructionSet());
+
+    /**
+     * @brief Test floating-point numbers for low <= value <= high.
+     * @param values The values (not NaN).
+     * @param count The number of values.
+     * @param low The low bound.
+     * @param high The high bound.
+     * @param bits The bits to set, (count + 63) / 64 words.
+     * @param set The variant to run (one the processor supports).
+     */
+    void between(const double* values, size_t count, double low, double high, uint64_t* bits,
+        InstructionSet set = getInstructionSet());
+
+    /**
+     * @brief Write the indexes of the bits set, in ascending order.
+     * @param bits The bits, (count + 63) / 64 words; the bits past count must be clear.
+     * @param count The number of bits.
+     * @param selected The indexes to write (room for count).
+     * @return size_t The number of indexes written.
+     */
+    size_t toSelection(const uint64_t* bits, size_t count, uint16_t* selected);
+
+} // namespace FilterKernels
@@ -0,0 +1,106 @@
+﻿#include "HashIndex.h"
+#include <algorithm>
+
+HashIndex::HashIndex(const std::vector<std::string>& columnNames, const std::vector<size_t>& ordinals, bool primary)
+    : columnNames(columnNames), ordinals(ordinals), primary(primary)
+{
+    // Entries are added by the owning Table.
+}
+
+HashIndex::~HashIndex() {
+    // No dynamic resources to release.
+}
+
+// Value encodings are self-delimiting, so composite keys are plain concatenations.
+bool HashIndex::makeKey(const Record& record, std::string& key) const {
+    key.clear();
+    for (size_t ordinal : ordinals) {
+        const Value& value = record.getValue(ordinal);
+        if (value.isNull())
+            return false;
+        value.appendKey(key);
+    }
+    return true;
+}
+
+bool HashIndex::makeKey(const TableStorage& storage, size_t row, std::string& key) const {
+    key.clear();
+    for (size_t ordinal : ordinals) {
+        Value value = storage.getValue(row, ordinal);
+        if (value.isNull())
+            return false;
+        value.appendKey(key);
+    }
+    return true;
+}
+
+bool HashIndex::makeKey(const std::vector<Value>& values, std::string& key) const {
+    key.clear();
+    for (const auto& value : values) {
+        if (value.isNull())
+            return false;
+        value.appendKey(key);
+    }
+    return true;
+}
+
+bool HashIndex::contains(const std::string& key) const {
+    return entries.find(key) != entries.end();
+}
+
+bool HashIndex::find(const std::string& key, size_t& position) const {
+    auto it = entries.find(key);
+    if (it == entries.end())
+        return false;
+    position = it->second;
+    return true;
+}
+
+void HashIndex::insert(const std::string& key, size_t position) {
+    entries[key] = position;
+}
+
+void HashIndex::erase(const std::string& key) {
+    entries.erase(key);
+}
+
+void HashIndex::clear() {
+    entries.clear();
+}
+
+void HashIndex::reserve(size_t count) {
+    // Grow geometrically so that a run of small batches does not rehash on every call.
+    size_t needed = entries.size() + count;
+    if (needed > entries.bucket_count() * entries.max_load_factor())
+        entries.reserve(std::max(needed, entries.size() * 2));
+}
+
+bool HashIndex::rebuild(const TableStorage& storage) {
+    entries.clear();
+    entries.reserve(storage.size());
+    std::string key;
+    size_t keyed = 0;
+    for (size_t i = 0; i < storage.size(); ++i) {
+        if (makeKey(storage, i, key)) {
+            entries[key] = i;
+            ++keyed;
+        }
+    }
+    return entries.size() == keyed;
+}
+
+const std::vector<std::string>& HashIndex::getColumnNames() const {
+    return columnNames;
+}
+
+const std::vector<size_t>& HashIndex::getOrdinals() const {
+    return ordinals;
+}
+
+void HashIndex::setOrdinals(const std::vector<size_t>& ordinals) {
+    this->ordinals = ordinals;
+}
+
+bool HashIndex::isPrimary() const {
+    return primary;
+}
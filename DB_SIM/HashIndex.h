@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "TableStorage.h"
+
+/**
+ * @brief The HashIndex class maps the key of a PRIMARY KEY or UNIQUE constraint to a record position.
+ *
+ * Responsibilities:
+ * - Builds a composite key from the typed values of the indexed column(s) of a record.
+ * - Provides O(1) duplicate detection and point lookups on that key.
+ * - Records with a NULL key value are not indexed (NULLs never collide, as in SQL).
+ *
+ * Usage:
+ * - The Table creates one HashIndex per PrimaryKeyConstraint/UniqueConstraint in its schema.
+ * - Build the key of a record with makeKey(), then use contains(), find(), insert() and erase().
+ * - Call rebuild() after records have been moved (e.g. after a deletion compacted the table storage).
+ */
+class HashIndex {
+public:
+    /**
+     * @brief Construct a new HashIndex object.
+     * @param columnNames The indexed column(s), in key order.
+     * @param ordinals The ordinals of the indexed column(s) in the table schema.
+     * @param primary Whether the index backs a primary key (true) or a unique constraint (false).
+     */
+    HashIndex(const std::vector<std::string>& columnNames, const std::vector<size_t>& ordinals, bool primary);
+
+    /**
+     * @brief Destroy the HashIndex object.
+     */
+    ~HashIndex();
+
+    /**
+     * @brief Build the composite key of a record.
+     * @param record The record.
+     * @param key Receives the encoded key.
+     * @return true if no indexed value is NULL; false otherwise.
+     */
+    bool makeKey(const Record& record, std::string& key) const;
+
+    /**
+     * @brief Build the composite key of a stored row.
+     * @param storage The table storage.
+     * @param row The row position.
+     * @param key Receives the encoded key.
+     * @return true if no indexed value is NULL; false otherwise.
+     */
+    bool makeKey(const TableStorage& storage, size_t row, std::string& key) const;
+
+    /**
+     * @brief Build the composite key from values given in index column order.
+     * @param values The key values.
+     * @param key Receives the encoded key.
+     * @return true if no value is NULL; false otherwise.
+     */
+    bool makeKey(const std::vector<Value>& values, std::string& key) const;
+
+    /**
+     * @brief Check whether a key is present in the index.
+     * @param key The encoded key.
+     * @return true if found; false otherwise.
+     */
+    bool contains(const std::string& key) const;
+
+    /**
+     * @brief Look up the record position stored for a key.
+     * @param key The encoded key.
+     * @param position Receives the record position if found.
+     * @return true if found; false otherwise.
+     */
+    bool find(const std::string& key, size_t& position) const;
+
+    /**
+     * @brief Add or replace the entry for a key.
+     * @param key The encoded key.
+     * @param position The record position.
+     */
+    void insert(const std::string& key, size_t position);
+
+    /**
+     * @brief Remove the entry for a key, if present.
+     * @param key The encoded key.
+     */
+    void erase(const std::string& key);
+
+    /**
+     * @brief Remove all entries.
+     */
+    void clear();
+
+    /**
+     * @brief Make room for a number of additional entries.
+     * @param count The number of entries about to be inserted.
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Rebuild the index from scratch; records with a NULL key value are skipped.
+     * @param storage The rows of the table.
+     * @return true if every key is unique; false if two records share one (the later position is kept).
+     */
+    bool rebuild(const TableStorage& storage);
+
+    /**
+     * @brief Get the indexed column names.
+     * @return const std::vector<std::string>& The column names.
+     */
+    const std::vector<std::string>& getColumnNames() const;
+
+    /**
+     * @brief Get the ordinals of the indexed columns.
+     * @return const std::vector<size_t>& The column ordinals.
+     */
+    const std::vector<size_t>& getOrdinals() const;
+
+    /**
+     * @brief Re-point the index at new column ordinals after the schema changed.
+     * @param ordinals The new column ordinals.
+     */
+    void setOrdinals(const std::vector<size_t>& ordinals);
+
+    /**
+     * @brief Check whether the index backs a primary key.
+     * @return true for a primary key; false for a unique constraint.
+     */
+    bool isPrimary() const;
+
+private:
+    std::vector<std::string> columnNames;
+    std::vector<size_t> ordinals;
+    bool primary;
+    std::unordered_map<std::string, size_t> entries; // Encoded key -> record position.
+};
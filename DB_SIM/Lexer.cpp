@@ -0,0 +1,157 @@
+﻿#include "Lexer.h"
+#include <cctype>
+
+static bool isIdentifierStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool isIdentifierPart(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+Lexer::Lexer(const std::string& input)
+    : input(input), pos(0)
+{
+}
+
+Lexer::~Lexer() {
+    // Nothing to release; the input is owned by the caller.
+}
+
+void Lexer::skipWhitespace() {
+    while (pos < input.size() && std::isspace(static_cast<unsigned char>(input[pos])))
+        ++pos;
+}
+
+Token Lexer::next() {
+    skipWhitespace();
+    Token token;
+    token.position = pos;
+    if (pos >= input.size()) {
+        token.type = TokenType::END;
+        return token;
+    }
+
+    char c = input[pos];
+    if (isIdentifierStart(c)) {
+        size_t start = pos;
+        while (pos < input.size() && isIdentifierPart(input[pos]))
+            ++pos;
+        token.type = TokenType::IDENTIFIER;
+        token.text.assign(input, start, pos - start);
+        return token;
+    }
+
+    // A sign only starts a number when a digit (or a decimal point) follows.
+    char following = (pos + 1 < input.size()) ? input[pos + 1] : '\0';
+    if (isDigit(c) || (c == '.' && isDigit(following))
+        || ((c == '-' || c == '+') && (isDigit(following) || following == '.')))
+        return readNumber();
+
+    if (c == '\'')
+        return readString();
+
+    // Two-character operators first, then single characters.
+    token.type = TokenType::SYMBOL;
+    if ((c == '<' && (following == '=' || following == '>')) || ((c == '>' || c == '!') && following == '=')) {
+        token.text.assign(input, pos, 2);
+        pos += 2;
+        return token;
+    }
+    switch (c) {
+    case '(': case ')': case ',': case ';': case '*': case '=': case '<': case '>':
+        token.text.assign(1, c);
+        ++pos;
+        return token;
+    default:
+        token.type = TokenType::INVALID;
+        token.text.assign(1, c);
+        ++pos;
+        return token;
+    }
+}
+
+Token Lexer::readNumber() {
+    Token token;
+    token.type = TokenType::NUMBER;
+    token.position = pos;
+    size_t start = pos;
+    if (input[pos] == '-' || input[pos] == '+')
+        ++pos;
+    while (pos < input.size() && isDigit(input[pos]))
+        ++pos;
+    if (pos < input.size() && input[pos] == '.') {
+        ++pos;
+        while (pos < input.size() && isDigit(input[pos]))
+            ++pos;
+    }
+    // Exponent: only consumed when digits follow, so "1e" stays a number followed by an identifier.
+    if (pos < input.size() && (input[pos] == 'e' || input[pos] == 'E')) {
+        size_t exponent = pos + 1;
+        if (exponent < input.size() && (input[exponent] == '-' || input[exponent] == '+'))
+            ++exponent;
+        if (exponent < input.size() && isDigit(input[exponent])) {
+            pos = exponent;
+            while (pos < input.size() && isDigit(input[pos]))
+                ++pos;
+        }
+    }
+    token.text.assign(input, start, pos - start);
+    return token;
+}
+
+Token Lexer::readString() {
+    Token token;
+    token.type = TokenType::STRING;
+    token.position = pos;
+    ++pos; // Opening quote.
+    while (pos < input.size()) {
+        char c = input[pos++];
+        if (c != '\'') {
+            token.text += c;
+            continue;
+        }
+        // A doubled quote stands for one quote; a single one closes the string.
+        if (pos < input.size() && input[pos] == '\'') {
+            token.text += '\'';
+            ++pos;
+            continue;
+        }
+        return token;
+    }
+    token.type = TokenType::INVALID;
+    token.text = "unterminated string";
+    return token;
+}
+
+Token Lexer::nextWord() {
+    skipWhitespace();
+    if (pos < input.size() && input[pos] == '\'')
+        return readString();
+
+    Token token;
+    token.position = pos;
+    size_t start = pos;
+    while (pos < input.size() && !std::isspace(static_cast<unsigned char>(input[pos])) && input[pos] != ';')
+        ++pos;
+    token.type = (pos > start) ? TokenType::WORD : TokenType::END;
+    token.text.assign(input, start, pos - start);
+    if (token.type == TokenType::END && pos < input.size())
+        return next(); // A ';' (or other symbol) where a word was expected.
+    return token;
+}
+
+bool Lexer::isKeyword(const Token& token, const char* keyword) {
+    if (token.type != TokenType::IDENTIFIER)
+        return false;
+    size_t i = 0;
+    for (; keyword[i] != '\0'; ++i) {
+        if (i >= token.text.size() || std::toupper(static_cast<unsigned char>(token.text[i])) != keyword[i])
+            return false;
+    }
+    return i == token.text.size();
+}
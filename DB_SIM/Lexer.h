@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <string>
+
+/**
+ * @brief Enumeration for the kinds of token produced by the Lexer.
+ */
+enum class TokenType {
+    IDENTIFIER, // A name or keyword: letters, digits and '_', not starting with a digit.
+    NUMBER,     // An optionally signed integer or decimal number, with an optional exponent.
+    STRING,     // A quoted string; the text excludes the quotes and has '' unescaped to '.
+    SYMBOL,     // Punctuation or a comparison operator: ( ) , ; * = < <= > >= <> !=
+    WORD,       // A run of non-blank characters, only produced by nextWord().
+    END,        // The end of the input.
+    INVALID,    // A character that starts no token, or an unterminated string.
+};
+
+/**
+ * @brief A single token of a query.
+ */
+struct Token {
+    TokenType type = TokenType::END;
+    std::string text;
+    size_t position = 0; // Offset of the token in the input.
+};
+
+/**
+ * @brief The Lexer class splits a query into tokens on demand.
+ *
+ * Responsibilities:
+ * - Skips whitespace and produces one token per call to next().
+ * - Produces free-form words (file names, keys) through nextWord() for commands that take them.
+ *
+ * Usage:
+ * - Construct a Lexer over the query text (which must outlive it) and call next() until END.
+ */
+class Lexer {
+public:
+    /**
+     * @brief Construct a new Lexer object.
+     * @param input The query text.
+     */
+    explicit Lexer(const std::string& input);
+
+    /**
+     * @brief Destroy the Lexer object.
+     */
+    ~Lexer();
+
+    /**
+     * @brief Read the next token.
+     * @return Token The token (END at the end of the input).
+     */
+    Token next();
+
+    /**
+     * @brief Read the next run of non-blank characters, up to a terminating ';'.
+     *
+     * A quoted string is read as a STRING token instead.
+     * @return Token The WORD or STRING token (END at the end of the input).
+     */
+    Token nextWord();
+
+    /**
+     * @brief Check whether a token is a given keyword, ignoring case.
+     * @param token The token.
+     * @param keyword The keyword, in upper case.
+     * @return true if the token is an identifier spelling the keyword; false otherwise.
+     */
+    static bool isKeyword(const Token& token, const char* keyword);
+
+private:
+    const std::string& input;
+    size_t pos;
+
+    void skipWhitespace();
+    Token readNumber();
+    Token readString();
+};
@@ -0,0 +1,38 @@
+﻿#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+
+LogLevel Logger::current = LogLevel::NORMAL;
+
+void Logger::setLevel(LogLevel level) {
+    current = level;
+}
+
+LogLevel Logger::getLevel() {
+    return current;
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (upper == "QUIET")
+        level = LogLevel::QUIET;
+    else if (upper == "NORMAL")
+        level = LogLevel::NORMAL;
+    else if (upper == "VERBOSE")
+        level = LogLevel::VERBOSE;
+    else
+        return false;
+    return true;
+}
+
+const char* Logger::toString(LogLevel level) {
+    switch (level) {
+    case LogLevel::QUIET:
+        return "QUIET";
+    case LogLevel::VERBOSE:
+        return "VERBOSE";
+    default:
+        return "NORMAL";
+    }
+}
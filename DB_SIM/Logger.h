@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <string>
+
+/**
+ * @brief Enumeration for how much the application reports on the console.
+ */
+enum class LogLevel {
+    QUIET,   // Errors and query results (selected records, help) only.
+    NORMAL,  // Plus one summary line per statement, e.g. the number of records inserted.
+    VERBOSE, // Plus the parsed statement and the messages of every layer it passes through.
+};
+
+/**
+ * @brief The Logger class holds the console logging level shared by the whole application.
+ *
+ * Responsibilities:
+ * - Decides whether informational messages of a given level are written to std::cout.
+ * - Errors are always written to std::cerr and are not subject to the level.
+ *
+ * Usage:
+ * - Guard each informational message: if (Logger::isEnabled(LogLevel::VERBOSE)) std::cout << ...;
+ *   so that a disabled message costs a single comparison and no formatting.
+ * - Messages end with '\n' rather than std::endl; the console is flushed before each prompt.
+ */
+class Logger {
+public:
+    /**
+     * @brief Set the logging level.
+     * @param level The new level.
+     */
+    static void setLevel(LogLevel level);
+
+    /**
+     * @brief Get the logging level.
+     * @return LogLevel The current level.
+     */
+    static LogLevel getLevel();
+
+    /**
+     * @brief Check whether messages of a given level are written.
+     * @param level The level of the message.
+     * @return true if the current level is at least the given level; false otherwise.
+     */
+    static bool isEnabled(LogLevel level) { return level <= current; }
+
+    /**
+     * @brief Parse a level name (QUIET, NORMAL or VERBOSE), ignoring case.
+     * @param name The level name.
+     * @param level Receives the level.
+     * @return true if the name is a known level; false otherwise.
+     */
+    static bool parseLevel(const std::string& name, LogLevel& level);
+
+    /**
+     * @brief Get the name of a level.
+     * @param level The level.
+     * @return const char* The upper-case level name.
+     */
+    static const char* toString(LogLevel level);
+
+private:
+    static LogLevel current;
+};
@@ -0,0 +1,126 @@
+﻿#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : view(nullptr), length(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+}
+#else
+MappedFile::MappedFile()
+    : view(nullptr), length(0)
+{
+}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& filename) {
+    close();
+    // FILE_SHARE_DELETE lets a flush replace the file while it is mapped, FILE_SHARE_WRITE append a checkpoint to it.
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file for reading: " << filename << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        std::cerr << "Error: Cannot read the size of file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    length = static_cast<uint64_t>(fileSize.QuadPart);
+    if (length == 0)
+        return true; // An empty file cannot be mapped, and there is nothing to map.
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+        view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+        std::cerr << "Error: Cannot map file into memory: " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    view = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    length = 0;
+}
+#else
+bool MappedFile::open(const std::string& filename) {
+    close();
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        std::cerr << "Error: Cannot open file for reading: " << filename << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        std::cerr << "Error: Cannot read the size of file: " << filename << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+    length = static_cast<uint64_t>(status.st_size);
+    if (length == 0) {
+        // An empty file cannot be mapped, and there is nothing to map.
+        ::close(descriptor);
+        return true;
+    }
+
+    // The mapping keeps the file alive on its own, so the descriptor is not needed past this point.
+    void* address = mmap(nullptr, static_cast<size_t>(length), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        std::cerr << "Error: Cannot map file into memory: " << filename << std::endl;
+        length = 0;
+        return false;
+    }
+    view = static_cast<const char*>(address);
+    return true;
+}
+
+void MappedFile::close() {
+    if (view != nullptr)
+        munmap(const_cast<char*>(view), static_cast<size_t>(length));
+    view = nullptr;
+    length = 0;
+}
+#endif
+
+const char* MappedFile::data() const {
+    return view;
+}
+
+uint64_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief The MappedFile class maps a whole file read-only into memory.
+ *
+ * Responsibilities:
+ * - Gives random access to the file content without reading it: pages are brought in by the operating
+ *   system on first touch, so opening a file costs the same whatever its size.
+ * - Uses mmap on POSIX systems and a file mapping on Windows; errors are written to std::cerr.
+ *
+ * Usage:
+ * - Call open(), then read through data() and size(); the mapping is released by close() or the destructor.
+ * - An empty file opens successfully with a null data() and a size() of 0.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Construct a new MappedFile object that maps nothing.
+     */
+    MappedFile();
+
+    /**
+     * @brief Destroy the MappedFile object and release the mapping.
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Map a file, releasing any previous mapping.
+     * @param filename The file name.
+     * @return true if the file is mapped; false otherwise.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Release the mapping.
+     */
+    void close();
+
+    /**
+     * @brief Get the mapped content.
+     * @return const char* The first byte of the file.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Get the size of the mapped file.
+     * @return uint64_t The size in bytes.
+     */
+    uint64_t size() const;
+
+private:
+    const char* view;
+    uint64_t length;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+
+    // Disable copying.
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
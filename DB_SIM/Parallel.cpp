@@ -0,0 +1,119 @@
+﻿#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // One call of forEach(): whichever threads join it take its indexes until none is left.
+    struct Job {
+        Job(size_t count, const std::function<void(size_t index)>& task) : count(count), task(task), next(0), active(0) {}
+
+        // Threads take the next index as they become free, so uneven tasks still keep every thread busy.
+        void run() {
+            for (size_t index = next++; index < count; index = next++)
+                task(index);
+        }
+
+        bool hasWork() const {
+            return next < count;
+        }
+
+        size_t count;
+        const std::function<void(size_t index)>& task;
+        std::atomic<size_t> next;
+        size_t active; // Pool threads running the job (guarded by the pool's mutex).
+    };
+
+    // The worker threads, waiting for jobs. It is never destroyed: a background checkpoint may still be
+    // sealing while static objects are destroyed at exit, and its threads simply stop with the process.
+    class Pool {
+    public:
+        static Pool& get() {
+            static Pool* pool = new Pool();
+            return *pool;
+        }
+
+        bool hasThreads() const {
+            return threadCount > 0;
+        }
+
+        void run(Job& job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(&job);
+            }
+            wake.notify_all();
+            job.run();
+            // Once the job is withdrawn no thread joins it; the caller waits for those that did.
+            std::unique_lock<std::mutex> lock(mutex);
+            jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+            finished.wait(lock, [&job] { return job.active == 0; });
+        }
+
+    private:
+        Pool() : threadCount(0) {
+            for (size_t i = 1; i < Parallel::getThreadCount(); ++i) {
+                try {
+                    std::thread(&Pool::work, this).detach();
+                    ++threadCount;
+                }
+                catch (const std::system_error&) {
+                    break;
+                }
+            }
+        }
+
+        void work() {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                Job* job = nullptr;
+                wake.wait(lock, [this, &job] {
+                    for (Job* waiting : jobs) {
+                        if (waiting->hasWork()) {
+                            job = waiting;
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+                ++job->active;
+                lock.unlock();
+                job->run();
+                lock.lock();
+                if (--job->active == 0)
+                    finished.notify_all();
+            }
+        }
+
+        size_t threadCount;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        std::vector<Job*> jobs;
+    };
+
+} // namespace
+
+namespace Parallel {
+
+    size_t getThreadCount() {
+        static const size_t count = std::max(1u, std::thread::hardware_concurrency());
+        return count;
+    }
+
+    void forEach(size_t count, const std::function<void(size_t index)>& task) {
+        Job job(count, task);
+        if (count < 2 || !Pool::get().hasThreads()) {
+            job.run();
+            return;
+        }
+        Pool::get().run(job);
+    }
+
+} // namespace Parallel
@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief The Parallel namespace spreads independent pieces of work over the processor's cores.
+ *
+ * Usage:
+ * - forEach() runs a task for every index of a range on the threads of a pool (the calling thread included)
+ *   and returns once all of them are done. Tasks must not throw and must not depend on one another; a task
+ *   may call forEach() itself.
+ *
+ * The pool is started at the first call, with one thread per hardware thread besides the caller, and is kept
+ * for the life of the process, so a call costs a wake-up rather than starting threads. If the system refuses
+ * to start a thread, the pool keeps the threads it has; without any, the caller runs every task itself.
+ */
+namespace Parallel {
+
+    /**
+     * @brief Get the number of threads forEach() uses at most.
+     * @return size_t The number of hardware threads (at least 1).
+     */
+    size_t getThreadCount();
+
+    /**
+     * @brief Run a task for each index in [0, count), in parallel.
+     * @param count The number of indexes.
+     * @param task The task, called once per index.
+     */
+    void forEach(size_t count, const std::function<void(size_t index)>& task);
+
+} // namespace Parallel
@@ -0,0 +1,592 @@
+﻿#include "Parser.h"
+
+Parser::Parser(const std::string& input)
+    : lexer(input)
+{
+    advance();
+}
+
+Parser::~Parser() {
+    // Nothing to release.
+}
+
+const std::string& Parser::getError() const {
+    return error;
+}
+
+const std::string& Parser::getCommand() const {
+    return command;
+}
+
+//---------------------------------------------------------------------
+// Token helpers
+//---------------------------------------------------------------------
+void Parser::advance() {
+    current = lexer.next();
+}
+
+// Record what was expected at the current token; always returns false so callers can "return fail(...)".
+bool Parser::fail(const std::string& expected) {
+    if (current.type == TokenType::END)
+        error = "expected " + expected + " at end of statement";
+    else if (current.type == TokenType::INVALID && current.text.size() != 1)
+        error = current.text + " at position " + std::to_string(current.position);
+    else if (current.type == TokenType::INVALID)
+        error = "unexpected character '" + current.text + "' at position " + std::to_string(current.position);
+    else
+        error = "expected " + expected + " near '" + current.text + "'";
+    return false;
+}
+
+bool Parser::acceptKeyword(const char* keyword) {
+    if (!Lexer::isKeyword(current, keyword))
+        return false;
+    advance();
+    return true;
+}
+
+bool Parser::expectKeyword(const char* keyword) {
+    return acceptKeyword(keyword) || fail(keyword);
+}
+
+bool Parser::acceptSymbol(const char* symbol) {
+    if (current.type != TokenType::SYMBOL || current.text != symbol)
+        return false;
+    advance();
+    return true;
+}
+
+bool Parser::expectSymbol(const char* symbol) {
+    return acceptSymbol(symbol) || fail(std::string("'") + symbol + "'");
+}
+
+bool Parser::expectIdentifier(std::string& name) {
+    if (current.type != TokenType::IDENTIFIER)
+        return fail("a name");
+    name = std::move(current.text);
+    advance();
+    return true;
+}
+
+// The statement ends with an optional ';'.
+bool Parser::expectEnd() {
+    acceptSymbol(";");
+    return current.type == TokenType::END || fail("end of statement");
+}
+
+bool Parser::parseIdentifierList(std::vector<std::string>& names) {
+    do {
+        names.emplace_back();
+        if (!expectIdentifier(names.back()))
+            return false;
+    } while (acceptSymbol(","));
+    return true;
+}
+
+bool Parser::parseLiteral(Literal& literal) {
+    if (current.type == TokenType::NUMBER) {
+        literal.kind = Literal::Kind::NUMBER;
+    }
+    else if (current.type == TokenType::STRING) {
+        literal.kind = Literal::Kind::STRING;
+    }
+    else if (Lexer::isKeyword(current, "NULL")) {
+        literal.kind = Literal::Kind::NULL_VALUE;
+        literal.text.clear();
+        advance();
+        return true;
+    }
+    else {
+        return fail("a value");
+    }
+    literal.text = std::move(current.text);
+    advance();
+    return true;
+}
+
+// Join the operands parsed so far with one more, flattening a chain of the same operator.
+static void join(Condition& condition, Condition::Kind kind, Condition&& operand) {
+    if (condition.kind != kind) {
+        Condition first = std::move(condition);
+        condition = Condition();
+        condition.kind = kind;
+        condition.children.push_back(std::move(first));
+    }
+    condition.children.push_back(std::move(operand));
+}
+
+// condition := conjunction {OR conjunction}
+bool Parser::parseCondition(Condition& condition) {
+    if (!parseConjunction(condition))
+        return false;
+    while (acceptKeyword("OR")) {
+        Condition operand;
+        if (!parseConjunction(operand))
+            return false;
+        join(condition, Condition::Kind::OR, std::move(operand));
+    }
+    return true;
+}
+
+// conjunction := negation {AND negation}
+bool Parser::parseConjunction(Condition& condition) {
+    if (!parseNegation(condition))
+        return false;
+    while (acceptKeyword("AND")) {
+        Condition operand;
+        if (!parseNegation(operand))
+            return false;
+        join(condition, Condition::Kind::AND, std::move(operand));
+    }
+    return true;
+}
+
+// negation := NOT negation | "(" condition ")" | predicate
+bool Parser::parseNegation(Condition& condition) {
+    if (acceptKeyword("NOT")) {
+        condition.kind = Condition::Kind::NOT;
+        condition.children.emplace_back();
+        return parseNegation(condition.children.back());
+    }
+    if (acceptSymbol("("))
+        return parseCondition(condition) && expectSymbol(")");
+    return parsePredicate(condition);
+}
+
+// predicate := column ("=" | "<>" | "!=" | "<" | "<=" | ">" | ">=") literal
+//            | column [NOT] BETWEEN literal AND literal
+//            | column [NOT] IN "(" literal {, literal} ")"
+//            | column IS [NOT] NULL
+bool Parser::parsePredicate(Condition& condition) {
+    if (!expectIdentifier(condition.column))
+        return false;
+    if (acceptKeyword("IS")) {
+        condition.kind = Condition::Kind::IS_NULL;
+        condition.negated = acceptKeyword("NOT");
+        return expectKeyword("NULL");
+    }
+    condition.negated = acceptKeyword("NOT");
+    if (acceptKeyword("BETWEEN")) {
+        condition.kind = Condition::Kind::BETWEEN;
+        condition.values.resize(2);
+        return parseLiteral(condition.values[0]) && expectKeyword("AND") && parseLiteral(condition.values[1]);
+    }
+    if (acceptKeyword("IN")) {
+        condition.kind = Condition::Kind::IN;
+        if (!expectSymbol("("))
+            return false;
+        do {
+            condition.values.emplace_back();
+            if (!parseLiteral(condition.values.back()))
+                return false;
+        } while (acceptSymbol(","));
+        return expectSymbol(")");
+    }
+    if (condition.negated)
+        return fail("BETWEEN or IN");
+    if (current.type != TokenType::SYMBOL
+        || (current.text != "=" && current.text != "<>" && current.text != "!=" && current.text != "<"
+            && current.text != "<=" && current.text != ">" && current.text != ">="))
+        return fail("a comparison operator (=, <>, <, <=, >, >=), BETWEEN, IN or IS");
+    condition.kind = Condition::Kind::COMPARE;
+    condition.op = current.text == "!=" ? "<>" : std::move(current.text);
+    advance();
+    condition.values.emplace_back();
+    return parseLiteral(condition.values.back());
+}
+
+// where := [WHERE condition]; without a WHERE clause the condition matches every record.
+bool Parser::parseWhere(Condition& condition) {
+    if (!acceptKeyword("WHERE"))
+        return true;
+    return parseCondition(condition);
+}
+
+// The aggregate function a name spells, if any.
+static SelectItem::Function toFunction(const Token& token) {
+    return Lexer::isKeyword(token, "COUNT") ? SelectItem::Function::COUNT
+        : Lexer::isKeyword(token, "SUM") ? SelectItem::Function::SUM
+        : Lexer::isKeyword(token, "MIN") ? SelectItem::Function::MIN
+        : Lexer::isKeyword(token, "MAX") ? SelectItem::Function::MAX
+        : Lexer::isKeyword(token, "AVG") ? SelectItem::Function::AVG
+        : SelectItem::Function::NONE;
+}
+
+// item := column | (COUNT | SUM | MIN | MAX | AVG) '(' column ')' | COUNT '(' '*' ')'
+bool Parser::parseSelectItem(SelectItem& item) {
+    static const char* const NAMES[] = { "", "COUNT", "SUM", "MIN", "MAX", "AVG" };
+    SelectItem::Function function = toFunction(current);
+    if (!expectIdentifier(item.column))
+        return false;
+    // A name not followed by '(' is a column, even one named like a function.
+    if (!acceptSymbol("(")) {
+        item.name = item.column;
+        return true;
+    }
+    if (function == SelectItem::Function::NONE) {
+        error = "unknown aggregate function '" + item.column + "'";
+        return false;
+    }
+    item.function = function;
+    if (function == SelectItem::Function::COUNT && acceptSymbol("*"))
+        item.column = "*";
+    else if (!expectIdentifier(item.column))
+        return false;
+    if (!expectSymbol(")"))
+        return false;
+    item.name = std::string(NAMES[static_cast<int>(function)]) + "(" + item.column + ")";
+    return true;
+}
+
+//---------------------------------------------------------------------
+// Statements
+//---------------------------------------------------------------------
+std::unique_ptr<Statement> Parser::parse() {
+    if (acceptKeyword("CREATE")) {
+        if (acceptKeyword("TABLE")) {
+            command = "create table";
+            return parseCreateTable();
+        }
+        if (acceptKeyword("INDEX")) {
+            command = "create index";
+            return parseCreateIndex();
+        }
+        fail("TABLE or INDEX");
+        return nullptr;
+    }
+    if (acceptKeyword("DROP")) {
+        if (acceptKeyword("TABLE")) {
+            command = "drop table";
+            return parseDropTable();
+        }
+        if (acceptKeyword("INDEX")) {
+            command = "drop index";
+            return parseDropIndex();
+        }
+        if (acceptKeyword("COLUMN")) {
+            command = "drop column";
+            return parseDropColumn();
+        }
+        fail("TABLE, INDEX or COLUMN");
+        return nullptr;
+    }
+    // FLUSH and LOAD take free-form words, so the token after the keyword is not read ahead.
+    if (Lexer::isKeyword(current, "FLUSH")) {
+        command = "flush";
+        return parseFile(StatementType::FLUSH);
+    }
+    if (Lexer::isKeyword(current, "LOAD")) {
+        command = "load";
+        return parseFile(StatementType::LOAD);
+    }
+    if (acceptKeyword("INSERT")) {
+        command = "insert";
+        return parseInsert();
+    }
+    if (acceptKeyword("SELECT")) {
+        command = "select";
+        return parseSelect();
+    }
+    if (acceptKeyword("UPDATE")) {
+        command = "update";
+        return parseUpdate();
+    }
+    if (acceptKeyword("DELETE")) {
+        command = "delete";
+        return parseDelete();
+    }
+    if (acceptKeyword("SET")) {
+        if (acceptKeyword("SYNC")) {
+            command = "set sync";
+            return parseSetSync();
+        }
+        if (acceptKeyword("CHECKPOINT")) {
+            command = "set checkpoint";
+            return parseSetCheckpoint();
+        }
+        command = "set logging";
+        if (!expectKeyword("LOGGING"))
+            return nullptr;
+        return parseSetLogging();
+    }
+    fail("a statement");
+    return nullptr;
+}
+
+// CREATE TABLE name ( definition {, definition} ) [STORAGE ROW|COLUMNAR]
+// definition := column type [NOT NULL] | PRIMARY KEY ( columns ) | UNIQUE ( columns )
+std::unique_ptr<Statement> Parser::parseCreateTable() {
+    std::unique_ptr<CreateTableStatement> statement(new CreateTableStatement());
+    if (!expectIdentifier(statement->tableName) || !expectSymbol("("))
+        return nullptr;
+    do {
+        if (acceptKeyword("PRIMARY")) {
+            std::vector<std::string> columns;
+            if (!expectKeyword("KEY") || !expectSymbol("(") || !parseIdentifierList(columns) || !expectSymbol(")"))
+                return nullptr;
+            statement->schema.addConstraint(std::make_shared<PrimaryKeyConstraint>(columns));
+        }
+        else if (acceptKeyword("UNIQUE")) {
+            std::vector<std::string> columns;
+            if (!expectSymbol("(") || !parseIdentifierList(columns) || !expectSymbol(")"))
+                return nullptr;
+            statement->schema.addConstraint(std::make_shared<UniqueConstraint>(columns));
+        }
+        else {
+            std::string columnName;
+            if (!expectIdentifier(columnName))
+                return nullptr;
+            DataType type;
+            if (acceptKeyword("INTEGER") || acceptKeyword("INT"))
+                type = DataType::INTEGER;
+            else if (acceptKeyword("FLOAT"))
+                type = DataType::FLOAT;
+            else if (acceptKeyword("STRING"))
+                type = DataType::STRING;
+            else {
+                fail("a data type (INTEGER, FLOAT or STRING)");
+                return nullptr;
+            }
+            // "NOT NULL" means allowNull is false.
+            bool allowNull = true;
+            if (acceptKeyword("NOT")) {
+                if (!expectKeyword("NULL"))
+                    return nullptr;
+                allowNull = false;
+            }
+            statement->schema.addColumn(Column(columnName, type, allowNull));
+        }
+    } while (acceptSymbol(","));
+    if (!expectSymbol(")"))
+        return nullptr;
+
+    if (acceptKeyword("STORAGE")) {
+        if (acceptKeyword("COLUMNAR"))
+            statement->layout = StorageLayout::COLUMNAR;
+        else if (!expectKeyword("ROW"))
+            return nullptr;
+    }
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// CREATE INDEX name ON table ( columns )
+std::unique_ptr<Statement> Parser::parseCreateIndex() {
+    std::unique_ptr<CreateIndexStatement> statement(new CreateIndexStatement());
+    if (!expectIdentifier(statement->indexName) || !expectKeyword("ON") || !expectIdentifier(statement->tableName)
+        || !expectSymbol("(") || !parseIdentifierList(statement->columns) || !expectSymbol(")") || !expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// DROP TABLE name
+std::unique_ptr<Statement> Parser::parseDropTable() {
+    std::unique_ptr<DropTableStatement> statement(new DropTableStatement());
+    if (!expectIdentifier(statement->tableName) || !expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// DROP INDEX name
+std::unique_ptr<Statement> Parser::parseDropIndex() {
+    std::unique_ptr<DropIndexStatement> statement(new DropIndexStatement());
+    if (!expectIdentifier(statement->indexName) || !expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// DROP COLUMN table column | DROP COLUMN column FROM table
+std::unique_ptr<Statement> Parser::parseDropColumn() {
+    std::unique_ptr<DropColumnStatement> statement(new DropColumnStatement());
+    std::string first;
+    if (!expectIdentifier(first))
+        return nullptr;
+    if (acceptKeyword("FROM")) {
+        statement->columnName = std::move(first);
+        if (!expectIdentifier(statement->tableName))
+            return nullptr;
+    }
+    else {
+        statement->tableName = std::move(first);
+        if (!expectIdentifier(statement->columnName))
+            return nullptr;
+    }
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// SET LOGGING QUIET|NORMAL|VERBOSE
+std::unique_ptr<Statement> Parser::parseSetLogging() {
+    std::unique_ptr<SetLoggingStatement> statement(new SetLoggingStatement());
+    if (current.type != TokenType::IDENTIFIER || !Logger::parseLevel(current.text, statement->level)) {
+        fail("QUIET, NORMAL or VERBOSE");
+        return nullptr;
+    }
+    advance();
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// SET SYNC STATEMENT|GROUP [milliseconds]|NONE
+std::unique_ptr<Statement> Parser::parseSetSync() {
+    std::unique_ptr<SetSyncStatement> statement(new SetSyncStatement());
+    if (current.type != TokenType::IDENTIFIER || !WriteAheadLog::parseSyncPolicy(current.text, statement->policy)) {
+        fail("STATEMENT, GROUP or NONE");
+        return nullptr;
+    }
+    advance();
+    if (statement->policy == SyncPolicy::GROUP && current.type == TokenType::NUMBER) {
+        if (current.text.find_first_not_of("0123456789") != std::string::npos || current.text.size() > 9
+            || std::stoul(current.text) == 0) {
+            fail("a positive number of milliseconds");
+            return nullptr;
+        }
+        statement->interval = static_cast<unsigned>(std::stoul(current.text));
+        advance();
+    }
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// SET CHECKPOINT OFF | [INTERVAL milliseconds] [SIZE kilobytes], with at least one trigger
+std::unique_ptr<Statement> Parser::parseSetCheckpoint() {
+    std::unique_ptr<SetCheckpointStatement> statement(new SetCheckpointStatement());
+    auto count = [this](const char* expected, unsigned& value) {
+        if (current.type != TokenType::NUMBER || current.text.find_first_not_of("0123456789") != std::string::npos
+            || current.text.size() > 9 || std::stoul(current.text) == 0)
+            return fail(expected);
+        value = static_cast<unsigned>(std::stoul(current.text));
+        advance();
+        return true;
+    };
+    if (!acceptKeyword("OFF")) {
+        bool interval = acceptKeyword("INTERVAL");
+        if (interval && !count("a positive number of milliseconds", statement->interval))
+            return nullptr;
+        bool size = acceptKeyword("SIZE");
+        unsigned kilobytes = 0;
+        if (size && !count("a positive number of kilobytes", kilobytes))
+            return nullptr;
+        if (!interval && !size) {
+            fail("OFF, INTERVAL or SIZE");
+            return nullptr;
+        }
+        statement->logSize = static_cast<uint64_t>(kilobytes) * 1024;
+    }
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// FLUSH|LOAD filename key; the current token is still the keyword.
+std::unique_ptr<Statement> Parser::parseFile(StatementType type) {
+    std::unique_ptr<FileStatement> statement(new FileStatement(type));
+    current = lexer.nextWord();
+    if (current.type != TokenType::WORD && current.type != TokenType::STRING) {
+        fail("a file name");
+        return nullptr;
+    }
+    statement->filename = std::move(current.text);
+    current = lexer.nextWord();
+    if (current.type != TokenType::WORD && current.type != TokenType::STRING) {
+        fail("a key");
+        return nullptr;
+    }
+    statement->key = std::move(current.text);
+    advance();
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// INSERT INTO table ( columns ) VALUES row {, row}
+// row := ( literal {, literal} )
+std::unique_ptr<Statement> Parser::parseInsert() {
+    std::unique_ptr<InsertStatement> statement(new InsertStatement());
+    if (!expectKeyword("INTO") || !expectIdentifier(statement->tableName)
+        || !expectSymbol("(") || !parseIdentifierList(statement->columns) || !expectSymbol(")")
+        || !expectKeyword("VALUES"))
+        return nullptr;
+    do {
+        if (!expectSymbol("("))
+            return nullptr;
+        statement->rows.emplace_back();
+        std::vector<Literal>& values = statement->rows.back();
+        values.reserve(statement->columns.size());
+        do {
+            values.emplace_back();
+            if (!parseLiteral(values.back()))
+                return nullptr;
+        } while (acceptSymbol(","));
+        if (!expectSymbol(")"))
+            return nullptr;
+    } while (acceptSymbol(","));
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// SELECT (* | item {, item}) FROM table [WHERE condition] [GROUP BY column {, column}] [ORDER BY item [ASC|DESC]]
+std::unique_ptr<Statement> Parser::parseSelect() {
+    std::unique_ptr<SelectStatement> statement(new SelectStatement());
+    if (acceptSymbol("*")) {
+        statement->columns.emplace_back();
+        statement->columns.back().column = "*";
+        statement->columns.back().name = "*";
+    }
+    else {
+        do {
+            statement->columns.emplace_back();
+            if (!parseSelectItem(statement->columns.back()))
+                return nullptr;
+        } while (acceptSymbol(","));
+    }
+    if (!expectKeyword("FROM") || !expectIdentifier(statement->tableName) || !parseWhere(statement->where))
+        return nullptr;
+    if (acceptKeyword("GROUP")) {
+        if (!expectKeyword("BY") || !parseIdentifierList(statement->groupBy))
+            return nullptr;
+    }
+    if (acceptKeyword("ORDER")) {
+        SelectItem item;
+        if (!expectKeyword("BY") || !parseSelectItem(item))
+            return nullptr;
+        statement->orderBy = item.name;
+        if (acceptKeyword("DESC"))
+            statement->descending = true;
+        else
+            acceptKeyword("ASC");
+    }
+    if (!expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// UPDATE table SET column = literal {, column = literal} [WHERE condition]
+std::unique_ptr<Statement> Parser::parseUpdate() {
+    std::unique_ptr<UpdateStatement> statement(new UpdateStatement());
+    if (!expectIdentifier(statement->tableName) || !expectKeyword("SET"))
+        return nullptr;
+    do {
+        statement->assignments.emplace_back();
+        auto& assignment = statement->assignments.back();
+        if (!expectIdentifier(assignment.first) || !expectSymbol("=") || !parseLiteral(assignment.second))
+            return nullptr;
+    } while (acceptSymbol(","));
+    if (!parseWhere(statement->where) || !expectEnd())
+        return nullptr;
+    return statement;
+}
+
+// DELETE FROM table [WHERE condition]
+std::unique_ptr<Statement> Parser::parseDelete() {
+    std::unique_ptr<DeleteStatement> statement(new DeleteStatement());
+    if (!expectKeyword("FROM") || !expectIdentifier(statement->tableName)
+        || !parseWhere(statement->where) || !expectEnd())
+        return nullptr;
+    return statement;
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "Lexer.h"
+#include "Statement.h"
+
+/**
+ * @brief The Parser class turns the text of one statement into its syntax tree.
+ *
+ * Responsibilities:
+ * - Reads tokens from a Lexer with one token of lookahead and parses by recursive descent.
+ * - Recognizes CREATE TABLE, CREATE INDEX, DROP TABLE/INDEX/COLUMN, FLUSH, LOAD, INSERT, SELECT, UPDATE, DELETE,
+ *   SET LOGGING, SET SYNC and SET CHECKPOINT.
+ * - Keywords are case-insensitive; the trailing ';' is optional.
+ *
+ * Usage:
+ * - Construct a Parser over the statement text and call parse(); on failure, getError() describes
+ *   the problem and getCommand() names the statement that was being parsed (for help lookup).
+ */
+class Parser {
+public:
+    /**
+     * @brief Construct a new Parser object.
+     * @param input The statement text (must outlive the parser).
+     */
+    explicit Parser(const std::string& input);
+
+    /**
+     * @brief Destroy the Parser object.
+     */
+    ~Parser();
+
+    /**
+     * @brief Parse the statement.
+     * @return std::unique_ptr<Statement> The syntax tree, or nullptr if the statement is invalid.
+     */
+    std::unique_ptr<Statement> parse();
+
+    /**
+     * @brief Get the description of the last parse error.
+     * @return const std::string& The error message.
+     */
+    const std::string& getError() const;
+
+    /**
+     * @brief Get the lower-case name of the statement recognized from its leading keywords.
+     * @return const std::string& The command (e.g. "insert", "create table"), or empty if unknown.
+     */
+    const std::string& getCommand() const;
+
+private:
+    Lexer lexer;
+    Token current;
+    std::string error;
+    std::string command;
+
+    void advance();
+    bool fail(const std::string& expected);
+    bool acceptKeyword(const char* keyword);
+    bool expectKeyword(const char* keyword);
+    bool acceptSymbol(const char* symbol);
+    bool expectSymbol(const char* symbol);
+    bool expectIdentifier(std::string& name);
+    bool expectEnd();
+    bool parseIdentifierList(std::vector<std::string>& names);
+    bool parseLiteral(Literal& literal);
+    bool parseCondition(Condition& condition);
+    bool parseConjunction(Condition& condition);
+    bool parseNegation(Condition& condition);
+    bool parsePredicate(Condition& condition);
+    bool parseWhere(Condition& condition);
+    bool parseSelectItem(SelectItem& item);
+
+    std::unique_ptr<Statement> parseCreateTable();
+    std::unique_ptr<Statement> parseCreateIndex();
+    std::unique_ptr<Statement> parseDropTable();
+    std::unique_ptr<Statement> parseDropIndex();
+    std::unique_ptr<Statement> parseDropColumn();
+    std::unique_ptr<Statement> parseFile(StatementType type);
+    std::unique_ptr<Statement> parseInsert();
+    std::unique_ptr<Statement> parseSelect();
+    std::unique_ptr<Statement> parseUpdate();
+    std::unique_ptr<Statement> parseDelete();
+    std::unique_ptr<Statement> parseSetLogging();
+    std::unique_ptr<Statement> parseSetSync();
+    std::unique_ptr<Statement> parseSetCheckpoint();
+};
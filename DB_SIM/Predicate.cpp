@@ -0,0 +1,166 @@
+﻿#include "Predicate.h"
+#include "Schema.h"
+#include <algorithm>
+#include <iostream>
+
+// A node that matches every record (ALL) or none (NONE).
+static Predicate::Node constant(Predicate::Kind kind) {
+    Predicate::Node node;
+    node.kind = kind;
+    return node;
+}
+
+Predicate::Predicate() {
+    // Matches every record until bound.
+}
+
+bool Predicate::bind(const Condition& condition, const Schema& schema, const std::string& tableName) {
+    root = Node();
+    return bind(condition, schema, tableName, false, root);
+}
+
+const Predicate::Node& Predicate::getRoot() const {
+    return root;
+}
+
+bool Predicate::bindValues(const Condition& condition, const Schema& schema, const std::string& tableName, Node& node) {
+    int ordinal = schema.getColumnIndex(condition.column);
+    if (ordinal < 0) {
+        std::cerr << "Error: Column '" << condition.column << "' does not exist in table '" << tableName << "'." << std::endl;
+        return false;
+    }
+    node.ordinal = static_cast<size_t>(ordinal);
+    DataType type = schema.getColumns()[node.ordinal].getType();
+    node.values.resize(condition.values.size());
+    for (size_t i = 0; i < condition.values.size(); ++i) {
+        if (!condition.values[i].toValue(type, node.values[i])) {
+            std::cerr << "Error: Invalid value for column '" << condition.column << "': " << condition.values[i].toString() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Predicate::bind(const Condition& condition, const Schema& schema, const std::string& tableName, bool negated, Node& node) {
+    switch (condition.kind) {
+    case Condition::Kind::ALL:
+        node.kind = negated ? Kind::NONE : Kind::ALL;
+        return true;
+
+    case Condition::Kind::COMPARE:
+        if (!bindValues(condition, schema, tableName, node))
+            return false;
+        node.kind = node.values[0].isNull() ? Kind::NONE : Kind::COMPARE;
+        node.op = negated ? negate(toOp(condition.op)) : toOp(condition.op);
+        return true;
+
+    case Condition::Kind::BETWEEN: {
+        if (!bindValues(condition, schema, tableName, node))
+            return false;
+        if (condition.negated == negated) {
+            node.kind = node.values[0].isNull() || node.values[1].isNull() ? Kind::NONE : Kind::BETWEEN;
+            return true;
+        }
+        // Outside the range: below the low bound or above the high one (a NULL bound is never crossed).
+        Node below = node;
+        below.kind = node.values[0].isNull() ? Kind::NONE : Kind::COMPARE;
+        below.op = Op::LESS;
+        below.values.resize(1);
+        Node above = node;
+        above.kind = node.values[1].isNull() ? Kind::NONE : Kind::COMPARE;
+        above.op = Op::GREATER;
+        above.values.erase(above.values.begin());
+        node = Node();
+        node.kind = Kind::OR;
+        for (Node* side : { &below, &above }) {
+            if (side->kind != Kind::NONE)
+                node.children.push_back(std::move(*side));
+        }
+        if (node.children.size() < 2)
+            node = node.children.empty() ? constant(Kind::NONE) : Node(node.children[0]);
+        return true;
+    }
+
+    case Condition::Kind::IN: {
+        if (!bindValues(condition, schema, tableName, node))
+            return false;
+        node.kind = Kind::IN;
+        node.negated = condition.negated != negated;
+        bool hasNull = false;
+        std::vector<Value> values;
+        for (auto& value : node.values) {
+            if (value.isNull())
+                hasNull = true;
+            else
+                values.push_back(std::move(value));
+        }
+        // Sorted once, so that each record is looked up in the list by binary search.
+        std::sort(values.begin(), values.end(), [](const Value& a, const Value& b) { return a.compare(b) < 0; });
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        node.values.swap(values);
+        // A NULL in the list makes NOT IN unknown for every value; an empty list matches nothing.
+        if ((node.negated && hasNull) || (!node.negated && node.values.empty()))
+            node = constant(Kind::NONE);
+        return true;
+    }
+
+    case Condition::Kind::IS_NULL:
+        if (!bindValues(condition, schema, tableName, node))
+            return false;
+        node.kind = condition.negated != negated ? Kind::IS_NOT_NULL : Kind::IS_NULL;
+        return true;
+
+    case Condition::Kind::NOT:
+        return bind(condition.children[0], schema, tableName, !negated, node);
+
+    default: {
+        // NOT (a AND b) is (NOT a) OR (NOT b), and the other way round.
+        bool conjunction = (condition.kind == Condition::Kind::AND) != negated;
+        node.kind = conjunction ? Kind::AND : Kind::OR;
+        Kind absorbing = conjunction ? Kind::NONE : Kind::ALL; // An operand that decides the result alone.
+        Kind neutral = conjunction ? Kind::ALL : Kind::NONE;   // An operand that changes nothing.
+        bool bound = true;
+        bool decided = false;
+        for (const auto& child : condition.children) {
+            Node operand;
+            if (!bind(child, schema, tableName, negated, operand)) {
+                bound = false; // Keep binding, so that every error is reported.
+                continue;
+            }
+            if (operand.kind == absorbing)
+                decided = true;
+            else if (operand.kind == node.kind) {
+                for (auto& grandchild : operand.children)
+                    node.children.push_back(std::move(grandchild));
+            }
+            else if (operand.kind != neutral)
+                node.children.push_back(std::move(operand));
+        }
+        if (decided || node.children.empty())
+            node = constant(decided ? absorbing : neutral);
+        else if (node.children.size() == 1)
+            node = Node(node.children[0]);
+        return bound;
+    }
+    }
+}
+
+Predicate::Op Predicate::toOp(const std::string& text) {
+    return (text == "=") ? Op::EQUAL
+        : (text == "<>") ? Op::NOT_EQUAL
+        : (text == "<") ? Op::LESS
+        : (text == "<=") ? Op::LESS_EQUAL
+        : (text == ">") ? Op::GREATER
+        : Op::GREATER_EQUAL;
+}
+
+Predicate::Op Predicate::negate(Op op) {
+    switch (op) {
+    case Op::EQUAL: return Op::NOT_EQUAL;
+    case Op::NOT_EQUAL: return Op::EQUAL;
+    case Op::LESS: return Op::GREATER_EQUAL;
+    case Op::LESS_EQUAL: return Op::GREATER;
+    case Op::GREATER: return Op::LESS_EQUAL;
+    default: return Op::LESS;
+    }
+}
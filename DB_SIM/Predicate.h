@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include "Condition.h"
+#include "Value.h"
+
+// Forward declarations to avoid circular dependencies.
+class Schema;
+
+/**
+ * @brief The Predicate class is a WHERE condition bound to the columns of a table.
+ *
+ * Responsibilities:
+ * - Resolves every column of a Condition to its ordinal and converts every literal to the column's type
+ *   once, before any record is looked at, so that records are compared with the typed comparison of Value.
+ * - Pushes NOT down to the comparisons (a NOT over AND becomes an OR of negated operands, a negated "<"
+ *   becomes ">=", and so on), so the tree holds only AND, OR and comparisons. A comparison with NULL is
+ *   unknown, and neither it nor its negation matches: a NULL column value never matches a comparison,
+ *   IN or BETWEEN, negated or not.
+ * - Reduces what can never match (a comparison with the NULL literal, an empty IN list) to NONE.
+ *
+ * Nothing is left to resolve per record: operators are enumerators, and IN lists are sorted for binary search.
+ *
+ * Usage:
+ * - Call bind() with the condition and the table's schema, then walk getRoot() (see Table::findRecords()
+ *   and Batch::filter()).
+ */
+class Predicate {
+public:
+    /**
+     * @brief Enumeration for the kinds of node of a bound predicate.
+     */
+    enum class Kind {
+        ALL,         // Every record matches (no WHERE clause).
+        NONE,        // No record matches.
+        COMPARE,     // The column compares with values[0] per op; NULL never matches.
+        BETWEEN,     // values[0] <= column <= values[1].
+        IN,          // The column equals one of values (or, negated, none of them); NULL never matches.
+        IS_NULL,     // The column is NULL.
+        IS_NOT_NULL, // The column is not NULL.
+        AND,
+        OR,
+    };
+
+    /**
+     * @brief Enumeration for the comparison operators, resolved from their text when the predicate is bound.
+     */
+    enum class Op {
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+    };
+
+    /**
+     * @brief A node of a bound predicate.
+     */
+    struct Node {
+        Kind kind = Kind::ALL;
+        size_t ordinal = 0;
+        Op op = Op::EQUAL;         // COMPARE.
+        std::vector<Value> values; // Of the column's type, never NULL; IN: sorted, without duplicates.
+        bool negated = false;      // IN: NOT IN.
+        std::vector<Node> children;
+    };
+
+    /**
+     * @brief Construct a predicate that matches every record.
+     */
+    Predicate();
+
+    /**
+     * @brief Bind a condition to the columns of a table; errors are written to std::cerr.
+     * @param condition The condition.
+     * @param schema The schema of the table.
+     * @param tableName The table name, for error messages.
+     * @return true if every column exists and every literal is valid for its column; false otherwise.
+     */
+    bool bind(const Condition& condition, const Schema& schema, const std::string& tableName);
+
+    /**
+     * @brief Get the root of the bound tree.
+     * @return const Node& The root.
+     */
+    const Node& getRoot() const;
+
+    /**
+     * @brief Get the operator written as text in a condition.
+     * @param text "=", "<>", "<", "<=", ">" or ">=".
+     * @return Op The operator.
+     */
+    static Op toOp(const std::string& text);
+
+    /**
+     * @brief Get the operator a comparison becomes when it is negated ("<" becomes ">=", and so on).
+     * @param op The comparison operator.
+     * @return Op The negated operator.
+     */
+    static Op negate(Op op);
+
+private:
+    Node root;
+
+    // Bind one condition, negated if asked, into a node.
+    bool bind(const Condition& condition, const Schema& schema, const std::string& tableName, bool negated, Node& node);
+    // Resolve the column of a comparison and convert its literals to the column's type (NULL stays NULL).
+    bool bindValues(const Condition& condition, const Schema& schema, const std::string& tableName, Node& node);
+};
@@ -5,10 +5,10 @@
 #include "Column.h"
 #include "Record.h"
 #include "Table.h"
+#include "Parser.h"
+#include "Logger.h"
 
 #include <iostream>
-#include <regex>
-#include <sstream>
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
@@ -25,13 +25,19 @@ struct QueryHelp {
 // Static map to store help info for each command.
 static const std::unordered_map<std::string, QueryHelp> helpMap = {
     {"create table",
-        {"CREATE TABLE <tableName> (<columnName> <dataType> [NOT NULL], [PRIMARY KEY (<col(s)>)] [; UNIQUE (<col(s)>]);",
+        {"CREATE TABLE <tableName> (<columnName> <dataType> [NOT NULL], [PRIMARY KEY (<col(s)>)] [; UNIQUE (<col(s)>]) [STORAGE ROW|COLUMNAR];",
          "CREATE TABLE users (id INTEGER NOT NULL, name STRING, age INTEGER, PRIMARY KEY (id), UNIQUE (name));"}},
     {"drop table",
         {"DROP TABLE <tableName>;",
          "DROP TABLE users;"}},
+    {"create index",
+        {"CREATE INDEX <indexName> ON <tableName> (<col1>, <col2>, ...);",
+         "CREATE INDEX idx_users_age ON users (age);"}},
+    {"drop index",
+        {"DROP INDEX <indexName>;",
+         "DROP INDEX idx_users_age;"}},
     {"drop column",
-        {"DROP COLUMN <tableName> <columnName>;",
+        {"DROP COLUMN <tableName> <columnName>; or DROP COLUMN <columnName> FROM <tableName>;",
          "DROP COLUMN users age;"}},
     {"flush",
         {"FLUSH <filename> <key>;",
@@ -40,17 +46,26 @@ static const std::unordered_map<std::string, QueryHelp> helpMap = {
         {"LOAD <filename> <key>;",
          "LOAD database.db mysecretkey;"}},
     {"insert",
-        {"INSERT INTO <tableName> (col1, col2, ...) VALUES (val1, val2, ...);",
-         "INSERT INTO users (id, name, age) VALUES ('1', 'Alice', '30');"}},
+        {"INSERT INTO <tableName> (col1, col2, ...) VALUES (val1, val2, ...) [, (val1, val2, ...) ...];",
+         "INSERT INTO users (id, name, age) VALUES (1, 'Alice', 30), (2, 'Bob', 25);"}},
     {"select",
-        {"SELECT <col1, col2, ...> FROM <tableName> [WHERE <condition>];",
-         "SELECT * FROM users WHERE id = 1;"}},
+        {"SELECT <col1, COUNT(*), SUM|MIN|MAX|AVG|COUNT(col2), ...> FROM <tableName> [WHERE <condition>] [GROUP BY <col1, ...>] [ORDER BY <item> [ASC|DESC]];",
+         "SELECT * FROM users WHERE age >= 18 AND (city IN ('Oslo', 'Bergen') OR email IS NULL) ORDER BY age DESC;"}},
     {"update",
-        {"UPDATE <tableName> SET <col1> = <val1>, <col2> = <val2>, ... WHERE <condition>;",
+        {"UPDATE <tableName> SET <col1> = <val1>, <col2> = <val2>, ... [WHERE <condition>];",
          "UPDATE users SET name = 'Alicia', age = '31' WHERE id = 1;"}},
     {"delete",
-        {"DELETE FROM <tableName> WHERE <condition>;",
-         "DELETE FROM users WHERE id = 1;"}}
+        {"DELETE FROM <tableName> [WHERE <condition>];",
+         "DELETE FROM users WHERE age NOT BETWEEN 18 AND 65;"}},
+    {"set logging",
+        {"SET LOGGING QUIET|NORMAL|VERBOSE;",
+         "SET LOGGING QUIET;"}},
+    {"set sync",
+        {"SET SYNC STATEMENT|GROUP [<milliseconds>]|NONE;",
+         "SET SYNC GROUP 100;"}},
+    {"set checkpoint",
+        {"SET CHECKPOINT OFF|[INTERVAL <milliseconds>] [SIZE <kilobytes>];",
+         "SET CHECKPOINT INTERVAL 60000 SIZE 4096;"}}
 };
 
 // Function to handle help command.
@@ -101,399 +116,351 @@ QueryProcessor::~QueryProcessor() {
 }
 
 /**
- * @brief Execute a command/query by dispatching to the appropriate parser.
+ * @brief Execute a command/query: parse it into a syntax tree, then dispatch on the statement type.
  *
  * Supported commands:
  * - HELP [command]
  * - CREATE TABLE ...
+ * - CREATE INDEX ...
  * - DROP TABLE ...
+ * - DROP INDEX ...
  * - DROP COLUMN ...
  * - FLUSH <filename> <key>;
  * - LOAD <filename> <key>;
+ * - SET LOGGING QUIET|NORMAL|VERBOSE;
+ * - SET SYNC STATEMENT|GROUP [<milliseconds>]|NONE;
+ * - SET CHECKPOINT OFF|[INTERVAL <milliseconds>] [SIZE <kilobytes>];
  * - Standard SQL queries: INSERT, SELECT, UPDATE, DELETE.
  */
 bool QueryProcessor::execute(const std::string& sqlQuery) {
     std::string query = trim(sqlQuery);
-    std::string lowerQuery = query;
+    std::string lowerQuery = query.substr(0, 4);
     std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-
-    if (lowerQuery.find("help") == 0) {
+    if (lowerQuery == "help") {
         handleQueryHelp(query);
+        return true;
     }
-    else if (lowerQuery.find("create table") == 0) {
-        parseCreate(query);
-    }
-    else if (lowerQuery.find("drop table") == 0) {
-        parseDropTable(query);
-    }
-    else if (lowerQuery.find("drop column") == 0) {
-        parseDropColumn(query);
-    }
-    else if (lowerQuery.find("flush") == 0) {
-        parseFlush(query);
-    }
-    else if (lowerQuery.find("load") == 0) {
-        parseLoad(query);
-    }
-    else if (lowerQuery.find("insert") == 0) {
-        parseInsert(query);
-    }
-    else if (lowerQuery.find("select") == 0) {
-        parseSelect(query);
-    }
-    else if (lowerQuery.find("update") == 0) {
-        parseUpdate(query);
-    }
-    else if (lowerQuery.find("delete") == 0) {
-        parseDelete(query);
-    }
-    else {
-        std::cerr << "Error: Unsupported command/query type." << std::endl;
+
+    Parser parser(query);
+    std::unique_ptr<Statement> statement = parser.parse();
+    if (!statement) {
+        if (parser.getCommand().empty()) {
+            std::cerr << "Error: Unsupported command/query type." << std::endl;
+        }
+        else {
+            std::cerr << "Error: Invalid " << toUpper(parser.getCommand()) << " query format: " << parser.getError() << "." << std::endl;
+            handleQueryHelp(parser.getCommand());
+        }
         return false;
     }
+
+    switch (statement->type) {
+    case StatementType::CREATE_TABLE:
+        executeCreate(static_cast<const CreateTableStatement&>(*statement));
+        break;
+    case StatementType::CREATE_INDEX:
+        executeCreateIndex(static_cast<const CreateIndexStatement&>(*statement));
+        break;
+    case StatementType::DROP_TABLE:
+        executeDropTable(static_cast<const DropTableStatement&>(*statement));
+        break;
+    case StatementType::DROP_INDEX:
+        executeDropIndex(static_cast<const DropIndexStatement&>(*statement));
+        break;
+    case StatementType::DROP_COLUMN:
+        executeDropColumn(static_cast<const DropColumnStatement&>(*statement));
+        break;
+    case StatementType::FLUSH:
+        executeFlush(static_cast<const FileStatement&>(*statement));
+        break;
+    case StatementType::LOAD:
+        executeLoad(static_cast<const FileStatement&>(*statement));
+        break;
+    case StatementType::INSERT:
+        executeInsert(static_cast<const InsertStatement&>(*statement));
+        break;
+    case StatementType::SELECT:
+        executeSelect(static_cast<const SelectStatement&>(*statement));
+        break;
+    case StatementType::UPDATE:
+        executeUpdate(static_cast<const UpdateStatement&>(*statement));
+        break;
+    case StatementType::DELETE_FROM:
+        executeDelete(static_cast<const DeleteStatement&>(*statement));
+        break;
+    case StatementType::SET_LOGGING:
+        executeSetLogging(static_cast<const SetLoggingStatement&>(*statement));
+        break;
+    case StatementType::SET_SYNC:
+        executeSetSync(static_cast<const SetSyncStatement&>(*statement));
+        break;
+    case StatementType::SET_CHECKPOINT:
+        executeSetCheckpoint(static_cast<const SetCheckpointStatement&>(*statement));
+        break;
+    }
     return true;
 }
 
 /**
- * @brief Parse and execute a DROP TABLE command.
- * Expected syntax: DROP TABLE <tableName>;
+ * @brief Execute a DROP TABLE command.
+ * Syntax: DROP TABLE <tableName>;
  */
-void QueryProcessor::parseDropTable(const std::string& query) {
-    std::regex dropTablePattern(R"(DROP\s+TABLE\s+(\w+);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, dropTablePattern)) {
-        std::string tableName = match[1];
-        if (Database::getInstance().dropTable(tableName))
-            std::cout << "DROP TABLE: Table '" << tableName << "' dropped successfully." << std::endl;
-        else
-            std::cerr << "Error: Failed to drop table '" << tableName << "'." << std::endl;
+void QueryProcessor::executeDropTable(const DropTableStatement& statement) {
+    if (Database::getInstance().dropTable(statement.tableName)) {
+        if (Logger::isEnabled(LogLevel::NORMAL))
+            std::cout << "DROP TABLE: Table '" << statement.tableName << "' dropped successfully.\n";
     }
-    else {
-        std::cerr << "Error: Invalid DROP TABLE query format." << std::endl;
-        handleQueryHelp("drop table");
+    else
+        std::cerr << "Error: Failed to drop table '" << statement.tableName << "'." << std::endl;
+}
+
+/**
+ * @brief Execute a CREATE INDEX command.
+ * Syntax: CREATE INDEX <indexName> ON <tableName> (<col1>, <col2>, ...);
+ */
+void QueryProcessor::executeCreateIndex(const CreateIndexStatement& statement) {
+    if (Database::getInstance().createIndex(statement.indexName, statement.tableName, statement.columns)) {
+        if (Logger::isEnabled(LogLevel::NORMAL))
+            std::cout << "CREATE INDEX: Index '" << statement.indexName << "' created successfully.\n";
     }
+    else
+        std::cerr << "Error: Failed to create index '" << statement.indexName << "'." << std::endl;
 }
 
 /**
- * @brief Parse and execute a DROP COLUMN command.
- * Expected syntax: DROP COLUMN <tableName> <columnName>;
+ * @brief Execute a DROP INDEX command.
+ * Syntax: DROP INDEX <indexName>;
  */
-void QueryProcessor::parseDropColumn(const std::string& query) {
-    std::regex dropColumnPattern(R"(DROP\s+COLUMN\s+(\w+)\s+(\w+);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, dropColumnPattern)) {
-        std::string tableName = match[1];
-        std::string columnName = match[2];
-        auto table = Database::getInstance().getTable(tableName);
-        if (!table) {
-            std::cerr << "Error: Table '" << tableName << "' not found." << std::endl;
-        }
-        else {
-            if (table->dropColumn(columnName))
-                std::cout << "DROP COLUMN: Column '" << columnName << "' dropped from table '" << tableName << "'." << std::endl;
-            else
-                std::cerr << "Error: Failed to drop column '" << columnName << "' from table '" << tableName << "'." << std::endl;
-        }
+void QueryProcessor::executeDropIndex(const DropIndexStatement& statement) {
+    if (Database::getInstance().dropIndex(statement.indexName)) {
+        if (Logger::isEnabled(LogLevel::NORMAL))
+            std::cout << "DROP INDEX: Index '" << statement.indexName << "' dropped successfully.\n";
     }
-    else {
-        std::cerr << "Error: Invalid DROP COLUMN query format." << std::endl;
-        auto it = helpMap.find("drop column");
-        if (it != helpMap.end()) {
-            std::cerr << "Usage: " << it->second.usage << std::endl;
-            std::cerr << "Example: " << it->second.example << std::endl;
-        }
+    else
+        std::cerr << "Error: Failed to drop index '" << statement.indexName << "'." << std::endl;
+}
+
+/**
+ * @brief Execute a DROP COLUMN command.
+ * Syntax: DROP COLUMN <tableName> <columnName>; or DROP COLUMN <columnName> FROM <tableName>;
+ */
+void QueryProcessor::executeDropColumn(const DropColumnStatement& statement) {
+    if (Database::getInstance().dropColumn(statement.tableName, statement.columnName)) {
+        if (Logger::isEnabled(LogLevel::NORMAL))
+            std::cout << "DROP COLUMN: Column '" << statement.columnName << "' dropped from table '" << statement.tableName << "'.\n";
     }
+    else
+        std::cerr << "Error: Failed to drop column '" << statement.columnName << "' from table '" << statement.tableName << "'." << std::endl;
 }
 
 /**
- * @brief Parse and execute a CREATE TABLE command.
- * Expected syntax:
- *   CREATE TABLE <tableName> (<columnDef_or_constraintDef>, ...);
+ * @brief Execute a CREATE TABLE command.
+ * Syntax:
+ *   CREATE TABLE <tableName> (<columnDef_or_constraintDef>, ...) [STORAGE ROW|COLUMNAR];
  * Column definition: <columnName> <dataType> [NOT NULL]
  * Constraint definitions:
  *   PRIMARY KEY (<col1>, <col2>, ...)
  *   UNIQUE (<col1>, <col2>, ...)
  * Example:
  *   CREATE TABLE users (id INTEGER NOT NULL, name STRING, age INTEGER, PRIMARY KEY (id), UNIQUE (name));
+ *   CREATE TABLE events (id INTEGER, kind STRING, amount FLOAT) STORAGE COLUMNAR;
  */
-void QueryProcessor::parseCreate(const std::string& query) {
-    std::regex createPattern(R"(CREATE\s+TABLE\s+(\w+)\s*\((.+)\);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, createPattern)) {
-        std::string tableName = match[1];
-        std::string body = match[2];
-
-        // Check if table already exists.
-        if (Database::getInstance().getTable(tableName) != nullptr) {
-            std::cerr << "Error: Table '" << tableName << "' already exists." << std::endl;
-            return;
-        }
-
-        Schema schema;
-        // Split the body by comma; note: this is a simple split and may not handle complex definitions.
-        std::vector<std::string> tokens = split(body, ',');
-        for (const auto& token : tokens) {
-            std::string t = trim(token);
-            // Check if the token defines a PRIMARY KEY constraint.
-            if (t.size() >= 11 && std::equal(t.begin(), t.begin() + 11, "PRIMARY KEY",
-                [](char a, char b) { return std::tolower(a) == std::tolower(b); })) {
-                std::regex pkPattern(R"(PRIMARY\s+KEY\s*\((.+)\))", std::regex::icase);
-                std::smatch pkMatch;
-                if (std::regex_match(t, pkMatch, pkPattern)) {
-                    std::string pkCols = pkMatch[1];
-                    std::vector<std::string> pkColumns = split(pkCols, ',');
-                    auto pkConstraint = std::make_shared<PrimaryKeyConstraint>(pkColumns);
-                    schema.addConstraint(pkConstraint);
-                }
-                else {
-                    std::cerr << "Error: Invalid PRIMARY KEY constraint definition: \"" << t << "\"" << std::endl;
-                    std::cerr << "Usage: PRIMARY KEY (<column1>, <column2>, ...)" << std::endl;
-                    std::cerr << "Example: PRIMARY KEY (id)" << std::endl;
-                    return;
-                }
-            }
-            // Check if the token defines a UNIQUE constraint.
-            else if (t.size() >= 6 && std::equal(t.begin(), t.begin() + 6, "UNIQUE",
-                [](char a, char b) { return std::tolower(a) == std::tolower(b); })) {
-                std::regex uqPattern(R"(UNIQUE\s*\((.+)\))", std::regex::icase);
-                std::smatch uqMatch;
-                if (std::regex_match(t, uqMatch, uqPattern)) {
-                    std::string uqCols = uqMatch[1];
-                    std::vector<std::string> uqColumns = split(uqCols, ',');
-                    auto uqConstraint = std::make_shared<UniqueConstraint>(uqColumns);
-                    schema.addConstraint(uqConstraint);
-                }
-                else {
-                    std::cerr << "Error: Invalid UNIQUE constraint definition: \"" << t << "\"" << std::endl;
-                    std::cerr << "Usage: UNIQUE (<column1>, <column2>, ...)" << std::endl;
-                    std::cerr << "Example: UNIQUE (name)" << std::endl;
-                    return;
-                }
-            }
-            // Otherwise, assume it is a column definition.
-            else {
-                // Expected format: <columnName> <dataType> [NOT NULL]
-                std::regex colPattern(R"((\w+)\s+(INTEGER|FLOAT|STRING)(\s+NOT\s+NULL)?\s*)", std::regex::icase);
-                std::smatch colMatch;
-                if (std::regex_match(t, colMatch, colPattern)) {
-                    std::string colName = colMatch[1];
-                    std::string typeStr = colMatch[2];
-                    std::string notNullStr = colMatch[3];
-                    DataType colType = DataType::STRING;
-                    std::transform(typeStr.begin(), typeStr.end(), typeStr.begin(), ::toupper);
-                    if (typeStr == "INTEGER")
-                        colType = DataType::INTEGER;
-                    else if (typeStr == "FLOAT")
-                        colType = DataType::FLOAT;
-                    else if (typeStr == "STRING")
-                        colType = DataType::STRING;
-                    // "NOT NULL" means allowNull is false.
-                    bool allowNull = notNullStr.empty();
-                    schema.addColumn(Column(colName, colType, allowNull));
-                }
-                else {
-                    std::cerr << "Error: Invalid column definition: \"" << t << "\"" << std::endl;
-                    handleQueryHelp("create table");
-                    return;
-                }
-            }
-        }
-        Database::getInstance().addTable(tableName, std::make_shared<Table>(tableName, schema));
-        std::cout << "CREATE: Table '" << tableName << "' created successfully." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid CREATE TABLE query format." << std::endl;
-        handleQueryHelp("create table");
-    }
+void QueryProcessor::executeCreate(const CreateTableStatement& statement) {
+    // The database reports a table that already exists.
+    if (!Database::getInstance().createTable(statement.tableName, statement.schema, statement.layout))
+        return;
+    if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "CREATE: Table '" << statement.tableName << "' created successfully.\n";
 }
 
 /**
- * @brief Parse and execute a FLUSH command.
- * Expected syntax:
+ * @brief Execute a FLUSH command.
+ * Syntax:
  *   FLUSH <filename> <key>;
  * Example:
  *   FLUSH database.db mysecretkey;
  */
-void QueryProcessor::parseFlush(const std::string& query) {
-    std::string q = query;
-    if (!q.empty() && q.back() == ';')
-        q.pop_back();
-
-    std::istringstream iss(q);
-    std::string command, filename, key;
-    iss >> command >> filename >> key;
-    if (!filename.empty() && !key.empty()) {
-        Database::getInstance().flushToFile(filename, key);
-        std::cout << "FLUSH: Database saved to file '" << filename << "'." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid FLUSH command format." << std::endl;
-        auto it = helpMap.find("flush");
-        handleQueryHelp("flush");
-    }
+void QueryProcessor::executeFlush(const FileStatement& statement) {
+    if (!Database::getInstance().flushToFile(statement.filename, statement.key))
+        std::cerr << "Error: Flush operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "FLUSH: Database saved to file '" << statement.filename << "'.\n";
 }
 
 /**
- * @brief Parse and execute a LOAD command.
- * Expected syntax:
+ * @brief Execute a LOAD command.
+ * Syntax:
  *   LOAD <filename> <key>;
  * Example:
  *   LOAD database.db mysecretkey;
  */
-void QueryProcessor::parseLoad(const std::string& query) {
-    std::string q = query;
-    if (!q.empty() && q.back() == ';')
-        q.pop_back();
-
-    std::istringstream iss(q);
-    std::string command, filename, key;
-    iss >> command >> filename >> key;
-    if (!filename.empty() && !key.empty()) {
-        Database::getInstance().loadFromFile(filename, key);
-        std::cout << "LOAD: Database loaded from file '" << filename << "'." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid LOAD command format." << std::endl;
-        handleQueryHelp("load");
-    }
+void QueryProcessor::executeLoad(const FileStatement& statement) {
+    if (!Database::getInstance().loadFromFile(statement.filename, statement.key))
+        std::cerr << "Error: Load operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "LOAD: Database loaded from file '" << statement.filename << "'.\n";
 }
 
 /**
- * @brief Parse and execute an INSERT query.
- * Expected syntax:
- *   INSERT INTO <tableName> (col1, col2, ...) VALUES (val1, val2, ...);
- * Example:
+ * @brief Execute an INSERT query.
+ * Syntax:
+ *   INSERT INTO <tableName> (col1, col2, ...) VALUES (val1, val2, ...) [, (val1, val2, ...) ...];
+ * Examples:
  *   INSERT INTO users (id, name, age) VALUES ('1', 'Alice', '30');
+ *   INSERT INTO users (id, name, age) VALUES (1, 'Alice', 30), (2, 'Bob', 25);
  */
-void QueryProcessor::parseInsert(const std::string& query) {
-    std::regex insertPattern(R"(INSERT INTO (\w+)\s*\(([^)]+)\)\s*VALUES\s*\(([^)]+)\);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, insertPattern)) {
-        std::string table = match[1];
-        std::string columnsStr = match[2];
-        std::string valuesStr = match[3];
-
-        std::vector<std::string> columns = split(columnsStr, ',');
-        std::vector<std::string> values = split(valuesStr, ',');
-
-        std::cout << "INSERT: Table = " << table << "\nColumns: ";
-        for (const auto& col : columns)
+void QueryProcessor::executeInsert(const InsertStatement& statement) {
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        std::cout << "INSERT: Table = " << statement.tableName << "\nColumns: ";
+        for (const auto& col : statement.columns)
             std::cout << col << " ";
-        std::cout << "\nValues: ";
-        for (const auto& val : values)
-            std::cout << val << " ";
-        std::cout << std::endl;
-
-        if (!Database::getInstance().insert(table, columns, values))
-            std::cerr << "Error: Insert operation failed." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid INSERT query format." << std::endl;
-        handleQueryHelp("insert");
+        if (statement.rows.size() == 1) {
+            std::cout << "\nValues: ";
+            for (const auto& val : statement.rows.front())
+                std::cout << val.toString() << " ";
+        }
+        else {
+            std::cout << "\nRows: " << statement.rows.size();
+        }
+        std::cout << '\n';
     }
+
+    size_t affected = 0;
+    if (!Database::getInstance().insert(statement.tableName, statement.columns, statement.rows, &affected))
+        std::cerr << "Error: Insert operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "INSERT: " << affected << " record(s) inserted into table '" << statement.tableName << "'.\n";
 }
 
 /**
- * @brief Parse and execute a SELECT query.
- * Expected syntax:
- *   SELECT <col1, col2, ...> FROM <tableName> [WHERE <condition>];
+ * @brief Execute a SELECT query.
+ * Syntax:
+ *   SELECT <items> FROM <tableName> [WHERE <condition>] [GROUP BY <col1, ...>] [ORDER BY <item> [ASC|DESC]];
+ *   An item is a column or an aggregate: COUNT(*), or COUNT, SUM, MIN, MAX or AVG of a column.
  * Examples:
  *   SELECT * FROM users;
  *   SELECT id, name FROM users WHERE id = 1;
+ *   SELECT * FROM users WHERE age > 30 ORDER BY age DESC;
+ *   SELECT * FROM users WHERE NOT (age BETWEEN 18 AND 30 OR name IN ('Bob', NULL));
+ *   SELECT COUNT(*), AVG(age) FROM users;
+ *   SELECT city, COUNT(*), MAX(age) FROM users WHERE age >= 18 GROUP BY city ORDER BY COUNT(*) DESC;
  */
-void QueryProcessor::parseSelect(const std::string& query) {
-    std::regex selectPattern(R"(SELECT (.+) FROM (\w+)(?: WHERE (.+))?;)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, selectPattern)) {
-        std::string columnsStr = match[1];
-        std::string table = match[2];
-        std::string condition;
-        if (match.size() > 3)
-            condition = match[3];
-
-        std::vector<std::string> columns;
-        if (trim(columnsStr) == "*")
-            columns.push_back("*");
-        else
-            columns = split(columnsStr, ',');
-
-        std::cout << "SELECT: Table = " << table << "\nColumns: ";
-        for (const auto& col : columns)
-            std::cout << col << " ";
-        std::cout << "\nCondition: " << condition << std::endl;
-
-        if (!Database::getInstance().select(table, columns, condition))
-            std::cerr << "Error: Select operation failed." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid SELECT query format." << std::endl;
-        handleQueryHelp("select");
+void QueryProcessor::executeSelect(const SelectStatement& statement) {
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        std::cout << "SELECT: Table = " << statement.tableName << "\nColumns: ";
+        for (const auto& col : statement.columns)
+            std::cout << col.name << " ";
+        std::cout << "\nCondition: " << statement.where.toString() << '\n';
+        if (!statement.groupBy.empty()) {
+            std::cout << "Group by: ";
+            for (const auto& col : statement.groupBy)
+                std::cout << col << " ";
+            std::cout << '\n';
+        }
+        if (!statement.orderBy.empty())
+            std::cout << "Order by: " << statement.orderBy << (statement.descending ? " DESC" : " ASC") << '\n';
     }
+
+    size_t affected = 0;
+    if (!Database::getInstance().select(statement.tableName, statement.columns, statement.where, statement.groupBy,
+            statement.orderBy, statement.descending, &affected))
+        std::cerr << "Error: Select operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "SELECT: " << affected << " record(s) selected from table '" << statement.tableName << "'.\n";
 }
 
 /**
- * @brief Parse and execute an UPDATE query.
- * Expected syntax:
- *   UPDATE <tableName> SET <col1> = <val1>, <col2> = <val2>, ... WHERE <condition>;
+ * @brief Execute an UPDATE query.
+ * Syntax:
+ *   UPDATE <tableName> SET <col1> = <val1>, <col2> = <val2>, ... [WHERE <condition>];
  * Example:
  *   UPDATE users SET name = 'Alicia', age = '31' WHERE id = 1;
  */
-void QueryProcessor::parseUpdate(const std::string& query) {
-    std::regex updatePattern(R"(UPDATE (\w+)\s+SET\s+(.+)\s+WHERE\s+(.+);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, updatePattern)) {
-        std::string table = match[1];
-        std::string setClause = match[2];
-        std::string condition = match[3];
-
-        std::vector<std::string> assignmentsStr = split(setClause, ',');
-        std::vector<std::pair<std::string, std::string>> assignments;
-        for (const auto& assignment : assignmentsStr) {
-            size_t posEqual = assignment.find('=');
-            if (posEqual != std::string::npos) {
-                std::string col = trim(assignment.substr(0, posEqual));
-                std::string val = trim(assignment.substr(posEqual + 1));
-                if (!val.empty() && val.front() == '\'' && val.back() == '\'')
-                    val = val.substr(1, val.size() - 2);
-                assignments.push_back(std::make_pair(col, val));
-            }
-        }
-
-        std::cout << "UPDATE: Table = " << table << "\nAssignments: ";
-        for (const auto& p : assignments)
-            std::cout << "(" << p.first << " = " << p.second << ") ";
-        std::cout << "\nCondition: " << condition << std::endl;
-
-        if (!Database::getInstance().update(table, assignments, condition))
-            std::cerr << "Error: Update operation failed." << std::endl;
-    }
-    else {
-        std::cerr << "Error: Invalid UPDATE query format." << std::endl;
-        handleQueryHelp("update");
-    }
+void QueryProcessor::executeUpdate(const UpdateStatement& statement) {
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        std::cout << "UPDATE: Table = " << statement.tableName << "\nAssignments: ";
+        for (const auto& p : statement.assignments)
+            std::cout << "(" << p.first << " = " << p.second.toString() << ") ";
+        std::cout << "\nCondition: " << statement.where.toString() << '\n';
+    }
+
+    size_t affected = 0;
+    if (!Database::getInstance().update(statement.tableName, statement.assignments, statement.where, &affected))
+        std::cerr << "Error: Update operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "UPDATE: " << affected << " record(s) updated in table '" << statement.tableName << "'.\n";
 }
 
 /**
- * @brief Parse and execute a DELETE query.
- * Expected syntax:
- *   DELETE FROM <tableName> WHERE <condition>;
+ * @brief Execute a DELETE query.
+ * Syntax:
+ *   DELETE FROM <tableName> [WHERE <condition>];
  * Example:
  *   DELETE FROM users WHERE id = 1;
  */
-void QueryProcessor::parseDelete(const std::string& query) {
-    std::regex deletePattern(R"(DELETE FROM (\w+)\s+WHERE\s+(.+);)", std::regex::icase);
-    std::smatch match;
-    if (std::regex_match(query, match, deletePattern)) {
-        std::string table = match[1];
-        std::string condition = match[2];
+void QueryProcessor::executeDelete(const DeleteStatement& statement) {
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "DELETE: Table = " << statement.tableName << "\nCondition: " << statement.where.toString() << '\n';
+
+    size_t affected = 0;
+    if (!Database::getInstance().remove(statement.tableName, statement.where, &affected))
+        std::cerr << "Error: Delete operation failed." << std::endl;
+    else if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "DELETE: " << affected << " record(s) deleted from table '" << statement.tableName << "'.\n";
+}
 
-        std::cout << "DELETE: Table = " << table << "\nCondition: " << condition << std::endl;
+/**
+ * @brief Execute a SET LOGGING command.
+ * Syntax:
+ *   SET LOGGING QUIET|NORMAL|VERBOSE;
+ * QUIET writes only errors and query results, NORMAL adds one summary line per statement,
+ * and VERBOSE also echoes each parsed statement and the messages of every layer.
+ */
+void QueryProcessor::executeSetLogging(const SetLoggingStatement& statement) {
+    Logger::setLevel(statement.level);
+    if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "SET LOGGING: Logging level is " << Logger::toString(statement.level) << ".\n";
+}
 
-        if (!Database::getInstance().remove(table, condition))
-            std::cerr << "Error: Delete operation failed." << std::endl;
+/**
+ * @brief Execute a SET SYNC command.
+ * Syntax:
+ *   SET SYNC STATEMENT|GROUP [<milliseconds>]|NONE;
+ * Chooses when the write-ahead log forces changes to disk: STATEMENT (default) before each statement
+ * completes, GROUP once per interval (100 ms by default) for all the statements in it, NONE never
+ * (changes survive a crash of the application, but not of the system).
+ */
+void QueryProcessor::executeSetSync(const SetSyncStatement& statement) {
+    Database::getInstance().setSyncPolicy(statement.policy, statement.interval);
+    if (Logger::isEnabled(LogLevel::NORMAL)) {
+        std::cout << "SET SYNC: Sync policy is " << WriteAheadLog::toString(statement.policy);
+        if (statement.policy == SyncPolicy::GROUP)
+            std::cout << " (every " << statement.interval << " ms)";
+        std::cout << ".\n";
     }
-    else {
-        std::cerr << "Error: Invalid DELETE query format." << std::endl;
-        handleQueryHelp("delete");
+}
+
+/**
+ * @brief Execute a SET CHECKPOINT command.
+ * Syntax:
+ *   SET CHECKPOINT OFF|[INTERVAL <milliseconds>] [SIZE <kilobytes>];
+ * Takes checkpoints of the file last loaded or flushed on a background thread, once per interval and
+ * whenever the write-ahead log reaches the size; statements go on while a checkpoint is written.
+ */
+void QueryProcessor::executeSetCheckpoint(const SetCheckpointStatement& statement) {
+    Database::getInstance().setCheckpointPolicy(statement.interval, statement.logSize);
+    if (Logger::isEnabled(LogLevel::NORMAL)) {
+        std::cout << "SET CHECKPOINT: ";
+        if (statement.interval == 0 && statement.logSize == 0)
+            std::cout << "Background checkpoints are off";
+        else
+            std::cout << "Background checkpoints are taken";
+        if (statement.interval > 0)
+            std::cout << " every " << statement.interval << " ms";
+        if (statement.interval > 0 && statement.logSize > 0)
+            std::cout << " and";
+        if (statement.logSize > 0)
+            std::cout << " once the log reaches " << statement.logSize / 1024 << " KB";
+        std::cout << ".\n";
     }
 }
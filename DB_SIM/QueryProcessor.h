@@ -1,13 +1,15 @@
 ﻿#pragma once
 
 #include <string>
+#include "Statement.h"
 
 /**
  * @brief The QueryProcessor class is responsible for parsing and executing SQL queries and commands.
  *
  * Responsibilities:
- * - Parse user commands/queries (CREATE TABLE, FLUSH, LOAD, INSERT, SELECT, UPDATE, DELETE).
- * - Dispatch commands to the Database accordingly.
+ * - Parse user commands/queries (CREATE TABLE, CREATE INDEX, DROP INDEX, FLUSH, LOAD, INSERT, SELECT, UPDATE, DELETE)
+ *   into a syntax tree with the Parser.
+ * - Dispatch the statements to the Database accordingly.
  *
  * Usage:
  * - Create a QueryProcessor object and call execute() with a query string.
@@ -32,16 +34,21 @@ public:
     bool execute(const std::string& sqlQuery);
 
 private:
-    // Parsing functions for various commands.
-    void parseCreate(const std::string& query);
-    void parseFlush(const std::string& query);
-    void parseLoad(const std::string& query);
-    void parseInsert(const std::string& query);
-    void parseSelect(const std::string& query);
-    void parseUpdate(const std::string& query);
-    void parseDelete(const std::string& query);
-    void parseDropColumn(const std::string& query);
-    void parseDropTable(const std::string& query);
+    // Execution functions for the statements produced by the Parser.
+    void executeCreate(const CreateTableStatement& statement);
+    void executeFlush(const FileStatement& statement);
+    void executeLoad(const FileStatement& statement);
+    void executeInsert(const InsertStatement& statement);
+    void executeSelect(const SelectStatement& statement);
+    void executeUpdate(const UpdateStatement& statement);
+    void executeDelete(const DeleteStatement& statement);
+    void executeDropColumn(const DropColumnStatement& statement);
+    void executeDropTable(const DropTableStatement& statement);
+    void executeCreateIndex(const CreateIndexStatement& statement);
+    void executeDropIndex(const DropIndexStatement& statement);
+    void executeSetLogging(const SetLoggingStatement& statement);
+    void executeSetSync(const SetSyncStatement& statement);
+    void executeSetCheckpoint(const SetCheckpointStatement& statement);
 
     // Additional helper functions can be declared here if needed.
-};
+};
\ No newline at end of file
@@ -1,38 +1,39 @@
 ﻿#include "Record.h"
-#include <stdexcept>
 
-// Constructor: Initialize a Record object with an empty data map.
-Record::Record() {
+// Constructor: Initialize a Record object with one NULL value per column.
+Record::Record(size_t columnCount)
+    : values(columnCount)
+{
     // No special initialization needed.
 }
 
 // Destructor: Clean up the Record object.
-// Since std::unordered_map manages its own memory, no manual cleanup is necessary.
+// Since std::vector manages its own memory, no manual cleanup is necessary.
 Record::~Record() {
     // No special actions required.
 }
 
-// Set the value for the specified column.
-void Record::setValue(const std::string& columnName, const std::string& value) {
-    data[columnName] = value;
+// Set the value of the column at the given ordinal.
+void Record::setValue(size_t ordinal, Value value) {
+    values[ordinal] = std::move(value);
 }
 
-// Retrieve the value of the specified column.
-// Throws std::runtime_error if the column does not exist.
-const std::string& Record::getValue(const std::string& columnName) const {
-    auto it = data.find(columnName);
-    if (it != data.end()) {
-        return it->second;
-    }
-    throw std::runtime_error("Record::getValue - Column not found: " + columnName);
+// Retrieve the value of the column at the given ordinal.
+const Value& Record::getValue(size_t ordinal) const {
+    return values[ordinal];
 }
 
-// Check if the specified column exists in the record.
-bool Record::hasColumn(const std::string& columnName) const {
-    return data.find(columnName) != data.end();
+// Return the number of values.
+size_t Record::size() const {
+    return values.size();
 }
 
-// Retrieve the entire data map of the record.
-const std::unordered_map<std::string, std::string>& Record::getData() const {
-    return data;
+// Remove the value of a dropped column.
+void Record::eraseValue(size_t ordinal) {
+    values.erase(values.begin() + ordinal);
+}
+
+// Retrieve all values of the record.
+const std::vector<Value>& Record::getValues() const {
+    return values;
 }
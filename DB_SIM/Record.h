@@ -1,25 +1,26 @@
 ﻿#pragma once
 
-#include <string>
-#include <unordered_map>
+#include <vector>
+#include "Value.h"
 
 /**
  * @brief The Record class represents a row in a table.
  *
  * Responsibilities:
- * - Stores data as key-value pairs, where the key is the column name and the value is the data (as a string).
- * - Can be extended to support other data types (e.g., using std::variant).
+ * - Stores one typed Value per column, indexed by the column's ordinal in the table Schema.
+ * - Column names are not stored; resolve them to ordinals once per query with Schema::getColumnIndex().
  *
  * Usage:
- * - Create a Record and set values using setValue().
- * - Retrieve values with getValue().
+ * - Create a Record with the number of columns of the schema (all values start as NULL).
+ * - Set values using setValue() and retrieve them with getValue().
  */
 class Record {
 public:
     /**
      * @brief Construct a new Record object.
+     * @param columnCount The number of columns (default is 0).
      */
-    Record();
+    explicit Record(size_t columnCount = 0);
 
     /**
      * @brief Destroy the Record object.
@@ -27,33 +28,37 @@ public:
     ~Record();
 
     /**
-     * @brief Set the value for a specified column.
-     * @param columnName The column name.
+     * @brief Set the value of the column at an ordinal.
+     * @param ordinal The column ordinal.
      * @param value The value to set.
      */
-    void setValue(const std::string& columnName, const std::string& value);
+    void setValue(size_t ordinal, Value value);
 
     /**
-     * @brief Get the value of the specified column.
-     * @param columnName The column name.
-     * @return const std::string& The value associated with the column.
-     * @throws std::runtime_error if the column is not found.
+     * @brief Get the value of the column at an ordinal.
+     * @param ordinal The column ordinal.
+     * @return const Value& The value.
      */
-    const std::string& getValue(const std::string& columnName) const;
+    const Value& getValue(size_t ordinal) const;
 
     /**
-     * @brief Check if the record has the specified column.
-     * @param columnName The column name.
-     * @return true if the column exists; false otherwise.
+     * @brief Get the number of values in the record.
+     * @return size_t The number of values.
      */
-    bool hasColumn(const std::string& columnName) const;
+    size_t size() const;
 
     /**
-     * @brief Get the entire data map of the record.
-     * @return const std::unordered_map<std::string, std::string>& The record's data.
+     * @brief Remove the value of a dropped column; later ordinals move down by one.
+     * @param ordinal The ordinal of the dropped column.
      */
-    const std::unordered_map<std::string, std::string>& getData() const;
+    void eraseValue(size_t ordinal);
+
+    /**
+     * @brief Get all values of the record, in column order.
+     * @return const std::vector<Value>& The values.
+     */
+    const std::vector<Value>& getValues() const;
 
 private:
-    std::unordered_map<std::string, std::string> data;
+    std::vector<Value> values;
 };
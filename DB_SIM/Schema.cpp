@@ -33,10 +33,20 @@ const std::vector<std::shared_ptr<Constraint>>& Schema::getConstraints() const {
 
 // Check if a column with the specified name exists; returns true if found.
 bool Schema::hasColumn(const std::string& columnName) const {
-    for (const auto& col : columns) {
-        if (col.getName() == columnName) {
-            return true;
+    return getColumnIndex(columnName) >= 0;
+}
+
+// Return the ordinal of the column with the specified name, or -1 if not found.
+int Schema::getColumnIndex(const std::string& columnName) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].getName() == columnName) {
+            return static_cast<int>(i);
         }
     }
-    return false;
+    return -1;
+}
+
+// Remove the column at the given ordinal.
+void Schema::removeColumn(size_t ordinal) {
+    columns.erase(columns.begin() + ordinal);
 }
@@ -59,6 +59,19 @@ public:
      */
     bool hasColumn(const std::string& columnName) const;
 
+    /**
+     * @brief Get the ordinal of a column, i.e. its position in getColumns() and in every Record.
+     * @param columnName The name of the column.
+     * @return int The ordinal, or -1 if the column does not exist.
+     */
+    int getColumnIndex(const std::string& columnName) const;
+
+    /**
+     * @brief Remove the column at an ordinal.
+     * @param ordinal The column ordinal.
+     */
+    void removeColumn(size_t ordinal);
+
 private:
     std::vector<Column> columns;
     std::vector<std::shared_ptr<Constraint>> constraints;
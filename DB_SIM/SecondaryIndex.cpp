@@ -0,0 +1,87 @@
+﻿#include "SecondaryIndex.h"
+
+SecondaryIndex::SecondaryIndex(const std::string& name, const std::vector<std::string>& columnNames, const std::vector<size_t>& ordinals)
+    : name(name), columnNames(columnNames), ordinals(ordinals)
+{
+    // Entries are added by the owning Table.
+}
+
+SecondaryIndex::~SecondaryIndex() {
+    // The tree releases its own nodes.
+}
+
+const std::string& SecondaryIndex::getName() const {
+    return name;
+}
+
+const std::vector<std::string>& SecondaryIndex::getColumnNames() const {
+    return columnNames;
+}
+
+const std::vector<size_t>& SecondaryIndex::getOrdinals() const {
+    return ordinals;
+}
+
+void SecondaryIndex::setOrdinals(const std::vector<size_t>& ordinals) {
+    this->ordinals = ordinals;
+}
+
+std::string SecondaryIndex::makeKey(const TableStorage& storage, size_t position) const {
+    std::string key;
+    for (size_t ordinal : ordinals) {
+        storage.getValue(position, ordinal).appendKey(key);
+    }
+    return key;
+}
+
+void SecondaryIndex::insert(const TableStorage& storage, size_t position) {
+    tree.insert(makeKey(storage, position), position);
+}
+
+void SecondaryIndex::erase(const TableStorage& storage, size_t position) {
+    tree.erase(makeKey(storage, position), position);
+}
+
+void SecondaryIndex::rebuild(const TableStorage& storage) {
+    std::vector<BPlusTree::Entry> entries;
+    entries.reserve(storage.size());
+    for (size_t i = 0; i < storage.size(); ++i) {
+        entries.push_back(BPlusTree::Entry{ makeKey(storage, i), i });
+    }
+    tree.bulkLoad(entries);
+}
+
+void SecondaryIndex::findRange(Predicate::Op op, const Value& value, std::vector<size_t>& positions) const {
+    // The encoding of a value is self-delimiting, so comparing a key's prefix with the encoded value
+    // compares the leading column alone.
+    std::string bound;
+    value.appendKey(bound);
+    auto compareLeading = [&bound](const std::string& key) {
+        return key.compare(0, bound.size(), bound);
+    };
+
+    if (op == Predicate::Op::EQUAL || op == Predicate::Op::GREATER_EQUAL || op == Predicate::Op::GREATER) {
+        for (auto cursor = tree.lowerBound(bound); cursor.valid(); cursor.next()) {
+            int cmp = compareLeading(cursor.key());
+            if (op == Predicate::Op::EQUAL && cmp != 0)
+                break;
+            if (op == Predicate::Op::GREATER && cmp == 0)
+                continue;
+            positions.push_back(cursor.position());
+        }
+    }
+    else if (op == Predicate::Op::LESS || op == Predicate::Op::LESS_EQUAL) {
+        for (auto cursor = tree.begin(); cursor.valid(); cursor.next()) {
+            if (cursor.key()[0] == '\0')
+                continue; // NULL keys (tag 0x00) sort first and never match.
+            int cmp = compareLeading(cursor.key());
+            if (cmp > 0 || (op == Predicate::Op::LESS && cmp == 0))
+                break;
+            positions.push_back(cursor.position());
+        }
+    }
+}
+
+const BPlusTree& SecondaryIndex::getTree() const {
+    return tree;
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include "TableStorage.h"
+#include "Predicate.h"
+#include "BPlusTree.h"
+
+/**
+ * @brief The SecondaryIndex class is a named, ordered index on one or more columns of a table.
+ *
+ * Responsibilities:
+ * - Encodes the typed values of the indexed columns into a key whose byte order matches value order
+ *   (see Value::appendKey(); INTEGER and FLOAT compare numerically, STRING lexicographically, NULL first).
+ * - Stores (key, record position) entries in a BPlusTree, so duplicate values are allowed.
+ * - Answers comparisons on the leading column and ordered scans without touching the records.
+ *
+ * Usage:
+ * - Created through CREATE INDEX and owned by the Table, which keeps it up to date on every mutation.
+ */
+class SecondaryIndex {
+public:
+    /**
+     * @brief Construct a new SecondaryIndex object.
+     * @param name The index name.
+     * @param columnNames The indexed column(s), in key order.
+     * @param ordinals The ordinals of the indexed column(s) in the table schema.
+     */
+    SecondaryIndex(const std::string& name, const std::vector<std::string>& columnNames, const std::vector<size_t>& ordinals);
+
+    /**
+     * @brief Destroy the SecondaryIndex object.
+     */
+    ~SecondaryIndex();
+
+    SecondaryIndex(SecondaryIndex&& other) noexcept = default;
+    SecondaryIndex& operator=(SecondaryIndex&& other) noexcept = default;
+
+    /**
+     * @brief Get the index name.
+     * @return const std::string& The index name.
+     */
+    const std::string& getName() const;
+
+    /**
+     * @brief Get the indexed column names.
+     * @return const std::vector<std::string>& The column names.
+     */
+    const std::vector<std::string>& getColumnNames() const;
+
+    /**
+     * @brief Get the ordinals of the indexed columns.
+     * @return const std::vector<size_t>& The column ordinals.
+     */
+    const std::vector<size_t>& getOrdinals() const;
+
+    /**
+     * @brief Re-point the index at new column ordinals after the schema changed.
+     * @param ordinals The new column ordinals.
+     */
+    void setOrdinals(const std::vector<size_t>& ordinals);
+
+    /**
+     * @brief Add the entry of a stored row.
+     * @param storage The table storage.
+     * @param position The row position.
+     */
+    void insert(const TableStorage& storage, size_t position);
+
+    /**
+     * @brief Remove the entry of a stored row.
+     * @param storage The table storage, still holding the values the row was indexed with.
+     * @param position The row position.
+     */
+    void erase(const TableStorage& storage, size_t position);
+
+    /**
+     * @brief Rebuild the index from scratch.
+     * @param storage The rows of the table.
+     */
+    void rebuild(const TableStorage& storage);
+
+    /**
+     * @brief Find the records whose leading indexed column compares to a value; NULLs never match.
+     * @param op The comparison operator: any but NOT_EQUAL.
+     * @param value The non-NULL value to compare with, of the leading column's type.
+     * @param positions Receives the matching positions, in index order.
+     */
+    void findRange(Predicate::Op op, const Value& value, std::vector<size_t>& positions) const;
+
+    /**
+     * @brief Get the underlying tree, for ordered scans.
+     * @return const BPlusTree& The tree.
+     */
+    const BPlusTree& getTree() const;
+
+private:
+    std::string name;
+    std::vector<std::string> columnNames;
+    std::vector<size_t> ordinals;
+    BPlusTree tree;
+
+    std::string makeKey(const TableStorage& storage, size_t position) const;
+};
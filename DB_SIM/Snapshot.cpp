@@ -0,0 +1,784 @@
+﻿#include "Snapshot.h"
+#include "Table.h"
+#include "Encoding.h"
+#include "Checksum.h"
+#include "Parallel.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+static const char HEADER_MAGIC[] = "DBSIMBIN";
+static const size_t MAGIC_SIZE = 8;
+// The header holds the magic, the version, the flags and the encryption parameters, then two checkpoint slots,
+// with room for the nonce and tag of a sealed one.
+static const size_t SLOTS_OFFSET = MAGIC_SIZE + 4 + 4 + SnapshotWriter::PARAMETERS_SIZE;
+static_assert(SLOTS_OFFSET == SnapshotReader::PREFIX_SIZE, "readEncryption() reads the header up to the slots.");
+static_assert(SLOTS_OFFSET + 2 * SnapshotWriter::SLOT_SIZE == SnapshotWriter::HEADER_SIZE,
+    "The header size is published by SnapshotWriter.");
+static const size_t SLOT_DATA_SIZE = 48;
+static const size_t SLOT_CHECKED_SIZE = 5 * 8 + 4; // The slot bytes its checksum covers.
+static const uint32_t FLAG_ENCRYPTED = 1;
+// The bytes of an encrypted snapshot after the header are split into chunks.
+static const uint64_t CHUNK_SIZE = SnapshotWriter::CHUNK_SIZE;
+static const size_t CHUNK_TAG_SIZE = sizeof(SnapshotChunk::tag);
+static const size_t CHUNK_ENTRY_SIZE = 8 + 4 + CHUNK_TAG_SIZE;
+// Sections are verified through the source in slices of this size, which stay in the processor's cache.
+static const size_t VERIFY_SLICE_SIZE = 64 << 10;
+
+using namespace Encoding;
+
+//---------------------------------------------------------------------
+// SnapshotWriter
+//---------------------------------------------------------------------
+SnapshotWriter::SnapshotWriter(Sink sink, uint64_t start, const std::string& parameters, SlotCipher sealSlot,
+    ChunkCipher sealChunk, const std::vector<SnapshotChunk>& chunks, size_t bufferSize)
+    : sink(std::move(sink)), sealSlot(std::move(sealSlot)), sealChunk(std::move(sealChunk)), chunks(chunks), chunkStart(0),
+      firstChunk(chunks.size()), bufferSize(bufferSize), written(start), failed(false), directoryOffset(0),
+      directoryLength(0), chunkTableLength(0), inSection(false), sectionStart(0), checksummed(0), sectionChecksum(0)
+{
+    // Give every thread a few chunks to seal each time the buffer is handed on.
+    if (this->sealChunk) {
+        this->bufferSize = std::max(this->bufferSize, static_cast<size_t>(CHUNK_SIZE) * CHUNKS_PER_THREAD * Parallel::getThreadCount());
+        chunkStart = std::max(start, static_cast<uint64_t>(HEADER_SIZE));
+    }
+    // Leave room for the value that crosses the threshold, so the buffer never reallocates.
+    buffer.reserve(this->bufferSize + 64);
+    if (start == 0) {
+        // Both slots stay empty (and invalid) until the first checkpoint is written.
+        buffer.append(HEADER_MAGIC, MAGIC_SIZE);
+        putU32(buffer, SnapshotReader::VERSION);
+        putU32(buffer, parameters.empty() ? 0 : FLAG_ENCRYPTED);
+        std::string stored = parameters;
+        stored.resize(PARAMETERS_SIZE, '\0');
+        buffer.append(stored);
+        buffer.append(2 * SLOT_SIZE, '\0');
+    }
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    // Anything not handed to the sink by finish() is discarded.
+}
+
+bool SnapshotWriter::spill() {
+    if (buffer.size() < bufferSize)
+        return !failed;
+    return drain();
+}
+
+bool SnapshotWriter::drain(bool last) {
+    if (failed)
+        return false;
+    if (buffer.empty())
+        return true;
+    if (inSection)
+        updateChecksum();
+    size_t length = buffer.size();
+    if (sealChunk) {
+        // Until the end, the chunk the buffer ends in is still being filled: it stays in the buffer.
+        uint64_t end = written + buffer.size();
+        if (!last && end > chunkStart)
+            length = static_cast<size_t>(end - (end - chunkStart) % CHUNK_SIZE - written);
+        if (length == 0)
+            return true;
+        if (!sealChunks(length)) {
+            failed = true;
+            return false;
+        }
+    }
+    if (length == buffer.size()) {
+        failed = !sink(buffer);
+        buffer.clear();
+    }
+    else {
+        std::string rest = buffer.substr(length);
+        buffer.resize(length);
+        failed = !sink(buffer);
+        buffer.assign(rest);
+    }
+    written += length;
+    return !failed;
+}
+
+bool SnapshotWriter::sealChunks(size_t length) {
+    // The buffer starts at a chunk boundary, or before the first chunk (in the header).
+    uint64_t from = std::max(written, chunkStart);
+    uint64_t end = written + length;
+    if (end <= from)
+        return true;
+    size_t first = firstChunk + static_cast<size_t>((from - chunkStart) / CHUNK_SIZE);
+    size_t count = static_cast<size_t>((end - from + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    chunks.resize(first + count);
+    std::atomic<bool> sealed(true);
+    Parallel::forEach(count, [&](size_t i) {
+        SnapshotChunk& chunk = chunks[first + i];
+        chunk.offset = from + i * CHUNK_SIZE;
+        chunk.length = static_cast<uint32_t>(std::min(end, chunk.offset + CHUNK_SIZE) - chunk.offset);
+        if (!sealChunk(&buffer[static_cast<size_t>(chunk.offset - written)], chunk.length, chunk.offset, chunk.tag))
+            sealed = false;
+    });
+    return sealed;
+}
+
+void SnapshotWriter::beginSection() {
+    inSection = true;
+    sectionStart = written + buffer.size();
+    checksummed = sectionStart;
+    sectionChecksum = 0;
+}
+
+void SnapshotWriter::updateChecksum() {
+    size_t from = static_cast<size_t>(checksummed - written);
+    sectionChecksum = Checksum::crc32c(buffer.data() + from, buffer.size() - from, sectionChecksum);
+    checksummed = written + buffer.size();
+}
+
+void SnapshotWriter::endSection(const std::string& tableName) {
+    updateChecksum();
+    inSection = false;
+    directory.push_back({ tableName, sectionStart, checksummed - sectionStart, sectionChecksum });
+}
+
+bool SnapshotWriter::writeTable(const std::string& tableName, const Table& table) {
+    beginSection();
+    if (!encodeTable(tableName, table, buffer, this))
+        return false;
+    endSection(tableName);
+    return spill();
+}
+
+bool SnapshotWriter::writeTables(const std::vector<std::pair<std::string, const Table*>>& tables) {
+    size_t threadCount = Parallel::getThreadCount();
+    if (threadCount == 1 || tables.size() < 2) {
+        for (const auto& table : tables) {
+            if (!writeTable(table.first, *table.second))
+                return false;
+        }
+        return !failed;
+    }
+    // Encode as many tables as there are threads, then write their sections in order before the next round.
+    // Sections too large to be held whole are streamed in their turn, so no thread holds more than
+    // PARALLEL_SECTION_SIZE bytes; a table whose fixed-size values alone exceed that is not even tried.
+    auto fits = [](const Table& table) {
+        uint64_t rowSize = 0;
+        for (const auto& column : table.getSchema().getColumns())
+            rowSize += column.getType() == DataType::STRING ? 4 : 8;
+        return table.getRecordCount() * rowSize <= PARALLEL_SECTION_SIZE;
+    };
+    std::vector<std::string> sections;
+    std::vector<char> encoded;
+    for (size_t first = 0; first < tables.size(); first += threadCount) {
+        size_t count = std::min(threadCount, tables.size() - first);
+        sections.assign(count, std::string());
+        encoded.assign(count, false);
+        Parallel::forEach(count, [&](size_t i) {
+            const Table& table = *tables[first + i].second;
+            // Reserved whole, so that the buffer never grows by doubling; only the pages used are touched.
+            if (fits(table))
+                sections[i].reserve(PARALLEL_SECTION_SIZE);
+            encoded[i] = fits(table) && encodeTable(tables[first + i].first, table, sections[i], nullptr, PARALLEL_SECTION_SIZE);
+            if (!encoded[i])
+                std::string().swap(sections[i]);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            if (!encoded[i]) {
+                if (!writeTable(tables[first + i].first, *tables[first + i].second))
+                    return false;
+                continue;
+            }
+            const std::string& section = sections[i];
+            bool copied = writeSection(tables[first + i].first, section.size(), [&section](uint64_t offset, size_t size, std::string& out) {
+                out.assign(section, static_cast<size_t>(offset), size);
+                return true;
+            });
+            if (!copied)
+                return false;
+            std::string().swap(sections[i]);
+        }
+    }
+    return !failed;
+}
+
+bool SnapshotWriter::encodeTable(const std::string& tableName, const Table& table, std::string& buffer, SnapshotWriter* streaming,
+    size_t limit) {
+    const Schema& schema = table.getSchema();
+    // Before each value: whether a buffer of our own has room for size more bytes under the limit.
+    auto room = [&buffer, streaming, limit](size_t size) { return streaming || buffer.size() + size <= limit; };
+    const auto& columns = schema.getColumns();
+
+    putString(buffer, tableName);
+    putU8(buffer, static_cast<uint8_t>(table.getLayout()));
+    putSchema(buffer, schema);
+    const auto& indexes = table.getIndexes();
+    putU32(buffer, static_cast<uint32_t>(indexes.size()));
+    for (const auto& index : indexes) {
+        putString(buffer, index.getName());
+        putStrings(buffer, index.getColumnNames());
+    }
+
+    // Records, column by column: a null bitmap, then the values in the column's encoding.
+    size_t recordCount = table.getRecordCount();
+    putU64(buffer, recordCount);
+    for (size_t ordinal = 0; ordinal < columns.size(); ++ordinal) {
+        for (size_t row = 0; row < recordCount; row += 8) {
+            uint8_t bits = 0;
+            for (size_t bit = 0; bit < 8 && row + bit < recordCount; ++bit) {
+                if (table.isNull(row + bit, ordinal))
+                    bits |= static_cast<uint8_t>(1 << bit);
+            }
+            if (!room(1))
+                return false;
+            putU8(buffer, bits);
+            if (streaming && !streaming->spill())
+                return false;
+        }
+        DataType type = columns[ordinal].getType();
+        for (size_t row = 0; row < recordCount; ++row) {
+            Value value = table.getValue(row, ordinal);
+            bool null = value.isNull();
+            if (!room(type != DataType::STRING ? 8 : null ? 4 : 4 + value.getString().size()))
+                return false;
+            switch (type) {
+            case DataType::INTEGER:
+                putU64(buffer, null ? 0 : static_cast<uint64_t>(value.getInteger()));
+                break;
+            case DataType::FLOAT: {
+                uint64_t bits = 0;
+                if (!null) {
+                    double number = value.getFloat();
+                    std::memcpy(&bits, &number, sizeof(bits));
+                }
+                putU64(buffer, bits);
+                break;
+            }
+            default:
+                if (null)
+                    putU32(buffer, 0);
+                else
+                    putString(buffer, value.getString());
+                break;
+            }
+            if (streaming && !streaming->spill())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool SnapshotWriter::writeSection(const std::string& tableName, uint64_t length,
+    const std::function<bool(uint64_t offset, size_t size, std::string& out)>& read) {
+    beginSection();
+    std::string piece;
+    for (uint64_t offset = 0; offset < length; ) {
+        // Fetch no more than fills the buffer up to its size.
+        size_t room = buffer.size() < bufferSize ? bufferSize - buffer.size() : 1;
+        size_t size = static_cast<size_t>(std::min<uint64_t>(length - offset, room));
+        if (!read(offset, size, piece)) {
+            failed = true;
+            return false;
+        }
+        buffer.append(piece);
+        offset += size;
+        if (!spill())
+            return false;
+    }
+    endSection(tableName);
+    return !failed;
+}
+
+void SnapshotWriter::addSection(const SnapshotSection& section) {
+    directory.push_back(section);
+}
+
+bool SnapshotWriter::finish() {
+    directoryOffset = written + buffer.size();
+    size_t directoryStart = buffer.size();
+    putU32(buffer, static_cast<uint32_t>(directory.size()));
+    for (const auto& entry : directory) {
+        putString(buffer, entry.name);
+        putU64(buffer, entry.offset);
+        putU64(buffer, entry.length);
+        putU32(buffer, entry.checksum);
+    }
+    putU32(buffer, Checksum::crc32c(buffer.data() + directoryStart, buffer.size() - directoryStart));
+    directoryLength = buffer.size() - directoryStart;
+    if (!drain(true) || !sealChunk)
+        return !failed;
+
+    // The chunk table follows, unencrypted: a tag needs no secrecy, and a wrong one only fails its chunk.
+    putU32(buffer, static_cast<uint32_t>(chunks.size()));
+    for (const auto& chunk : chunks) {
+        putU64(buffer, chunk.offset);
+        putU32(buffer, chunk.length);
+        buffer.append(chunk.tag, CHUNK_TAG_SIZE);
+    }
+    putU32(buffer, Checksum::crc32c(buffer.data(), buffer.size()));
+    chunkTableLength = buffer.size();
+    failed = !sink(buffer);
+    written += buffer.size();
+    buffer.clear();
+    return !failed;
+}
+
+std::string SnapshotWriter::checkpoint(uint64_t generation, uint64_t logId, uint64_t logPosition) const {
+    std::string slot;
+    putU64(slot, generation);
+    putU64(slot, logId);
+    putU64(slot, logPosition);
+    putU64(slot, directoryOffset);
+    putU64(slot, directoryLength);
+    putU32(slot, 0);
+    putU32(slot, Checksum::crc32c(slot.data(), slot.size()));
+    slot.resize(SLOT_DATA_SIZE, '\0');
+    if (sealSlot && (!sealSlot(slot) || slot.size() > SLOT_SIZE))
+        return std::string();
+    slot.resize(SLOT_SIZE, '\0');
+    return slot;
+}
+
+uint64_t SnapshotWriter::checkpointOffset(uint64_t generation) {
+    return SLOTS_OFFSET + (generation % 2) * SLOT_SIZE;
+}
+
+const std::vector<SnapshotSection>& SnapshotWriter::getSections() const {
+    return directory;
+}
+
+const std::vector<SnapshotChunk>& SnapshotWriter::getChunks() const {
+    return chunks;
+}
+
+uint64_t SnapshotWriter::getSize() const {
+    return written + buffer.size();
+}
+
+uint64_t SnapshotWriter::getLiveSize() const {
+    uint64_t live = HEADER_SIZE + directoryLength + chunkTableLength;
+    for (const auto& section : directory)
+        live += section.length;
+    return live;
+}
+
+//---------------------------------------------------------------------
+// SnapshotReader
+//---------------------------------------------------------------------
+bool SnapshotReader::isSnapshot(const std::string& data) {
+    return data.size() >= MAGIC_SIZE && data.compare(0, MAGIC_SIZE, HEADER_MAGIC, MAGIC_SIZE) == 0;
+}
+
+bool SnapshotReader::readEncryption(const std::string& data, std::string& parameters, uint32_t& version) {
+    parameters.clear();
+    version = 0;
+    Cursor cursor = { data.data(), data.data() + data.size() };
+    const char* magic = nullptr;
+    const char* stored = nullptr;
+    uint32_t flags = 0;
+    if (!isSnapshot(data) || !cursor.bytes(MAGIC_SIZE, magic) || !cursor.u32(version) || !cursor.u32(flags)
+        || version != VERSION || !cursor.bytes(SnapshotWriter::PARAMETERS_SIZE, stored))
+        return false;
+    if (flags & FLAG_ENCRYPTED)
+        parameters.assign(stored, SnapshotWriter::PARAMETERS_SIZE);
+    return true;
+}
+
+SnapshotReader::SnapshotReader(uint64_t size, Source source, SnapshotWriter::SlotCipher openSlot,
+    SnapshotWriter::ChunkCipher openChunk)
+    : size(size), source(std::move(source)), openSlot(std::move(openSlot)), openChunk(std::move(openChunk)),
+      encrypted(false), generation(0), logId(0), logPosition(0), liveSize(0)
+{
+}
+
+SnapshotReader::~SnapshotReader() {
+    // The bytes are owned by the source.
+}
+
+bool SnapshotReader::open() {
+    directory.clear();
+    std::string header, parameters;
+    uint32_t version = 0;
+    if (size >= PREFIX_SIZE)
+        source(0, PREFIX_SIZE, header);
+    if (!isSnapshot(header)) {
+        std::cerr << "Error: Snapshot is truncated or is not a database file." << std::endl;
+        return false;
+    }
+    if (!readEncryption(header, parameters, version)) {
+        std::cerr << "Error: Unsupported snapshot version " << version << " (this build reads version " << VERSION << ")." << std::endl;
+        return false;
+    }
+    encrypted = !parameters.empty();
+    chunks.clear();
+
+    // The current checkpoint locates the directory, which locates every table section.
+    generation = 0;
+    logId = 0;
+    logPosition = 0;
+    uint64_t directoryOffset = 0, directoryLength = 0;
+    if (!readCheckpoint(directoryOffset, directoryLength))
+        return false;
+    const uint64_t headerSize = SnapshotWriter::HEADER_SIZE;
+    if (directoryOffset < headerSize || directoryOffset > size || directoryLength > size - directoryOffset) {
+        std::cerr << "Error: Snapshot directory is corrupted." << std::endl;
+        return false;
+    }
+
+    // The chunk table follows the directory, whose chunks it authenticates.
+    if (encrypted && !readChunkTable(directoryOffset + directoryLength))
+        return false;
+
+    std::string directoryData;
+    uint32_t tableCount = 0;
+    Cursor cursor = { nullptr, nullptr };
+    if (read(directoryOffset, static_cast<size_t>(directoryLength), directoryData))
+        cursor = { directoryData.data(), directoryData.data() + directoryData.size() };
+    if (!cursor.u32(tableCount)) {
+        std::cerr << "Error: Snapshot directory is corrupted." << std::endl;
+        return false;
+    }
+    liveSize = headerSize + directoryLength + (encrypted ? 8 + chunks.size() * CHUNK_ENTRY_SIZE : 0);
+    for (uint32_t i = 0; i < tableCount; ++i) {
+        SnapshotSection section;
+        if (!cursor.string(section.name) || !cursor.u64(section.offset) || !cursor.u64(section.length)
+            || !cursor.u32(section.checksum)
+            || section.offset < headerSize || section.offset > directoryOffset || section.length > directoryOffset - section.offset) {
+            std::cerr << "Error: Snapshot directory is corrupted." << std::endl;
+            directory.clear();
+            return false;
+        }
+        liveSize += section.length;
+        directory.push_back(std::move(section));
+    }
+    uint32_t checksum = 0;
+    size_t covered = static_cast<size_t>(cursor.pos - directoryData.data());
+    if (!cursor.u32(checksum) || cursor.pos != cursor.end || checksum != Checksum::crc32c(directoryData.data(), covered)) {
+        std::cerr << "Error: Snapshot directory is corrupted." << std::endl;
+        directory.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::readChunkTable(uint64_t offset) {
+    auto corrupted = [this]() {
+        std::cerr << "Error: Snapshot chunk table is corrupted." << std::endl;
+        chunks.clear();
+        return false;
+    };
+    std::string table;
+    uint32_t count = 0;
+    if (size - offset >= 4)
+        source(offset, 4, table);
+    Cursor countCursor = { table.data(), table.data() + table.size() };
+    if (!countCursor.u32(count))
+        return corrupted();
+    uint64_t length = 8 + static_cast<uint64_t>(count) * CHUNK_ENTRY_SIZE;
+    if (length > size - offset)
+        return corrupted();
+    source(offset, static_cast<size_t>(length), table);
+    if (table.size() != length)
+        return corrupted();
+
+    // Chunks follow one another through the file, after the header.
+    Cursor cursor = { table.data() + 4, table.data() + table.size() };
+    chunks.resize(count);
+    uint64_t next = SnapshotWriter::HEADER_SIZE;
+    for (auto& chunk : chunks) {
+        const char* tag = nullptr;
+        if (!cursor.u64(chunk.offset) || !cursor.u32(chunk.length) || !cursor.bytes(CHUNK_TAG_SIZE, tag)
+            || chunk.offset < next || chunk.offset > offset || chunk.length == 0 || chunk.length > CHUNK_SIZE
+            || chunk.length > offset - chunk.offset)
+            return corrupted();
+        std::memcpy(chunk.tag, tag, CHUNK_TAG_SIZE);
+        next = chunk.offset + chunk.length;
+    }
+    uint32_t checksum = 0;
+    if (!cursor.u32(checksum) || checksum != Checksum::crc32c(table.data(), table.size() - 4))
+        return corrupted();
+    return true;
+}
+
+size_t SnapshotReader::findChunk(uint64_t offset) const {
+    auto after = std::upper_bound(chunks.begin(), chunks.end(), offset,
+        [](uint64_t value, const SnapshotChunk& chunk) { return value < chunk.offset; });
+    if (after == chunks.begin() || offset - (after - 1)->offset >= (after - 1)->length)
+        return chunks.size();
+    return static_cast<size_t>(after - chunks.begin()) - 1;
+}
+
+bool SnapshotReader::read(uint64_t offset, size_t length, std::string& out, bool parallel) const {
+    if (!encrypted) {
+        source(offset, length, out);
+        return true;
+    }
+    out.clear();
+    if (length == 0)
+        return true;
+    // The range must lie within chunks that follow one another.
+    size_t first = findChunk(offset);
+    if (first == chunks.size())
+        return false;
+    size_t last = first;
+    uint64_t start = chunks[first].offset;
+    uint64_t end = start + chunks[first].length;
+    while (end < offset + length) {
+        if (++last == chunks.size() || chunks[last].offset != end)
+            return false;
+        end += chunks[last].length;
+    }
+
+    source(start, static_cast<size_t>(end - start), out);
+    std::atomic<bool> opened(out.size() == end - start);
+    auto openOne = [&](size_t i) {
+        const SnapshotChunk& chunk = chunks[first + i];
+        char tag[CHUNK_TAG_SIZE];
+        std::memcpy(tag, chunk.tag, CHUNK_TAG_SIZE);
+        char* data = &out[static_cast<size_t>(chunk.offset - start)];
+        if (opened && (!openChunk || !openChunk(data, chunk.length, chunk.offset, tag)))
+            opened = false;
+    };
+    size_t count = last - first + 1;
+    if (parallel)
+        Parallel::forEach(count, openOne);
+    else {
+        for (size_t i = 0; i < count; ++i)
+            openOne(i);
+    }
+    if (!opened)
+        return false;
+    out.erase(0, static_cast<size_t>(offset - start));
+    out.resize(length);
+    return true;
+}
+
+uint64_t SnapshotReader::sliceEnd(uint64_t offset, uint64_t end) const {
+    if (!encrypted)
+        return std::min(end, offset + VERIFY_SLICE_SIZE);
+    size_t index = findChunk(offset);
+    return index == chunks.size() ? end : std::min(end, chunks[index].offset + chunks[index].length);
+}
+
+bool SnapshotReader::readCheckpoint(uint64_t& directoryOffset, uint64_t& directoryLength) {
+    const size_t slotSize = SnapshotWriter::SLOT_SIZE;
+    std::string slots;
+    if (size >= SLOTS_OFFSET + 2 * slotSize)
+        source(SLOTS_OFFSET, 2 * slotSize, slots);
+    // A slot being written when the process stopped fails its checksum (or, sealed, its authentication);
+    // the other one is then current.
+    bool found = false;
+    for (size_t i = 0; i < 2 && slots.size() == 2 * slotSize; ++i) {
+        std::string stored = slots.substr(i * slotSize, slotSize);
+        if (encrypted && (!openSlot || !openSlot(stored)))
+            continue;
+        if (stored.size() < SLOT_DATA_SIZE)
+            continue;
+        const char* slot = stored.data();
+        Cursor cursor = { slot, slot + SLOT_DATA_SIZE };
+        uint64_t slotGeneration = 0, slotLogId = 0, slotLogPosition = 0, offset = 0, length = 0;
+        uint32_t reserved = 0, checksum = 0;
+        cursor.u64(slotGeneration);
+        cursor.u64(slotLogId);
+        cursor.u64(slotLogPosition);
+        cursor.u64(offset);
+        cursor.u64(length);
+        cursor.u32(reserved);
+        cursor.u32(checksum);
+        if (checksum != Checksum::crc32c(slot, SLOT_CHECKED_SIZE) || (found && slotGeneration <= generation))
+            continue;
+        found = true;
+        generation = slotGeneration;
+        logId = slotLogId;
+        logPosition = slotLogPosition;
+        directoryOffset = offset;
+        directoryLength = length;
+    }
+    if (!found) {
+        std::cerr << "Error: Snapshot is truncated, was never completed, or its header is corrupted." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+uint64_t SnapshotReader::getGeneration() const {
+    return generation;
+}
+
+uint64_t SnapshotReader::getLiveSize() const {
+    return liveSize;
+}
+
+bool SnapshotReader::verify() const {
+    // Split the sections into pieces of bounded size, so that one large table still spreads over every core.
+    // Pieces of an encrypted snapshot end on chunk boundaries, so that no chunk is opened twice.
+    struct Piece {
+        size_t section;
+        uint64_t offset;
+        uint64_t length;
+        uint32_t checksum;
+        bool authentic;
+    };
+    const uint64_t pieceSize = VERIFY_PIECE_SIZE;
+    std::vector<Piece> pieces;
+    for (size_t i = 0; i < directory.size(); ++i) {
+        const SnapshotSection& entry = directory[i];
+        uint64_t end = entry.offset + entry.length;
+        for (uint64_t offset = entry.offset; offset < end; ) {
+            uint64_t pieceEnd = std::min(end, offset + pieceSize);
+            size_t chunk = encrypted && pieceEnd < end ? findChunk(pieceEnd) : chunks.size();
+            if (chunk < chunks.size() && chunks[chunk].offset > offset)
+                pieceEnd = chunks[chunk].offset;
+            pieces.push_back({ i, offset, pieceEnd - offset, 0, true });
+            offset = pieceEnd;
+        }
+    }
+    Parallel::forEach(pieces.size(), [this, &pieces](size_t index) {
+        Piece& piece = pieces[index];
+        std::string slice;
+        uint32_t checksum = 0;
+        uint64_t end = piece.offset + piece.length;
+        for (uint64_t offset = piece.offset; offset < end && piece.authentic; ) {
+            uint64_t next = sliceEnd(offset, end);
+            piece.authentic = read(offset, static_cast<size_t>(next - offset), slice);
+            checksum = Checksum::crc32c(slice.data(), slice.size(), checksum);
+            offset = next;
+        }
+        piece.checksum = checksum;
+    });
+
+    // Join the pieces of each section (they are in order) and compare with the directory.
+    bool intact = true;
+    size_t next = 0;
+    for (size_t i = 0; i < directory.size(); ++i) {
+        uint32_t checksum = 0;
+        bool authentic = true;
+        for (; next < pieces.size() && pieces[next].section == i; ++next) {
+            checksum = Checksum::combine(checksum, pieces[next].checksum, pieces[next].length);
+            authentic = authentic && pieces[next].authentic;
+        }
+        if (!authentic) {
+            std::cerr << "Error: Section of table '" << directory[i].name << "' is corrupted (it fails authentication)." << std::endl;
+            intact = false;
+        }
+        else if (checksum != directory[i].checksum) {
+            std::cerr << "Error: Section of table '" << directory[i].name << "' is corrupted (checksum mismatch)." << std::endl;
+            intact = false;
+        }
+    }
+    return intact;
+}
+
+uint64_t SnapshotReader::getLogId() const {
+    return logId;
+}
+
+uint64_t SnapshotReader::getLogPosition() const {
+    return logPosition;
+}
+
+size_t SnapshotReader::getTableCount() const {
+    return directory.size();
+}
+
+const std::string& SnapshotReader::getTableName(size_t index) const {
+    return directory[index].name;
+}
+
+const SnapshotSection& SnapshotReader::getSection(size_t index) const {
+    return directory[index];
+}
+
+const std::vector<SnapshotChunk>& SnapshotReader::getChunks() const {
+    return chunks;
+}
+
+bool SnapshotReader::copySection(size_t index, SnapshotWriter& writer) const {
+    const SnapshotSection& entry = directory[index];
+    return writer.writeSection(entry.name, entry.length, [this, &entry](uint64_t offset, size_t size, std::string& out) {
+        return read(entry.offset + offset, size, out, true);
+    });
+}
+
+std::shared_ptr<Table> SnapshotReader::readTable(size_t index, bool parallel) const {
+    const SnapshotSection& entry = directory[index];
+    auto corrupted = [&entry]() {
+        std::cerr << "Error: Section of table '" << entry.name << "' is corrupted." << std::endl;
+        return nullptr;
+    };
+    std::string section;
+    if (!read(entry.offset, static_cast<size_t>(entry.length), section, parallel))
+        return corrupted();
+    Cursor cursor = { section.data(), section.data() + section.size() };
+
+    std::string tableName;
+    uint8_t layout = 0;
+    Schema schema;
+    if (!cursor.string(tableName) || tableName != entry.name || !cursor.u8(layout)
+        || layout > static_cast<uint8_t>(StorageLayout::COLUMNAR) || !readSchema(cursor, schema))
+        return corrupted();
+    size_t columnCount = schema.getColumns().size();
+
+    uint32_t indexCount = 0;
+    if (!cursor.u32(indexCount))
+        return corrupted();
+    std::vector<std::pair<std::string, std::vector<std::string>>> indexDefs(indexCount);
+    for (auto& def : indexDefs) {
+        if (!cursor.string(def.first) || !cursor.strings(def.second))
+            return corrupted();
+    }
+
+    // Records are stored column by column; decode them into rows, then insert them as one batch.
+    uint64_t recordCount = 0;
+    if (!cursor.u64(recordCount) || (columnCount > 0 && recordCount > static_cast<uint64_t>(cursor.end - cursor.pos) * 8))
+        return corrupted();
+    std::vector<Record> records(static_cast<size_t>(recordCount), Record(columnCount));
+    for (size_t ordinal = 0; ordinal < columnCount; ++ordinal) {
+        const char* bitmap;
+        if (!cursor.bytes(static_cast<size_t>((recordCount + 7) / 8), bitmap))
+            return corrupted();
+        DataType type = schema.getColumns()[ordinal].getType();
+        for (size_t row = 0; row < records.size(); ++row) {
+            bool null = (static_cast<unsigned char>(bitmap[row / 8]) >> (row % 8)) & 1;
+            switch (type) {
+            case DataType::INTEGER: {
+                uint64_t bits;
+                if (!cursor.u64(bits))
+                    return corrupted();
+                if (!null)
+                    records[row].setValue(ordinal, Value(static_cast<int64_t>(bits)));
+                break;
+            }
+            case DataType::FLOAT: {
+                uint64_t bits;
+                if (!cursor.u64(bits))
+                    return corrupted();
+                double number;
+                std::memcpy(&number, &bits, sizeof(number));
+                if (!null)
+                    records[row].setValue(ordinal, Value(number));
+                break;
+            }
+            default: {
+                std::string text;
+                if (!cursor.string(text))
+                    return corrupted();
+                if (!null)
+                    records[row].setValue(ordinal, Value(std::move(text)));
+                break;
+            }
+            }
+        }
+    }
+    if (cursor.pos != cursor.end)
+        return corrupted();
+
+    auto table = std::make_shared<Table>(tableName, schema, static_cast<StorageLayout>(layout));
+    // The section passed its checksum: the records are appended without being validated one by one.
+    if (!records.empty() && !table->loadRecords(records)) {
+        std::cerr << "Error: Records of table '" << entry.name << "' violate its constraints." << std::endl;
+        return nullptr;
+    }
+    // Build the secondary indexes once all records are in place.
+    for (const auto& def : indexDefs)
+        table->createIndex(def.first, def.second);
+    return table;
+}
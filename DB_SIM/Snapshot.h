@@ -0,0 +1,461 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+// Forward declaration of Table to avoid circular dependency.
+class Table;
+
+/**
+ * @brief The location and checksum of one table section in a snapshot file.
+ */
+struct SnapshotSection {
+    std::string name;
+    uint64_t offset;
+    uint64_t length;
+    uint32_t checksum;
+};
+
+/**
+ * @brief The location and authentication tag of one encrypted chunk of a snapshot file.
+ */
+struct SnapshotChunk {
+    uint64_t offset;
+    uint32_t length;
+    char tag[16];
+};
+
+/**
+ * @brief The SnapshotWriter class serializes tables into the binary snapshot format written by FLUSH.
+ *
+ * Format (version 8; every integer is little-endian, every string is a uint32 length followed by its bytes):
+ * - Header: the magic "DBSIMBIN", the uint32 format version, the uint32 flags (bit 0: the snapshot is
+ *   encrypted) and 32 bytes of encryption parameters (zero unless it is encrypted), followed by two checkpoint
+ *   slots of 80 bytes. A slot holds the uint64 generation, the uint64 identifier of the write-ahead log that
+ *   continues the snapshot, the uint64 sequence number of the last logged operation the snapshot includes
+ *   (see WriteAheadLog), the uint64 offset and length of the directory, a uint32 of reserved bits (0) and the
+ *   uint32 CRC-32C of the slot bytes before it, padded with zeros. The valid slot of the highest generation
+ *   is the current one.
+ * - One section per table: the table name, the storage layout (uint8), the columns (name, uint8 type,
+ *   uint8 flags and default value; see Encoding::putSchema()), the constraints, the secondary indexes, the uint64 record count, then the records column by column.
+ *   Each column is a null bitmap of one bit per record (set = NULL), followed by the values in the column's
+ *   encoding: INTEGER as int64, FLOAT as an IEEE-754 double, STRING length-prefixed (so values may contain
+ *   any byte, including '|' and newlines); NULL slots hold 0 or "".
+ * - Directory: the uint32 table count, then each table's name, uint64 section offset, uint64 section length
+ *   and uint32 CRC-32C of the section, then the uint32 CRC-32C of the directory bytes before it.
+ * - Chunk table (encrypted snapshots only), right after the directory: the uint32 chunk count, then each
+ *   chunk's uint64 offset, uint32 length and 16-byte tag, then the uint32 CRC-32C of the table bytes before it.
+ *
+ * A checkpoint updates a snapshot in place: it appends the sections of the tables that changed and a new
+ * directory (which refers to the unchanged sections where they are), forces them to disk, then writes the
+ * slot the previous checkpoint did not use. Until that last write the previous checkpoint stays current, so
+ * a checkpoint that stops half-way loses nothing. The sections no directory refers to any more are dead
+ * space, reclaimed by writing the snapshot anew.
+ *
+ * An encrypted snapshot keeps its header readable, so that the parameters are known before the key is
+ * derived from them, but its slots are sealed within their 80 bytes (encrypted and authenticated, see
+ * SlotCipher). The bytes after the header are split into chunks of CHUNK_SIZE bytes, each encrypted and
+ * authenticated on its own (see ChunkCipher), so that chunks are sealed and opened on every core and a table
+ * is read without decrypting the rest of the file. A checkpoint starts new chunks where it starts (the last
+ * chunk of a checkpoint, which holds its directory, may be shorter) and adds them to the chunk table of the
+ * file; chunks are never written over, so each is sealed under a file offset of its own.
+ *
+ * Only this version is read: files of the older text format are imported by Database instead.
+ *
+ * The snapshot is produced through a buffer of bounded size that is handed to a sink whenever it fills up,
+ * so writing a database never holds more than one buffer (or one oversized value) of it in memory, besides
+ * the sections writeTables() encodes on other threads (one per thread at a time, of at most
+ * PARALLEL_SECTION_SIZE bytes each).
+ *
+ * Usage:
+ * - Construct a SnapshotWriter over a sink, call writeTable() or writeTables() (or addSection()) for every table, then
+ *   finish(); once everything handed to the sink is on disk, write checkpoint() at checkpointOffset().
+ * - The sink receives consecutive chunks of the snapshot and may modify them in place (e.g. to encrypt them).
+ * - An encrypted snapshot is written with its encryption parameters, a cipher that seals the slots and one
+ *   that seals the chunks; the sink then receives the chunks sealed.
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Receives the next chunk of the snapshot; returns false if it could not be written.
+     */
+    using Sink = std::function<bool(std::string& chunk)>;
+
+    /**
+     * @brief Seals a checkpoint slot (when writing) or opens a sealed one (when reading), in place; returns
+     * false if it cannot, e.g. because the slot fails authentication.
+     */
+    using SlotCipher = std::function<bool(std::string& slot)>;
+
+    /**
+     * @brief Seals the chunk of an encrypted snapshot at a file offset in place, writing its tag (when writing),
+     * or checks the tag and opens it in place (when reading); returns false if it cannot. Called from several
+     * threads at once.
+     */
+    using ChunkCipher = std::function<bool(char* data, size_t size, uint64_t offset, char* tag)>;
+
+    /**
+     * @brief The size of the header, which an encrypted snapshot stores unencrypted.
+     */
+    static const size_t HEADER_SIZE = 208;
+
+    /**
+     * @brief The size of the encryption parameters in the header.
+     */
+    static const size_t PARAMETERS_SIZE = 32;
+
+    /**
+     * @brief The size of a checkpoint slot in the header; a sealed slot fits in it.
+     */
+    static const size_t SLOT_SIZE = 80;
+
+    /**
+     * @brief The size of the chunks an encrypted snapshot is split into.
+     */
+    static const size_t CHUNK_SIZE = 64 << 10;
+
+    /**
+     * @brief The number of chunks per thread the buffer of an encrypted snapshot holds before it is sealed.
+     */
+    static const size_t CHUNKS_PER_THREAD = 8;
+
+    /**
+     * @brief The default size of the buffer handed to the sink.
+     */
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    /**
+     * @brief The largest section writeTables() encodes on a thread of its own; larger ones are streamed.
+     */
+    static const size_t PARALLEL_SECTION_SIZE = 8 << 20;
+
+    /**
+     * @brief Construct a new SnapshotWriter object.
+     *
+     * A new snapshot (start 0) begins with a header whose slots are both empty; a checkpoint of an existing
+     * snapshot begins at the end of its file.
+     * @param sink The sink the snapshot is written to.
+     * @param start The file offset of the first byte handed to the sink.
+     * @param parameters The encryption parameters recorded in the header (empty if the snapshot is not encrypted).
+     * @param sealSlot Seals the checkpoint slot of an encrypted snapshot; the sealed slot must fit its 80 bytes.
+     * @param sealChunk Seals the chunks of an encrypted snapshot.
+     * @param chunks The chunk table of the file a checkpoint is appended to.
+     * @param bufferSize The size at which the buffer is handed to the sink (at least CHUNKS_PER_THREAD chunks
+     * per thread if the snapshot is encrypted).
+     */
+    explicit SnapshotWriter(Sink sink, uint64_t start = 0, const std::string& parameters = std::string(),
+        SlotCipher sealSlot = SlotCipher(), ChunkCipher sealChunk = ChunkCipher(),
+        const std::vector<SnapshotChunk>& chunks = std::vector<SnapshotChunk>(), size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    /**
+     * @brief Destroy the SnapshotWriter object.
+     */
+    ~SnapshotWriter();
+
+    /**
+     * @brief Write the section of one table.
+     * @param tableName The table name.
+     * @param table The table.
+     * @return true if the section was written; false if the sink failed.
+     */
+    bool writeTable(const std::string& tableName, const Table& table);
+
+    /**
+     * @brief Write the sections of several tables, encoding them on every core.
+     *
+     * Each thread encodes one table into a buffer of its own; the sections are then written in order. A table
+     * whose section outgrows PARALLEL_SECTION_SIZE is written through writeTable() instead, when its turn comes,
+     * as are all of them with a single thread (or a single table).
+     * @param tables The tables, with their names, in the order their sections are written.
+     * @return true if the sections were written; false if the sink failed.
+     */
+    bool writeTables(const std::vector<std::pair<std::string, const Table*>>& tables);
+
+    /**
+     * @brief Write the section of one table as already-encoded bytes, e.g. copied from another snapshot.
+     *
+     * The bytes are fetched through the buffer, at most one buffer at a time.
+     * @param tableName The table name (as recorded in the section).
+     * @param length The section length in bytes.
+     * @param read Fetches the section bytes [offset, offset + size) into its output string; returns false if
+     * it cannot.
+     * @return true if the section was written; false if it could not be read or the sink failed.
+     */
+    bool writeSection(const std::string& tableName, uint64_t length,
+        const std::function<bool(uint64_t offset, size_t size, std::string& out)>& read);
+
+    /**
+     * @brief Refer to a section already in the file the checkpoint is appended to.
+     * @param section The section, as recorded in the directory of the file.
+     */
+    void addSection(const SnapshotSection& section);
+
+    /**
+     * @brief Write the directory (and the chunk table) and hand the rest of the buffer to the sink.
+     *
+     * No table may be written afterwards.
+     * @return true if the directory was written; false if the sink failed.
+     */
+    bool finish();
+
+    /**
+     * @brief Encode the checkpoint slot that makes the snapshot current; call after finish().
+     * @param generation The generation, higher than the one of the checkpoint it replaces.
+     * @param logId The identifier of the write-ahead log that continues the snapshot (0 for none).
+     * @param logPosition The sequence number of the last logged operation the snapshot includes.
+     * @return std::string The slot, to be written at checkpointOffset(generation), or an empty string if
+     * it could not be sealed.
+     */
+    std::string checkpoint(uint64_t generation, uint64_t logId, uint64_t logPosition) const;
+
+    /**
+     * @brief Get the file offset of the slot of a generation (generations alternate between the two slots).
+     * @param generation The generation.
+     * @return uint64_t The file offset.
+     */
+    static uint64_t checkpointOffset(uint64_t generation);
+
+    /**
+     * @brief Get the sections of the snapshot, as recorded in its directory.
+     * @return const std::vector<SnapshotSection>& The sections.
+     */
+    const std::vector<SnapshotSection>& getSections() const;
+
+    /**
+     * @brief Get the chunk table of the snapshot, as written by finish().
+     * @return const std::vector<SnapshotChunk>& The chunks (none if the snapshot is not encrypted).
+     */
+    const std::vector<SnapshotChunk>& getChunks() const;
+
+    /**
+     * @brief Get the file offset of the end of the snapshot.
+     * @return uint64_t The end of the last byte handed to the sink.
+     */
+    uint64_t getSize() const;
+
+    /**
+     * @brief Get the bytes of the file the snapshot uses: the header, its sections, its directory and its chunk table.
+     * @return uint64_t The live size.
+     */
+    uint64_t getLiveSize() const;
+
+private:
+    Sink sink;
+    SlotCipher sealSlot;
+    ChunkCipher sealChunk;
+    std::vector<SnapshotChunk> chunks;
+    uint64_t chunkStart; // File offset of the first chunk this writer seals...
+    size_t firstChunk;   // ...and its position in the chunk table.
+    size_t bufferSize;
+    std::string buffer;
+    uint64_t written; // File offset of the buffer: the bytes before it were handed to the sink.
+    bool failed;
+    std::vector<SnapshotSection> directory;
+    uint64_t directoryOffset;
+    uint64_t directoryLength;
+    uint64_t chunkTableLength;
+
+    bool inSection;          // A section is being written.
+    uint64_t sectionStart;
+    uint64_t checksummed;    // End of the section bytes covered by sectionChecksum.
+    uint32_t sectionChecksum;
+
+    // Hand the buffer to the sink once it has reached its size.
+    bool spill();
+    // Hand the buffer to the sink, whatever its size; the chunks of an encrypted snapshot are sealed first, and
+    // a chunk the buffer ends in stays in it unless last.
+    bool drain(bool last = false);
+    // Seal the chunks of the first length bytes of the buffer, in parallel.
+    bool sealChunks(size_t length);
+    // Append the section of a table to a buffer: that of streaming, which is spilled as it fills, if not null;
+    // otherwise one of its own, giving up (and returning false) rather than fill it past limit bytes.
+    static bool encodeTable(const std::string& tableName, const Table& table, std::string& buffer, SnapshotWriter* streaming,
+        size_t limit = 0);
+    // Start or end the section of a table; the checksum follows its bytes as they leave the buffer.
+    void beginSection();
+    void endSection(const std::string& tableName);
+    // Fold the section bytes still in the buffer into the checksum (before they are sealed).
+    void updateChecksum();
+};
+
+/**
+ * @brief The SnapshotReader class reads tables back from a binary snapshot (see SnapshotWriter).
+ *
+ * The snapshot is read through a source that fetches byte ranges on demand (typically out of a mapped,
+ * encrypted file), so opening a snapshot only touches its header and directory, and each table
+ * section is fetched when that table is read (of an encrypted snapshot, only the chunks it falls in are
+ * opened). Every read is bounds-checked, so a truncated or corrupted
+ * snapshot is reported instead of being half-read; errors are written to std::cerr.
+ *
+ * The header and directory checksums are checked by open(); the section checksums, and the tags of the
+ * chunks the sections fall in, by verify(), which reads
+ * every section on all cores, so that corruption is found before any of the snapshot is used.
+ *
+ * Usage:
+ * - Check isSnapshot() on the first bytes, construct a SnapshotReader over the source, call open() and
+ *   verify(), then readTable() (or copySection()) for the tables of the directory as they are needed.
+ * - For an encrypted snapshot, get the parameters with readEncryption() first; ciphers then open the slots
+ *   and the chunks, out of the bytes as stored.
+ * - The source must be safe to call from several threads at once (verify() does).
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief The format version this build reads and writes.
+     */
+    static const uint32_t VERSION = 8;
+
+    /**
+     * @brief The size of the pieces verify() checks in parallel; larger sections are split.
+     */
+    static const size_t VERIFY_PIECE_SIZE = 4 << 20;
+
+    /**
+     * @brief Check whether data starts like a binary snapshot (as opposed to the legacy text format).
+     * @param data The decrypted file content.
+     * @return true if the data starts with the snapshot magic; false otherwise.
+     */
+    static bool isSnapshot(const std::string& data);
+
+    /**
+     * @brief The number of bytes at the start of a snapshot that readEncryption() needs.
+     */
+    static const size_t PREFIX_SIZE = 48;
+
+    /**
+     * @brief Read the format version and the encryption parameters from the start of a snapshot.
+     * @param data The first PREFIX_SIZE bytes of the file, as stored.
+     * @param parameters Receives the parameters, or an empty string if the snapshot is not encrypted.
+     * @param version Receives the format version.
+     * @return true if the data starts a snapshot of this version; false otherwise.
+     */
+    static bool readEncryption(const std::string& data, std::string& parameters, uint32_t& version);
+
+    /**
+     * @brief Fetches the snapshot bytes [offset, offset + size), as stored, into out (replacing its content).
+     */
+    using Source = std::function<void(uint64_t offset, size_t size, std::string& out)>;
+
+    /**
+     * @brief Construct a new SnapshotReader object.
+     * @param size The snapshot size in bytes.
+     * @param source The source of the snapshot bytes; only ranges within size are requested.
+     * @param openSlot Opens the sealed checkpoint slots of an encrypted snapshot.
+     * @param openChunk Opens the chunks of an encrypted snapshot.
+     */
+    SnapshotReader(uint64_t size, Source source, SnapshotWriter::SlotCipher openSlot = SnapshotWriter::SlotCipher(),
+        SnapshotWriter::ChunkCipher openChunk = SnapshotWriter::ChunkCipher());
+
+    /**
+     * @brief Destroy the SnapshotReader object.
+     */
+    ~SnapshotReader();
+
+    /**
+     * @brief Check the header and version, locate the current directory and read it.
+     * @return true if the snapshot is readable; false otherwise.
+     */
+    bool open();
+
+    /**
+     * @brief Check every table section against its checksum, in parallel.
+     * @return true if every section is intact; false otherwise.
+     */
+    bool verify() const;
+
+    /**
+     * @brief Get the generation of the current checkpoint.
+     * @return uint64_t The generation.
+     */
+    uint64_t getGeneration() const;
+
+    /**
+     * @brief Get the bytes of the file the current checkpoint uses: the header, its sections and its directory.
+     * @return uint64_t The live size.
+     */
+    uint64_t getLiveSize() const;
+
+    /**
+     * @brief Get the identifier of the write-ahead log that continues the snapshot.
+     * @return uint64_t The log identifier, or 0 if no log continues it.
+     */
+    uint64_t getLogId() const;
+
+    /**
+     * @brief Get the sequence number of the last logged operation the snapshot includes.
+     * @return uint64_t The log position.
+     */
+    uint64_t getLogPosition() const;
+
+    /**
+     * @brief Get the number of tables in the snapshot.
+     * @return size_t The table count.
+     */
+    size_t getTableCount() const;
+
+    /**
+     * @brief Get the name of a table from the directory.
+     * @param index The directory position.
+     * @return const std::string& The table name.
+     */
+    const std::string& getTableName(size_t index) const;
+
+    /**
+     * @brief Get the section of a table from the directory.
+     * @param index The directory position.
+     * @return const SnapshotSection& The section.
+     */
+    const SnapshotSection& getSection(size_t index) const;
+
+    /**
+     * @brief Get the chunk table of the snapshot.
+     * @return const std::vector<SnapshotChunk>& The chunks (none if the snapshot has no chunks).
+     */
+    const std::vector<SnapshotChunk>& getChunks() const;
+
+    /**
+     * @brief Decode the section of one table.
+     *
+     * Tables may be decoded on several threads at once; each should then read its section serially.
+     * @param index The directory position.
+     * @param parallel Whether the chunks of the section are opened on every core.
+     * @return std::shared_ptr<Table> The table with its records and indexes, or nullptr if the section is invalid.
+     */
+    std::shared_ptr<Table> readTable(size_t index, bool parallel = true) const;
+
+    /**
+     * @brief Copy the section of one table, undecoded, into another snapshot.
+     * @param index The directory position.
+     * @param writer The writer of the other snapshot.
+     * @return true if the section was written; false if the writer's sink failed.
+     */
+    bool copySection(size_t index, SnapshotWriter& writer) const;
+
+private:
+    uint64_t size;
+    Source source;
+    SnapshotWriter::SlotCipher openSlot;
+    SnapshotWriter::ChunkCipher openChunk;
+    bool encrypted;
+    uint64_t generation;
+    uint64_t logId;
+    uint64_t logPosition;
+    uint64_t liveSize;
+    std::vector<SnapshotSection> directory;
+    std::vector<SnapshotChunk> chunks;
+
+    // Fetch the snapshot bytes [offset, offset + size), opening the chunks they fall in (in parallel if asked);
+    // false if a chunk fails authentication or the range is not within the chunks.
+    bool read(uint64_t offset, size_t size, std::string& out, bool parallel = false) const;
+    // Find the chunk a file offset falls in (chunks.size() if none).
+    size_t findChunk(uint64_t offset) const;
+    // Get the end of the slice that verify() reads from an offset: the end of its chunk, if there are chunks.
+    uint64_t sliceEnd(uint64_t offset, uint64_t end) const;
+    // Read the chunk table that follows the directory.
+    bool readChunkTable(uint64_t offset);
+    // Locate the directory through the current checkpoint slot.
+    bool readCheckpoint(uint64_t& directoryOffset, uint64_t& directoryLength);
+};
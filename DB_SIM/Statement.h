@@ -0,0 +1,196 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "Schema.h"
+#include "TableStorage.h"
+#include "Condition.h"
+#include "Logger.h"
+#include "WriteAheadLog.h"
+
+/**
+ * @brief Enumeration for the kinds of statement the Parser produces.
+ */
+enum class StatementType {
+    CREATE_TABLE,
+    CREATE_INDEX,
+    DROP_TABLE,
+    DROP_INDEX,
+    DROP_COLUMN,
+    FLUSH,
+    LOAD,
+    INSERT,
+    SELECT,
+    UPDATE,
+    DELETE_FROM, // Not DELETE, which <windows.h> defines as a macro.
+    SET_LOGGING,
+    SET_SYNC,
+    SET_CHECKPOINT,
+};
+
+/**
+ * @brief Base of the syntax tree of a parsed statement.
+ *
+ * Usage:
+ * - Check type, then static_cast to the matching derived statement.
+ */
+struct Statement {
+    explicit Statement(StatementType type) : type(type) {}
+    virtual ~Statement() {}
+
+    StatementType type;
+};
+
+/**
+ * @brief CREATE TABLE <tableName> (<definitions>) [STORAGE ROW|COLUMNAR];
+ */
+struct CreateTableStatement : Statement {
+    CreateTableStatement() : Statement(StatementType::CREATE_TABLE) {}
+
+    std::string tableName;
+    Schema schema;
+    StorageLayout layout = StorageLayout::ROW;
+};
+
+/**
+ * @brief CREATE INDEX <indexName> ON <tableName> (<columns>);
+ */
+struct CreateIndexStatement : Statement {
+    CreateIndexStatement() : Statement(StatementType::CREATE_INDEX) {}
+
+    std::string indexName;
+    std::string tableName;
+    std::vector<std::string> columns;
+};
+
+/**
+ * @brief DROP TABLE <tableName>;
+ */
+struct DropTableStatement : Statement {
+    DropTableStatement() : Statement(StatementType::DROP_TABLE) {}
+
+    std::string tableName;
+};
+
+/**
+ * @brief DROP INDEX <indexName>;
+ */
+struct DropIndexStatement : Statement {
+    DropIndexStatement() : Statement(StatementType::DROP_INDEX) {}
+
+    std::string indexName;
+};
+
+/**
+ * @brief DROP COLUMN <tableName> <columnName>; or DROP COLUMN <columnName> FROM <tableName>;
+ */
+struct DropColumnStatement : Statement {
+    DropColumnStatement() : Statement(StatementType::DROP_COLUMN) {}
+
+    std::string tableName;
+    std::string columnName;
+};
+
+/**
+ * @brief FLUSH <filename> <key>; and LOAD <filename> <key>;
+ */
+struct FileStatement : Statement {
+    explicit FileStatement(StatementType type) : Statement(type) {}
+
+    std::string filename;
+    std::string key;
+};
+
+/**
+ * @brief INSERT INTO <tableName> (<columns>) VALUES (<literals>) {, (<literals>)};
+ */
+struct InsertStatement : Statement {
+    InsertStatement() : Statement(StatementType::INSERT) {}
+
+    std::string tableName;
+    std::vector<std::string> columns;
+    std::vector<std::vector<Literal>> rows; // One list of literals per row.
+};
+
+/**
+ * @brief One item of a SELECT list: a column, or an aggregate function of a column.
+ */
+struct SelectItem {
+    enum class Function {
+        NONE, // The column itself.
+        COUNT,
+        SUM,
+        MIN,
+        MAX,
+        AVG,
+    };
+
+    Function function = Function::NONE;
+    std::string column; // "*" for every column, or for COUNT(*).
+    std::string name;   // As shown in the result and matched by ORDER BY: the column, or e.g. "COUNT(*)", "SUM(salary)".
+};
+
+/**
+ * @brief SELECT <items> FROM <tableName> [WHERE <condition>] [GROUP BY <columns>] [ORDER BY <item> [ASC|DESC]];
+ */
+struct SelectStatement : Statement {
+    SelectStatement() : Statement(StatementType::SELECT) {}
+
+    std::string tableName;
+    std::vector<SelectItem> columns; // A single "*" selects every column.
+    Condition where;
+    std::vector<std::string> groupBy;
+    std::string orderBy; // The name of a SELECT item or a column.
+    bool descending = false;
+};
+
+/**
+ * @brief SET LOGGING QUIET|NORMAL|VERBOSE;
+ */
+struct SetLoggingStatement : Statement {
+    SetLoggingStatement() : Statement(StatementType::SET_LOGGING) {}
+
+    LogLevel level = LogLevel::NORMAL;
+};
+
+/**
+ * @brief SET SYNC STATEMENT|GROUP [<milliseconds>]|NONE;
+ */
+struct SetSyncStatement : Statement {
+    SetSyncStatement() : Statement(StatementType::SET_SYNC) {}
+
+    SyncPolicy policy = SyncPolicy::STATEMENT;
+    unsigned interval = WriteAheadLog::DEFAULT_GROUP_INTERVAL; // Milliseconds, for GROUP.
+};
+
+/**
+ * @brief SET CHECKPOINT OFF|[INTERVAL <milliseconds>] [SIZE <kilobytes>];
+ */
+struct SetCheckpointStatement : Statement {
+    SetCheckpointStatement() : Statement(StatementType::SET_CHECKPOINT) {}
+
+    unsigned interval = 0; // Milliseconds between two checkpoints (0 for none).
+    uint64_t logSize = 0;  // Log size in bytes that triggers a checkpoint (0 for none).
+};
+
+/**
+ * @brief UPDATE <tableName> SET <column> = <literal>, ... [WHERE <condition>];
+ */
+struct UpdateStatement : Statement {
+    UpdateStatement() : Statement(StatementType::UPDATE) {}
+
+    std::string tableName;
+    std::vector<std::pair<std::string, Literal>> assignments;
+    Condition where;
+};
+
+/**
+ * @brief DELETE FROM <tableName> [WHERE <condition>];
+ */
+struct DeleteStatement : Statement {
+    DeleteStatement() : Statement(StatementType::DELETE_FROM) {}
+
+    std::string tableName;
+    Condition where;
+};
@@ -1,17 +1,66 @@
 ﻿#include "Table.h"
-#include "Utility.h"
+#include "Logger.h"
+#include "Batch.h"
+#include "Aggregation.h"
 #include <iostream>
 #include <algorithm>
-#include <sstream>
-#include <stdexcept>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <iterator>
 
-using namespace Utility;
+// The source of table versions, shared by all tables so that no two of them ever carry the same version.
+static std::atomic<uint64_t> nextVersion(1);
+
+// A deletion of at most one record in this many removes the records one at a time instead of compacting the
+// table and rebuilding the indexes.
+static const size_t FEW_RECORDS = 8;
+
+// The number of records whose keys are sampled to estimate the groups of an aggregation.
+static const size_t GROUP_SAMPLE = 1024;
 
 // Constructor: initialize table with name and given schema.
-Table::Table(const std::string& tableName, const Schema& schema)
-    : name(tableName), schema(schema) {
-    // Additional initialization if needed.
-    std::cout << "Table '" << name << "' created with the provided schema.\n";
+Table::Table(const std::string& tableName, const Schema& schema, StorageLayout layout)
+    : name(tableName), schema(schema), storage(TableStorage::create(layout, schema)), version(nextVersion++) {
+    // Create a hash index for every PRIMARY KEY and UNIQUE constraint of the schema.
+    for (const auto& constraint : schema.getConstraints()) {
+        std::vector<std::string> keyColumns;
+        bool primary = false;
+        if (auto pk = dynamic_cast<PrimaryKeyConstraint*>(constraint.get())) {
+            keyColumns = pk->getColumnNames();
+            primary = true;
+        }
+        else if (auto uq = dynamic_cast<UniqueConstraint*>(constraint.get())) {
+            keyColumns = uq->getColumnNames();
+        }
+        else {
+            continue;
+        }
+        std::vector<size_t> ordinals;
+        if (!resolveColumns(keyColumns, ordinals)) {
+            std::cerr << "Warning: " << (primary ? "Primary key" : "Unique") << " constraint on table '" << name
+                << "' refers to an unknown column and is not enforced." << std::endl;
+            continue;
+        }
+        indexes.emplace_back(keyColumns, ordinals, primary);
+    }
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Table '" << name << "' created with the provided schema.\n";
+}
+
+// Copy constructor: the hash indexes are copied, the secondary indexes (which own their nodes) rebuilt.
+Table::Table(const Table& other)
+    : name(other.name), schema(other.schema), storage(other.storage->clone()), version(other.version),
+      indexes(other.indexes) {
+    for (const auto& index : other.secondaryIndexes) {
+        secondaryIndexes.emplace_back(index.getName(), index.getColumnNames(), index.getOrdinals());
+        secondaryIndexes.back().rebuild(*storage);
+    }
+}
+
+std::shared_ptr<Table> Table::clone() const {
+    return std::shared_ptr<Table>(new Table(*this));
 }
 
 // Destructor: cleanup resources if any.
@@ -19,238 +68,842 @@ Table::~Table() {
     // No dynamic resource to clean up.
 }
 
-// Insert a record into the table after validating constraints.
-bool Table::insertRecord(const Record& record) {
-    // Check each constraint defined in the schema.
-    const auto& constraints = schema.getConstraints();
-    for (const auto& constraint : constraints) {
-        // Only enforce PrimaryKeyConstraint and UniqueConstraint here.
-        if (auto pk = dynamic_cast<PrimaryKeyConstraint*>(constraint.get())) {
-            // Get the list of columns for the primary key constraint.
-            std::vector<std::string> keyColumns = pk->getColumnNames();
-            std::vector<std::string> newValues;
-
-            // Gather values from the new record.
-            for (const auto& col : keyColumns) {
-                if (!record.hasColumn(col)) {
-                    std::cerr << "Error: Record is missing required column '" << col
-                        << "' for primary key constraint." << std::endl;
-                    return false;
-                }
-                std::string value = record.getValue(col);
-                // Ensure that primary key value is not empty.
-                if (value.empty()) {
-                    std::cerr << "Error: Primary key column '" << col << "' cannot be empty." << std::endl;
+void Table::touch() {
+    version = nextVersion++;
+}
+
+uint64_t Table::getVersion() const {
+    return version;
+}
+
+// Resolve column names to ordinals; returns false if a column is not in the schema.
+bool Table::resolveColumns(const std::vector<std::string>& columnNames, std::vector<size_t>& ordinals) const {
+    ordinals.clear();
+    for (const auto& col : columnNames) {
+        int ordinal = schema.getColumnIndex(col);
+        if (ordinal < 0)
+            return false;
+        ordinals.push_back(static_cast<size_t>(ordinal));
+    }
+    return true;
+}
+
+// Check a value against the definition of the column at an ordinal: its type and NOT NULL.
+bool Table::checkValue(size_t ordinal, const Value& value) const {
+    const Column& column = schema.getColumns()[ordinal];
+    if (value.isNull()) {
+        if (!column.isNullable()) {
+            std::cerr << "Error: Column '" << column.getName() << "' cannot be NULL." << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (value.getType() != column.getType()) {
+        std::cerr << "Error: Value '" << value.toString() << "' does not match the type of column '"
+            << column.getName() << "'." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Report a primary key value that is NULL or an empty string.
+static bool isMissingKeyValue(const Value& value) {
+    return value.isNull() || (value.getType() == DataType::STRING && value.getString().empty());
+}
+
+// Report a duplicate key on an index.
+static void reportDuplicate(const HashIndex& index) {
+    std::cerr << "Error: Duplicate entry for " << (index.isPrimary() ? "primary key" : "unique constraint")
+        << " on columns:";
+    for (const auto& col : index.getColumnNames())
+        std::cerr << " " << col;
+    std::cerr << std::endl;
+}
+
+// Check a record against the column definitions and compute its key for every PK/UNIQUE index.
+bool Table::checkRecord(const Record& record, std::string* keys, char* hasKey) const {
+    if (record.size() != schema.getColumns().size()) {
+        std::cerr << "Error: Record has " << record.size() << " value(s) but table '" << name << "' has "
+            << schema.getColumns().size() << " column(s)." << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < record.size(); ++i) {
+        if (!checkValue(i, record.getValue(i)))
+            return false;
+    }
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        const HashIndex& index = indexes[i];
+
+        // Primary key values can be neither NULL nor empty.
+        if (index.isPrimary()) {
+            for (size_t k = 0; k < index.getOrdinals().size(); ++k) {
+                if (isMissingKeyValue(record.getValue(index.getOrdinals()[k]))) {
+                    std::cerr << "Error: Primary key column '" << index.getColumnNames()[k] << "' cannot be empty." << std::endl;
                     return false;
                 }
-                newValues.push_back(value);
             }
+        }
 
-            // Check against existing records for duplicate key values.
-            for (const auto& existingRecord : records) {
-                std::vector<std::string> existingValues;
-                bool missing = false;
-                for (const auto& col : keyColumns) {
-                    if (!existingRecord.hasColumn(col)) {
-                        missing = true;
-                        break;
-                    }
-                    existingValues.push_back(existingRecord.getValue(col));
-                }
-                if (missing)
-                    continue;
-
-                if (existingValues == newValues) {
-                    std::cerr << "Error: Duplicate entry for primary key on columns:";
-                    for (const auto& col : keyColumns)
-                        std::cerr << " " << col;
-                    std::cerr << std::endl;
-                    return false;
+        // A key containing NULL is not indexed and never conflicts.
+        hasKey[i] = index.makeKey(record, keys[i]);
+    }
+    return true;
+}
+
+// Insert a record into the table after validating constraints.
+bool Table::insertRecord(const Record& record) {
+    return insertRecords(std::vector<Record>(1, record));
+}
+
+/**
+ * @brief Insert a batch of records after validating all of them.
+ *
+ * Keys are registered in the PK/UNIQUE indexes while the batch is validated, so a duplicate is
+ * detected with a single hash lookup whether it clashes with an existing record or with an earlier
+ * record of the batch; on the first failure the keys registered so far are withdrawn and nothing
+ * is inserted. The records are then appended in one pass after a single reservation.
+ */
+bool Table::insertRecords(const std::vector<Record>& records) {
+    size_t first = storage->size();
+    size_t width = indexes.size();
+    std::vector<std::string> keys(records.size() * width);
+    std::vector<char> hasKey(records.size() * width, 0);
+    for (auto& index : indexes)
+        index.reserve(records.size());
+
+    // Check every PRIMARY KEY / UNIQUE index.
+    // Other constraint types (e.g., ForeignKeyConstraint) can be handled here.
+    for (size_t r = 0; r < records.size(); ++r) {
+        std::string* rowKeys = keys.data() + r * width;
+        char* rowHasKey = hasKey.data() + r * width;
+        bool valid = checkRecord(records[r], rowKeys, rowHasKey);
+        for (size_t i = 0; valid && i < width; ++i) {
+            if (!rowHasKey[i])
+                continue;
+            if (indexes[i].contains(rowKeys[i])) {
+                reportDuplicate(indexes[i]);
+                valid = false;
+                // Withdraw the keys of this record that were already registered.
+                for (size_t j = 0; j < i; ++j) {
+                    if (rowHasKey[j])
+                        indexes[j].erase(rowKeys[j]);
                 }
+                break;
             }
+            indexes[i].insert(rowKeys[i], first + r);
         }
-        else if (auto uq = dynamic_cast<UniqueConstraint*>(constraint.get())) {
-            // Get the list of columns for the unique constraint.
-            std::vector<std::string> keyColumns = uq->getColumnNames();
-            std::vector<std::string> newValues;
-
-            // Gather values from the new record.
-            for (const auto& col : keyColumns) {
-                if (!record.hasColumn(col)) {
-                    std::cerr << "Error: Record is missing required column '" << col
-                        << "' for unique constraint." << std::endl;
-                    return false;
+        if (!valid) {
+            for (size_t e = 0; e < r * width; ++e) {
+                if (hasKey[e])
+                    indexes[e % width].erase(keys[e]);
+            }
+            if (records.size() > 1)
+                std::cerr << "Error: Record " << (r + 1) << " of the batch was rejected; no record was inserted." << std::endl;
+            return false;
+        }
+    }
+
+    // All checks passed; append the records and register them in the secondary indexes.
+    touch();
+    storage->reserve(first + records.size());
+    for (const auto& record : records)
+        storage->append(record);
+    for (auto& index : secondaryIndexes) {
+        // A batch as large as the table is cheaper to bulk-load than to insert entry by entry.
+        if (records.size() >= first) {
+            index.rebuild(*storage);
+            continue;
+        }
+        for (size_t position = first; position < storage->size(); ++position)
+            index.insert(*storage, position);
+    }
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        if (records.size() == 1)
+            std::cout << "Record inserted into table '" << name << "'.\n";
+        else
+            std::cout << records.size() << " records inserted into table '" << name << "'.\n";
+    }
+    return true;
+}
+
+bool Table::loadRecords(const std::vector<Record>& records) {
+    touch();
+    storage->reserve(storage->size() + records.size());
+    for (const auto& record : records)
+        storage->append(record);
+    bool unique = true;
+    for (auto& index : indexes) {
+        if (!index.rebuild(*storage)) {
+            reportDuplicate(index);
+            unique = false;
+        }
+    }
+    for (auto& index : secondaryIndexes)
+        index.rebuild(*storage);
+    return unique;
+}
+
+// Check whether an index covers one of the assigned columns.
+static bool coversAssignment(const std::vector<size_t>& ordinals, const std::vector<std::pair<size_t, Value>>& assignments) {
+    for (const auto& assignment : assignments) {
+        if (std::find(ordinals.begin(), ordinals.end(), assignment.first) != ordinals.end())
+            return true;
+    }
+    return false;
+}
+
+// Apply an update to the given record positions while keeping the PK/UNIQUE indexes consistent.
+bool Table::applyUpdate(const std::vector<size_t>& positions, const std::vector<std::pair<size_t, Value>>& assignments) {
+    for (const auto& assignment : assignments) {
+        if (!checkValue(assignment.first, assignment.second))
+            return false;
+    }
+
+    // Only indexes that contain an updated column can change.
+    std::vector<size_t> affected;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        if (coversAssignment(indexes[i].getOrdinals(), assignments))
+            affected.push_back(i);
+    }
+
+    // Compute the new key of every updated record and reject the whole update on the first conflict:
+    // a new key may only collide with a record that is itself being updated (and thus releases its old key).
+    std::vector<char> updating;
+    if (!affected.empty()) {
+        updating.assign(storage->size(), 0);
+        for (size_t pos : positions)
+            updating[pos] = 1;
+    }
+    std::vector<std::vector<std::string>> newKeys(affected.size(), std::vector<std::string>(positions.size()));
+    std::vector<std::vector<char>> hasNewKey(affected.size(), std::vector<char>(positions.size(), 0));
+    for (size_t a = 0; a < affected.size(); ++a) {
+        const HashIndex& index = indexes[affected[a]];
+        std::unordered_set<std::string> seen;
+        for (size_t p = 0; p < positions.size(); ++p) {
+            std::vector<Value> values;
+            for (size_t ordinal : index.getOrdinals()) {
+                const Value* assigned = nullptr;
+                for (const auto& assignment : assignments) {
+                    if (assignment.first == ordinal)
+                        assigned = &assignment.second;
                 }
-                newValues.push_back(record.getValue(col));
+                values.push_back(assigned ? *assigned : storage->getValue(positions[p], ordinal));
             }
 
-            // Check against existing records for duplicate key values.
-            for (const auto& existingRecord : records) {
-                std::vector<std::string> existingValues;
-                bool missing = false;
-                for (const auto& col : keyColumns) {
-                    if (!existingRecord.hasColumn(col)) {
-                        missing = true;
-                        break;
+            if (index.isPrimary()) {
+                for (size_t k = 0; k < values.size(); ++k) {
+                    if (isMissingKeyValue(values[k])) {
+                        std::cerr << "Error: Primary key column '" << index.getColumnNames()[k] << "' cannot be empty." << std::endl;
+                        return false;
                     }
-                    existingValues.push_back(existingRecord.getValue(col));
-                }
-                if (missing)
-                    continue;
-
-                if (existingValues == newValues) {
-                    std::cerr << "Error: Duplicate entry for unique constraint on columns:";
-                    for (const auto& col : keyColumns)
-                        std::cerr << " " << col;
-                    std::cerr << std::endl;
-                    return false;
                 }
             }
+
+            std::string key;
+            if (!index.makeKey(values, key))
+                continue; // A key containing NULL is not indexed.
+            size_t owner = 0;
+            if (!seen.insert(key).second || (index.find(key, owner) && !updating[owner])) {
+                reportDuplicate(index);
+                return false;
+            }
+            newKeys[a][p] = std::move(key);
+            hasNewKey[a][p] = 1;
         }
-        // Other constraint types (e.g., ForeignKeyConstraint) can be handled here.
     }
 
-    // Additional validation against column definitions can be added here if needed.
+    // Secondary indexes that contain an updated column must re-key the updated records.
+    std::vector<SecondaryIndex*> affectedSecondary;
+    for (auto& index : secondaryIndexes) {
+        if (coversAssignment(index.getOrdinals(), assignments))
+            affectedSecondary.push_back(&index);
+    }
 
-    // All checks passed; insert the record.
-    records.push_back(record);
-    std::cout << "Record inserted into table '" << name << "'." << std::endl;
+    // Release the old keys of the updated records before registering the new ones.
+    std::string oldKey;
+    for (size_t a = 0; a < affected.size(); ++a) {
+        HashIndex& index = indexes[affected[a]];
+        for (size_t pos : positions) {
+            if (index.makeKey(*storage, pos, oldKey))
+                index.erase(oldKey);
+        }
+    }
+    for (SecondaryIndex* index : affectedSecondary) {
+        for (size_t pos : positions)
+            index->erase(*storage, pos);
+    }
+    for (size_t pos : positions) {
+        for (const auto& assignment : assignments) {
+            storage->setValue(pos, assignment.first, assignment.second);
+        }
+    }
+    for (size_t a = 0; a < affected.size(); ++a) {
+        HashIndex& index = indexes[affected[a]];
+        for (size_t p = 0; p < positions.size(); ++p) {
+            if (hasNewKey[a][p])
+                index.insert(newKeys[a][p], positions[p]);
+        }
+    }
+    for (SecondaryIndex* index : affectedSecondary) {
+        for (size_t pos : positions)
+            index->insert(*storage, pos);
+    }
     return true;
 }
 
+// Rebuild every index from the current records.
+void Table::rebuildIndexes() {
+    for (auto& index : indexes) {
+        index.rebuild(*storage);
+    }
+    for (auto& index : secondaryIndexes) {
+        index.rebuild(*storage);
+    }
+}
+
 /**
- * @brief Update records in the table based on a condition.
+ * @brief Find the records matching a condition.
  *
- * If condition is empty or "all", update all records.
- * Otherwise, expects condition in the form "column = value".
- * For each matching record, all key-value pairs in newRecord are applied.
+ * The condition is bound once, before any record is read; the bound tree is then answered
+ * through the indexes where they apply and by scanning the storage elsewhere (see evaluate()).
  */
-bool Table::updateRecord(const Record& newRecord, const std::string& condition) {
-    bool updated = false;
-    std::string cond = trim(condition);
-
-    // If condition is empty or "all", update all records.
-    if (cond.empty() || cond == "all") {
-        for (auto& record : records) {
-            for (const auto& pair : newRecord.getData()) {
-                record.setValue(pair.first, pair.second);
+bool Table::findRecords(const Condition& condition, std::vector<size_t>& positions) const {
+    positions.clear();
+    // Resolve the columns and convert the literals to their types once, before looking at any record.
+    Predicate predicate;
+    if (!predicate.bind(condition, schema, name))
+        return false;
+    evaluate(predicate.getRoot(), positions);
+    return true;
+}
+
+// The single-column PRIMARY KEY / UNIQUE index that answers an equality (or IN), if there is one.
+const HashIndex* Table::findHashIndex(const Predicate::Node& node) const {
+    bool equality = (node.kind == Predicate::Kind::COMPARE && node.op == Predicate::Op::EQUAL)
+        || (node.kind == Predicate::Kind::IN && !node.negated);
+    if (!equality)
+        return nullptr;
+    for (const auto& index : indexes) {
+        if (index.getOrdinals().size() == 1 && index.getOrdinals()[0] == node.ordinal)
+            return &index;
+    }
+    return nullptr;
+}
+
+// The secondary index led by the column of a comparison (but "<>"), BETWEEN or IN, if there is one.
+const SecondaryIndex* Table::findSecondaryIndex(const Predicate::Node& node) const {
+    bool range = (node.kind == Predicate::Kind::COMPARE && node.op != Predicate::Op::NOT_EQUAL)
+        || node.kind == Predicate::Kind::BETWEEN || (node.kind == Predicate::Kind::IN && !node.negated);
+    if (!range)
+        return nullptr;
+    for (const auto& index : secondaryIndexes) {
+        if (index.getOrdinals()[0] == node.ordinal)
+            return &index;
+    }
+    return nullptr;
+}
+
+bool Table::isIndexed(const Predicate::Node& node) const {
+    switch (node.kind) {
+    case Predicate::Kind::AND:
+        return std::any_of(node.children.begin(), node.children.end(),
+            [this](const Predicate::Node& child) { return isIndexed(child); });
+    case Predicate::Kind::OR:
+        return std::all_of(node.children.begin(), node.children.end(),
+            [this](const Predicate::Node& child) { return isIndexed(child); });
+    default:
+        return findHashIndex(node) || findSecondaryIndex(node);
+    }
+}
+
+void Table::lookUp(const Predicate::Node& node, std::vector<size_t>& positions) const {
+    std::vector<size_t> found;
+    if (const HashIndex* index = findHashIndex(node)) {
+        // One lookup per value.
+        std::string key;
+        size_t position = 0;
+        for (const auto& value : node.values) {
+            if (index->makeKey({ value }, key) && index->find(key, position))
+                found.push_back(position);
+        }
+    }
+    else if (const SecondaryIndex* index = findSecondaryIndex(node)) {
+        // B+tree range scans.
+        if (node.kind == Predicate::Kind::COMPARE)
+            index->findRange(node.op, node.values[0], found);
+        else if (node.kind == Predicate::Kind::IN) {
+            for (const auto& value : node.values)
+                index->findRange(Predicate::Op::EQUAL, value, found);
+        }
+        else {
+            // From the low bound up; the scan stops at the first value past the high one.
+            std::vector<size_t> above;
+            index->findRange(Predicate::Op::GREATER_EQUAL, node.values[0], above);
+            for (size_t position : above) {
+                if (storage->compareValue(position, node.ordinal, node.values[1]) > 0)
+                    break;
+                found.push_back(position);
             }
         }
-        std::cout << "Updated all records in table '" << name << "'.\n";
-        return true;
     }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    positions.swap(found);
+}
 
-    // Otherwise, assume condition is of the form "column = value".
-    size_t pos = cond.find('=');
-    if (pos == std::string::npos) {
-        std::cerr << "Error: Invalid condition format in updateRecord.\n";
-        return false;
+void Table::evaluate(const Predicate::Node& node, std::vector<size_t>& positions) const {
+    positions.clear();
+    if (node.kind == Predicate::Kind::ALL) {
+        positions.resize(storage->size());
+        for (size_t i = 0; i < positions.size(); ++i)
+            positions[i] = i;
+        return;
     }
-    std::string condCol = trim(cond.substr(0, pos));
-    std::string condVal = trim(cond.substr(pos + 1));
+    if (node.kind == Predicate::Kind::NONE)
+        return;
 
-    // Iterate through records, updating those that meet the condition.
-    for (auto& record : records) {
-        try {
-            const std::string& value = record.getValue(condCol);
-            if (value == condVal) {
-                for (const auto& pair : newRecord.getData()) {
-                    record.setValue(pair.first, pair.second);
-                }
-                updated = true;
+    // What no index answers is scanned in batches.
+    if (!isIndexed(node)) {
+        Batch batch(*storage, schema);
+        size_t total = storage->size();
+        for (size_t begin = 0; begin < total; begin += Batch::SIZE) {
+            batch.readRange(begin, std::min(total, begin + Batch::SIZE) - begin);
+            batch.filter(node);
+            batch.appendPositions(positions);
+        }
+        return;
+    }
+
+    if (node.kind == Predicate::Kind::AND) {
+        // An operand that an index answers finds the candidates; the other operands check them in batches.
+        auto driver = std::find_if(node.children.begin(), node.children.end(),
+            [this](const Predicate::Node& child) { return isIndexed(child); });
+        std::vector<size_t> candidates;
+        evaluate(*driver, candidates);
+        Batch batch(*storage, schema);
+        for (size_t begin = 0; begin < candidates.size(); begin += Batch::SIZE) {
+            batch.readRows(candidates.data() + begin, std::min(candidates.size(), begin + Batch::SIZE) - begin);
+            for (auto child = node.children.begin(); child != node.children.end(); ++child) {
+                if (child != driver)
+                    batch.filter(*child);
             }
+            batch.appendPositions(positions);
         }
-        catch (const std::runtime_error& e) {
-            // If the record does not have the column, ignore.
+    }
+    else if (node.kind == Predicate::Kind::OR) {
+        // Every operand is answered by an index: merge what they find.
+        std::vector<size_t> operand;
+        std::vector<size_t> merged;
+        for (const auto& child : node.children) {
+            evaluate(child, operand);
+            merged.clear();
+            std::set_union(positions.begin(), positions.end(), operand.begin(), operand.end(), std::back_inserter(merged));
+            positions.swap(merged);
+        }
+    }
+    else
+        lookUp(node, positions);
+}
+
+void Table::formatRecords(const size_t* positions, size_t count, const std::vector<size_t>& ordinals, std::string& text) const {
+    Batch batch(*storage, schema);
+    for (size_t begin = 0; begin < count; begin += Batch::SIZE) {
+        size_t rowCount = std::min(count, begin + Batch::SIZE) - begin;
+        // Consecutive rows are read in place where the storage allows it.
+        bool consecutive = true;
+        for (size_t i = begin + 1; consecutive && i < begin + rowCount; ++i)
+            consecutive = positions[i] == positions[i - 1] + 1;
+        if (consecutive)
+            batch.readRange(positions[begin], rowCount);
+        else
+            batch.readRows(positions + begin, rowCount);
+        batch.format(ordinals, text);
+    }
+}
+
+/**
+ * @brief Aggregate the records matching a condition.
+ *
+ * Without an index to answer the condition, each batch is filtered and aggregated as it is read, so the
+ * matching records are never collected; otherwise the records the indexes find are read a batch at a time.
+ */
+bool Table::aggregate(const Condition& condition, Aggregation& aggregation) const {
+    Predicate predicate;
+    if (!predicate.bind(condition, schema, name))
+        return false;
+    const Predicate::Node& root = predicate.getRoot();
+    if (root.kind == Predicate::Kind::NONE)
+        return true;
+    const std::vector<size_t>& ordinals = aggregation.getGroupOrdinals();
+    Batch batch(*storage, schema);
+    if (!isIndexed(root)) {
+        size_t total = storage->size();
+        aggregation.reserve(estimateGroups(ordinals, total));
+        for (size_t begin = 0; begin < total; begin += Batch::SIZE) {
+            batch.readRange(begin, std::min(total, begin + Batch::SIZE) - begin);
+            batch.filter(root);
+            if (!aggregation.add(batch))
+                return false;
         }
+        return true;
     }
+    std::vector<size_t> positions;
+    evaluate(root, positions);
+    aggregation.reserve(estimateGroups(ordinals, positions.size()));
+    for (size_t begin = 0; begin < positions.size(); begin += Batch::SIZE) {
+        batch.readRows(positions.data() + begin, std::min(positions.size(), begin + Batch::SIZE) - begin);
+        if (!aggregation.add(batch))
+            return false;
+    }
+    return true;
+}
 
-    if (updated) {
-        std::cout << "Updated records satisfying condition: " << condition << "\n";
+/**
+ * @brief Estimate the number of distinct keys of some columns among a number of the records.
+ *
+ * A PRIMARY KEY or UNIQUE index on some of the columns makes every record a key of its own. Otherwise the
+ * keys of an even sample of the table are counted and extrapolated with the Guaranteed-Error Estimator: a
+ * key seen more than once stands for itself, a key seen once for sqrt(records / sample) keys.
+ */
+size_t Table::estimateGroups(const std::vector<size_t>& ordinals, size_t rowCount) const {
+    if (ordinals.empty() || rowCount <= 1)
+        return 1;
+    for (const auto& index : indexes) {
+        const auto& keyOrdinals = index.getOrdinals();
+        bool covered = std::all_of(keyOrdinals.begin(), keyOrdinals.end(),
+            [&ordinals](size_t ordinal) { return std::find(ordinals.begin(), ordinals.end(), ordinal) != ordinals.end(); });
+        if (covered)
+            return rowCount;
+    }
+    size_t total = storage->size();
+    size_t sampleSize = std::min(total, GROUP_SAMPLE);
+    std::unordered_map<std::string, size_t> seen;
+    std::string key;
+    for (size_t i = 0; i < sampleSize; ++i) {
+        size_t row = i * total / sampleSize;
+        key.clear();
+        for (size_t ordinal : ordinals)
+            storage->getValue(row, ordinal).appendKey(key);
+        ++seen[key];
     }
-    else {
-        std::cout << "No records match condition: " << condition << "\n";
+    size_t once = 0;
+    size_t repeated = 0;
+    for (const auto& entry : seen)
+        ++(entry.second == 1 ? once : repeated);
+    double estimate = std::sqrt(static_cast<double>(total) / static_cast<double>(sampleSize)) * static_cast<double>(once)
+        + static_cast<double>(repeated);
+    return std::max(size_t(1), std::min(rowCount, static_cast<size_t>(estimate)));
+}
+
+/**
+ * @brief Update records in the table based on a condition.
+ *
+ * If the condition has no column, update all records.
+ * For each matching record, every (column ordinal, value) assignment is applied.
+ */
+bool Table::updateRecord(const std::vector<std::pair<size_t, Value>>& assignments, const Condition& condition,
+    size_t* affected) {
+    std::vector<size_t> positions;
+    if (!findRecords(condition, positions))
+        return false;
+
+    // The records that meet the condition (all of them without one) are updated together.
+    if (!positions.empty() && !applyUpdate(positions, assignments))
+        return false;
+    if (!positions.empty())
+        touch();
+    if (affected)
+        *affected = positions.size();
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        if (condition.matchesAll())
+            std::cout << "Updated all records in table '" << name << "'.\n";
+        else if (positions.empty())
+            std::cout << "No records match condition: " << condition.toString() << "\n";
+        else
+            std::cout << "Updated records satisfying condition: " << condition.toString() << "\n";
     }
-    return updated;
+    return true;
 }
 
 /**
  * @brief Delete records from the table based on a condition.
  *
- * If condition is "all", delete all records.
- * Otherwise, expects condition in the form "column = value".
+ * If the condition has no column, delete all records.
  */
-bool Table::deleteRecord(const std::string& condition) {
-    std::string cond = trim(condition);
-    if (cond == "all") {
-        records.clear();
-        std::cout << "All records in table '" << name << "' have been deleted.\n";
+bool Table::deleteRecord(const Condition& condition, size_t* affected) {
+    if (condition.matchesAll()) {
+        if (affected)
+            *affected = storage->size();
+        if (storage->size() > 0)
+            touch();
+        storage->clear();
+        rebuildIndexes();
+        if (Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "All records in table '" << name << "' have been deleted.\n";
         return true;
     }
 
-    // Assume condition is of the form "column = value".
-    size_t pos = cond.find('=');
-    if (pos == std::string::npos) {
-        std::cerr << "Error: Invalid condition format in deleteRecord.\n";
+    std::vector<size_t> positions;
+    if (!findRecords(condition, positions))
         return false;
+
+    if (!positions.empty() && positions.size() * FEW_RECORDS <= storage->size()) {
+        // A few records (typically found through an index): each is replaced by the last record, so only the
+        // keys of the records removed and moved change. From the highest position down, the last record is
+        // never one still to be removed.
+        for (size_t i = positions.size(); i-- > 0;)
+            removeRecord(positions[i]);
     }
-    std::string condCol = trim(cond.substr(0, pos));
-    std::string condVal = trim(cond.substr(pos + 1));
-    if (!condVal.empty() && condVal.front() == '\'' && condVal.back() == '\'') {
-        condVal = condVal.substr(1, condVal.size() - 2);
+    else if (!positions.empty()) {
+        // Remove records that satisfy the condition in one compaction pass, then re-point the indexes.
+        std::vector<char> doomed(storage->size(), 0);
+        for (size_t position : positions)
+            doomed[position] = 1;
+        storage->eraseRows(doomed);
+        rebuildIndexes();
     }
 
-    size_t beforeSize = records.size();
-    // Remove records that satisfy the condition.
-    auto newEnd = std::remove_if(records.begin(), records.end(), [&](const Record& record) {
-        try {
-            return record.getValue(condCol) == condVal;
+    if (!positions.empty())
+        touch();
+    if (affected)
+        *affected = positions.size();
+    if (Logger::isEnabled(LogLevel::VERBOSE)) {
+        if (!positions.empty()) {
+            std::cout << "Deleted " << positions.size()
+                << " record(s) from table '" << name << "' matching condition: " << condition.toString() << "\n";
         }
-        catch (const std::runtime_error&) {
-            return false;
+        else {
+            std::cout << "No records match condition: " << condition.toString() << " in table '" << name << "'\n";
+        }
+    }
+    return true;
+}
+
+// Remove one record by moving the last record into its place, re-keying the moved record in the indexes.
+void Table::removeRecord(size_t position) {
+    size_t last = storage->size() - 1;
+    std::string key;
+    for (auto& index : indexes) {
+        if (index.makeKey(*storage, position, key))
+            index.erase(key);
+        if (position != last && index.makeKey(*storage, last, key))
+            index.insert(key, position);
+    }
+    for (auto& index : secondaryIndexes) {
+        index.erase(*storage, position);
+        if (position != last)
+            index.erase(*storage, last);
+    }
+    storage->removeRow(position);
+    if (position != last) {
+        for (auto& index : secondaryIndexes)
+            index.insert(*storage, position);
+    }
+}
+
+// Sort positions by a column, walking a secondary index when one leads with that column.
+bool Table::sortRecords(std::vector<size_t>& positions, const std::string& column, bool descending) const {
+    int ordinal = schema.getColumnIndex(column);
+    if (ordinal < 0) {
+        std::cerr << "Error: Column '" << column << "' does not exist in table '" << name << "'." << std::endl;
+        return false;
+    }
+
+    for (const auto& index : secondaryIndexes) {
+        if (index.getOrdinals()[0] != static_cast<size_t>(ordinal))
+            continue;
+        // Walking the index is linear in the table size; sorting a small selection directly is cheaper.
+        size_t selected = positions.size();
+        size_t logSelected = 1;
+        while ((size_t(1) << logSelected) < selected)
+            ++logSelected;
+        if (selected * logSelected < storage->size())
+            break;
+
+        std::vector<char> wanted(storage->size(), 0);
+        for (size_t position : positions)
+            wanted[position] = 1;
+        positions.clear();
+        for (auto cursor = index.getTree().begin(); cursor.valid(); cursor.next()) {
+            if (wanted[cursor.position()])
+                positions.push_back(cursor.position());
         }
+        if (descending)
+            std::reverse(positions.begin(), positions.end());
+        return true;
+    }
+
+    // No usable index: fetch the sort values once, then sort by the typed values (NULL first).
+    std::vector<std::pair<Value, size_t>> keyed;
+    keyed.reserve(positions.size());
+    for (size_t position : positions)
+        keyed.emplace_back(storage->getValue(position, ordinal), position);
+    std::stable_sort(keyed.begin(), keyed.end(), [descending](const std::pair<Value, size_t>& a, const std::pair<Value, size_t>& b) {
+        int cmp = a.first.compare(b.first);
+        return descending ? cmp > 0 : cmp < 0;
         });
-    records.erase(newEnd, records.end());
-    size_t afterSize = records.size();
+    for (size_t i = 0; i < keyed.size(); ++i)
+        positions[i] = keyed[i].second;
+    return true;
+}
 
-    bool deleted = (beforeSize > afterSize);
-    if (deleted) {
-        std::cout << "Deleted " << (beforeSize - afterSize)
-            << " record(s) from table '" << name << "' matching condition: " << condition << "\n";
+// Create a secondary index on the given columns and build it from the existing records.
+bool Table::createIndex(const std::string& indexName, const std::vector<std::string>& columnNames) {
+    if (hasIndex(indexName)) {
+        std::cerr << "Error: Index '" << indexName << "' already exists on table '" << name << "'." << std::endl;
+        return false;
+    }
+    std::vector<size_t> ordinals;
+    for (const auto& col : columnNames) {
+        if (!schema.hasColumn(col)) {
+            std::cerr << "Error: Column '" << col << "' does not exist in table '" << name << "'." << std::endl;
+            return false;
+        }
+    }
+    if (columnNames.empty()) {
+        std::cerr << "Error: An index needs at least one column." << std::endl;
+        return false;
+    }
+    resolveColumns(columnNames, ordinals);
+    secondaryIndexes.emplace_back(indexName, columnNames, ordinals);
+    secondaryIndexes.back().rebuild(*storage);
+    touch();
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Index '" << indexName << "' created on table '" << name << "'.\n";
+    return true;
+}
+
+// Drop a secondary index by name.
+bool Table::dropIndex(const std::string& indexName) {
+    for (auto it = secondaryIndexes.begin(); it != secondaryIndexes.end(); ++it) {
+        if (it->getName() == indexName) {
+            secondaryIndexes.erase(it);
+            touch();
+            if (Logger::isEnabled(LogLevel::VERBOSE))
+                std::cout << "Index '" << indexName << "' dropped from table '" << name << "'.\n";
+            return true;
+        }
     }
-    else {
-        std::cout << "No records match condition: " << condition << " in table '" << name << "'\n";
+    return false;
+}
+
+// Check whether a secondary index with the given name exists.
+bool Table::hasIndex(const std::string& indexName) const {
+    for (const auto& index : secondaryIndexes) {
+        if (index.getName() == indexName)
+            return true;
     }
-    return deleted;
+    return false;
+}
+
+// Get the secondary indexes of the table.
+const std::vector<SecondaryIndex>& Table::getIndexes() const {
+    return secondaryIndexes;
 }
 
-// Get all records in the table.
-const std::vector<Record>& Table::getRecords() const {
+// Get all records in the table, materialized from the storage.
+std::vector<Record> Table::getRecords() const {
+    std::vector<Record> records;
+    records.reserve(storage->size());
+    for (size_t i = 0; i < storage->size(); ++i)
+        records.push_back(storage->getRecord(i));
     return records;
 }
 
+// Get the number of records in the table.
+size_t Table::getRecordCount() const {
+    return storage->size();
+}
+
+// Get the record at a position.
+Record Table::getRecord(size_t position) const {
+    return storage->getRecord(position);
+}
+
+// Get one value of the record at a position.
+Value Table::getValue(size_t position, size_t ordinal) const {
+    return storage->getValue(position, ordinal);
+}
+
+// Check whether one value of the record at a position is NULL.
+bool Table::isNull(size_t position, size_t ordinal) const {
+    return storage->isNull(position, ordinal);
+}
+
+// Get the physical layout of the rows.
+StorageLayout Table::getLayout() const {
+    return storage->getLayout();
+}
+
 // Get the schema of the table.
 const Schema& Table::getSchema() const {
     return schema;
 }
 
+// Drop the foreign keys that reference another table (when that table is dropped).
+bool Table::dropForeignKeys(const std::string& referencedTable) {
+    auto& constraints = const_cast<std::vector<std::shared_ptr<Constraint>>&>(schema.getConstraints());
+    size_t constraintCount = constraints.size();
+    constraints.erase(std::remove_if(constraints.begin(), constraints.end(),
+        [&referencedTable](const std::shared_ptr<Constraint>& c) {
+            if (auto fk = dynamic_cast<ForeignKeyConstraint*>(c.get())) {
+                return fk->getReferencedTable() == referencedTable;
+            }
+            return false;
+        }), constraints.end());
+    if (constraints.size() == constraintCount)
+        return false;
+    touch();
+    return true;
+}
+
 // Drop a column from the table.
 bool Table::dropColumn(const std::string& columnName) {
     // Check if the column exists in the schema.
-    if (!getSchema().hasColumn(columnName)) {
+    int ordinal = schema.getColumnIndex(columnName);
+    if (ordinal < 0) {
         std::cerr << "Error: Column '" << columnName << "' does not exist in table '" << name << "'." << std::endl;
         return false;
     }
-    // Remove the column from the schema.
-    auto& cols = const_cast<std::vector<Column>&>(schema.getColumns());
-    cols.erase(std::remove_if(cols.begin(), cols.end(), [columnName](const Column& col) {
-        return col.getName() == columnName;
-        }), cols.end());
-    // Remove the column from all records.
-    for (auto& record : records) {
-        auto& data = const_cast<std::unordered_map<std::string, std::string>&>(record.getData());
-        data.erase(columnName);
-    }
-    std::cout << "DROP COLUMN: Column '" << columnName << "' dropped from table '" << name << "'." << std::endl;
+    // Columns of a PRIMARY KEY or UNIQUE constraint cannot be dropped.
+    for (const auto& index : indexes) {
+        const auto& ordinals = index.getOrdinals();
+        if (std::find(ordinals.begin(), ordinals.end(), static_cast<size_t>(ordinal)) != ordinals.end()) {
+            std::cerr << "Error: Column '" << columnName << "' is part of a "
+                << (index.isPrimary() ? "primary key" : "unique constraint") << " and cannot be dropped." << std::endl;
+            return false;
+        }
+    }
+
+    // Remove the column from the schema and its value from all records.
+    touch();
+    schema.removeColumn(ordinal);
+    storage->eraseColumn(ordinal);
+
+    // Secondary indexes on the dropped column go away with it.
+    for (auto it = secondaryIndexes.begin(); it != secondaryIndexes.end();) {
+        const auto& ordinals = it->getOrdinals();
+        if (std::find(ordinals.begin(), ordinals.end(), static_cast<size_t>(ordinal)) != ordinals.end()) {
+            if (Logger::isEnabled(LogLevel::NORMAL))
+                std::cout << "Index '" << it->getName() << "' dropped along with column '" << columnName << "'.\n";
+            it = secondaryIndexes.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Later columns moved down by one ordinal; the index keys themselves are unchanged.
+    std::vector<size_t> ordinals;
+    for (auto& index : indexes) {
+        resolveColumns(index.getColumnNames(), ordinals);
+        index.setOrdinals(ordinals);
+    }
+    for (auto& index : secondaryIndexes) {
+        resolveColumns(index.getColumnNames(), ordinals);
+        index.setOrdinals(ordinals);
+    }
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Column '" << columnName << "' dropped from table '" << name << "'.\n";
     return true;
 }
@@ -5,14 +5,23 @@
 #include <memory>
 #include "Schema.h"
 #include "Record.h"
+#include "TableStorage.h"
+#include "Condition.h"
+#include "Predicate.h"
+#include "HashIndex.h"
+#include "SecondaryIndex.h"
+
+// Forward declaration to avoid circular dependencies.
+class Aggregation;
 
 /**
  * @brief The Table class represents a table (relation) in the database.
  *
  * Responsibilities:
  * - Manages the schema (structure) of the table.
- * - Stores the records (rows) of the table.
+ * - Stores the records (rows) of the table in a row or columnar TableStorage.
  * - Provides CRUD operations: insert, update, delete records.
+ * - Maintains a hash index per PRIMARY KEY/UNIQUE constraint and any secondary (B+tree) indexes.
  *
  * Usage:
  * - Create a new table with a specified schema.
@@ -25,8 +34,9 @@ public:
      * @brief Construct a new Table object.
      * @param tableName The name of the table.
      * @param schema The schema defining the structure of the table.
+     * @param layout The physical layout of the rows (default is row-wise).
      */
-    Table(const std::string& tableName, const Schema& schema);
+    Table(const std::string& tableName, const Schema& schema, StorageLayout layout = StorageLayout::ROW);
 
     /**
      * @brief Destroy the Table object.
@@ -35,31 +45,176 @@ public:
 
     /**
      * @brief Insert a record into the table after validating constraints.
+     *
+     * The record must hold one value per schema column, of the column's type or NULL.
      * @param record The record to insert.
      * @return true if the record was successfully inserted; false otherwise.
      */
     bool insertRecord(const Record& record);
 
+    /**
+     * @brief Insert a batch of records, validating all of them before any is inserted.
+     *
+     * Every record must hold one value per schema column, of the column's type or NULL.
+     * If any record violates a column definition or a PRIMARY KEY/UNIQUE constraint (including
+     * a duplicate within the batch), nothing is inserted.
+     * @param records The records to insert.
+     * @return true if all records were inserted; false otherwise.
+     */
+    bool insertRecords(const std::vector<Record>& records);
+
+    /**
+     * @brief Append a batch of records read back from a snapshot, without validating them one by one.
+     *
+     * The records were valid when the snapshot was written, and its checksums have been verified since, so
+     * the column definitions are not checked again; the PRIMARY KEY/UNIQUE indexes are rebuilt in one pass
+     * over the table instead of probed record by record.
+     * @param records The records, each holding one value per schema column, of the column's type or NULL.
+     * @return true if the records were appended; false if two records share a PRIMARY KEY/UNIQUE key (the
+     * table must then be discarded).
+     */
+    bool loadRecords(const std::vector<Record>& records);
+
     /**
      * @brief Update records in the table based on a condition.
-     * @param record The new record data to apply.
-     * @param condition The condition (e.g., "column = value" or "all") for updating.
-     * @return true if at least one record was updated; false otherwise.
+     * @param assignments The (column ordinal, new value) pairs to apply.
+     * @param condition The condition selecting the records to update (every record if it has no column).
+     * @param affected If not null, receives the number of records updated.
+     * @return true if the update was applied (possibly to no record); false on error.
      */
-    bool updateRecord(const Record& record, const std::string& condition);
+    bool updateRecord(const std::vector<std::pair<size_t, Value>>& assignments, const Condition& condition,
+        size_t* affected = nullptr);
 
     /**
      * @brief Delete records from the table based on a condition.
-     * @param condition The condition (e.g., "column = value" or "all") for deletion.
-     * @return true if at least one record was deleted; false otherwise.
+     *
+     * When few records are deleted, each is replaced by the last record of the table, so that only the keys of
+     * the records removed and moved change in the indexes; the other records keep their order. A larger
+     * deletion compacts the table in order and rebuilds the indexes.
+     * @param condition The condition selecting the records to delete (every record if it has no column).
+     * @param affected If not null, receives the number of records deleted.
+     * @return true if the deletion was applied (possibly to no record); false on error.
+     */
+    bool deleteRecord(const Condition& condition, size_t* affected = nullptr);
+
+    /**
+     * @brief Find the positions of the records matching a condition.
+     *
+     * The condition is bound to the columns once (see Predicate). Equality (or IN) on a column that alone
+     * forms a PRIMARY KEY or UNIQUE constraint is answered through its hash index in O(1); a comparison (or
+     * IN, or BETWEEN) on the leading column of a secondary index is answered by a B+tree range scan. Of an
+     * AND, one operand that an index answers finds the candidates and the others are checked on them alone;
+     * an OR whose operands indexes all answer merges them. Anything else is scanned in batches (see Batch).
+     * @param condition The condition (every record if it matches all).
+     * @param positions Receives the matching positions in ascending order.
+     * @return true if the condition is valid; false otherwise.
+     */
+    bool findRecords(const Condition& condition, std::vector<size_t>& positions) const;
+
+    /**
+     * @brief Add the records matching a condition to an aggregation.
+     *
+     * The records are found as by findRecords(), but a condition that no index answers is checked batch by
+     * batch as the table is scanned, each batch going straight to the aggregation: a single pass, without
+     * collecting positions. The aggregation is first sized for the groups expected (see estimateGroups()).
+     * @param condition The condition (every record if it matches all).
+     * @param aggregation The aggregation, over this table's schema.
+     * @return true if the condition is valid and the records were added; false otherwise.
+     */
+    bool aggregate(const Condition& condition, Aggregation& aggregation) const;
+
+    /**
+     * @brief Sort record positions by the value of a column.
+     *
+     * Uses a secondary index whose leading column is the sort column when one exists.
+     * @param positions The positions to sort, in place.
+     * @param column The column to sort by.
+     * @param descending Whether to sort in descending order.
+     * @return true if the column exists; false otherwise.
+     */
+    bool sortRecords(std::vector<size_t>& positions, const std::string& column, bool descending) const;
+
+    /**
+     * @brief Create a secondary index and build it from the existing records.
+     * @param indexName The index name.
+     * @param columnNames The indexed column(s), in key order.
+     * @return true if the index was created; false if a column is unknown or the name is taken.
+     */
+    bool createIndex(const std::string& indexName, const std::vector<std::string>& columnNames);
+
+    /**
+     * @brief Drop a secondary index.
+     * @param indexName The index name.
+     * @return true if the index existed; false otherwise.
      */
-    bool deleteRecord(const std::string& condition);
+    bool dropIndex(const std::string& indexName);
+
+    /**
+     * @brief Check whether the table has a secondary index with the given name.
+     * @param indexName The index name.
+     * @return true if found; false otherwise.
+     */
+    bool hasIndex(const std::string& indexName) const;
+
+    /**
+     * @brief Get the secondary indexes of the table.
+     * @return const std::vector<SecondaryIndex>& The secondary indexes.
+     */
+    const std::vector<SecondaryIndex>& getIndexes() const;
 
     /**
      * @brief Get all records in the table.
-     * @return const std::vector<Record>& A reference to the vector of records.
+     *
+     * The records are materialized from the storage; prefer getRecordCount() and getValue() for scans.
+     * @return std::vector<Record> A copy of the records.
+     */
+    std::vector<Record> getRecords() const;
+
+    /**
+     * @brief Get the number of records in the table.
+     * @return size_t The number of records.
+     */
+    size_t getRecordCount() const;
+
+    /**
+     * @brief Get the record at a position.
+     * @param position The record position.
+     * @return Record A copy of the record.
      */
-    const std::vector<Record>& getRecords() const;
+    Record getRecord(size_t position) const;
+
+    /**
+     * @brief Get one value of the record at a position.
+     * @param position The record position.
+     * @param ordinal The column ordinal.
+     * @return Value The value.
+     */
+    Value getValue(size_t position, size_t ordinal) const;
+
+    /**
+     * @brief Format records, one line per record, as "name: value | " for each of the given columns.
+     *
+     * The records are read in batches, column by column (see Batch).
+     * @param positions The record positions.
+     * @param count The number of positions.
+     * @param ordinals The column ordinals.
+     * @param text The text to append to.
+     */
+    void formatRecords(const size_t* positions, size_t count, const std::vector<size_t>& ordinals, std::string& text) const;
+
+    /**
+     * @brief Check whether one value of the record at a position is NULL.
+     * @param position The record position.
+     * @param ordinal The column ordinal.
+     * @return true if the value is NULL; false otherwise.
+     */
+    bool isNull(size_t position, size_t ordinal) const;
+
+    /**
+     * @brief Get the physical layout of the rows.
+     * @return StorageLayout The layout.
+     */
+    StorageLayout getLayout() const;
 
     /**
      * @brief Get the schema of the table.
@@ -67,12 +222,86 @@ public:
      */
     const Schema& getSchema() const;
 
+    /**
+     * @brief Drop a column from the schema and from every record.
+     * @param columnName The column name.
+     * @return true if the column was dropped; false if it does not exist or belongs to a PRIMARY KEY/UNIQUE constraint.
+     */
     bool dropColumn(const std::string& columnName);
 
+    /**
+     * @brief Drop the FOREIGN KEY constraints that reference a table.
+     * @param referencedTable The referenced table name.
+     * @return true if a constraint was dropped; false if none references the table.
+     */
+    bool dropForeignKeys(const std::string& referencedTable);
+
+    /**
+     * @brief Create a copy of the table, its records and its indexes, carrying the same version.
+     *
+     * Used to modify a table while a background checkpoint is still writing the original.
+     * @return std::shared_ptr<Table> The copy.
+     */
+    std::shared_ptr<Table> clone() const;
+
+    /**
+     * @brief Get the version of the table's content, which changes with every modification.
+     *
+     * Versions are unique across all tables of the process, so a version saved for one table never
+     * matches another table (e.g. one created again under the same name).
+     * @return uint64_t The version.
+     */
+    uint64_t getVersion() const;
+
 private:
     std::string name;
     Schema schema;
-    std::vector<Record> records; // List of records in the table.
+    std::unique_ptr<TableStorage> storage; // The records of the table.
+    uint64_t version; // Changes with every modification of the records, indexes or columns.
+
+    // One hash index per PRIMARY KEY / UNIQUE constraint, mapping key -> position in records.
+    std::vector<HashIndex> indexes;
+
+    // Secondary (B+tree) indexes created with CREATE INDEX.
+    std::vector<SecondaryIndex> secondaryIndexes;
+
+    // Resolve column names to ordinals; returns false if a column is not in the schema.
+    bool resolveColumns(const std::vector<std::string>& columnNames, std::vector<size_t>& ordinals) const;
+
+    // Check a value against the type and nullability of the column at an ordinal.
+    bool checkValue(size_t ordinal, const Value& value) const;
+
+    // Check a record against the column definitions and compute its key for every PK/UNIQUE index
+    // (keys and hasKey hold one slot per index).
+    bool checkRecord(const Record& record, std::string* keys, char* hasKey) const;
+
+    // Apply the assignments to the records at the given positions, keeping the indexes consistent.
+    // Returns false without modifying anything if the update would violate a column definition or a
+    // PRIMARY KEY / UNIQUE constraint.
+    bool applyUpdate(const std::vector<size_t>& positions, const std::vector<std::pair<size_t, Value>>& assignments);
+
+    // Find the positions of the records that match a node of a bound predicate, in ascending order.
+    void evaluate(const Predicate::Node& node, std::vector<size_t>& positions) const;
+    // Whether indexes answer a node: a comparison that findHashIndex() or findSecondaryIndex() answers,
+    // an AND with such an operand, or an OR of such operands only.
+    bool isIndexed(const Predicate::Node& node) const;
+    const HashIndex* findHashIndex(const Predicate::Node& node) const;
+    const SecondaryIndex* findSecondaryIndex(const Predicate::Node& node) const;
+    // Find the positions matching a comparison through the index that answers it.
+    void lookUp(const Predicate::Node& node, std::vector<size_t>& positions) const;
+    // Estimate the number of distinct keys of some columns among a number of the records.
+    size_t estimateGroups(const std::vector<size_t>& ordinals, size_t rowCount) const;
+
+    // Remove one record, moving the last record into its place (see deleteRecord()).
+    void removeRecord(size_t position);
+
+    // Rebuild every index after records have been moved or columns removed.
+    void rebuildIndexes();
+
+    // Give the table a new version after a modification.
+    void touch();
 
-    // Indexes for optimization can be added later.
+    // Copy a table (see clone()); assignment is disabled.
+    Table(const Table& other);
+    Table& operator=(const Table&) = delete;
 };
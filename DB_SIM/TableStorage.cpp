@@ -0,0 +1,399 @@
+﻿#include "TableStorage.h"
+#include <algorithm>
+
+std::unique_ptr<TableStorage> TableStorage::create(StorageLayout layout, const Schema& schema) {
+    if (layout == StorageLayout::COLUMNAR)
+        return std::unique_ptr<TableStorage>(new ColumnarStorage(schema));
+    return std::unique_ptr<TableStorage>(new RowStorage());
+}
+
+// A placeholder for the slot of a NULL string gathered from records.
+static const std::string NULL_STRING;
+
+// Gather the values of one column of some records into the buffers of a vector; row(i) is the i-th record.
+template <typename Row>
+static void gatherRecords(const std::vector<Record>& records, size_t ordinal, size_t count, Row row, ColumnVector& vector) {
+    vector.nullBuffer.assign((count + 63) / 64, 0);
+    switch (vector.type) {
+    case DataType::INTEGER: vector.integerBuffer.resize(count); break;
+    case DataType::FLOAT: vector.floatBuffer.resize(count); break;
+    default: vector.stringBuffer.resize(count); break;
+    }
+    // One pass over the records per column type, so that the type is not tested per value.
+    auto gather = [&](auto store) {
+        for (size_t i = 0; i < count; ++i) {
+            const Value& value = records[row(i)].getValue(ordinal);
+            bool null = value.isNull();
+            vector.nullBuffer[i >> 6] |= uint64_t(null) << (i & 63);
+            store(i, value, null);
+        }
+    };
+    switch (vector.type) {
+    case DataType::INTEGER:
+        gather([&vector](size_t i, const Value& value, bool null) { vector.integerBuffer[i] = null ? 0 : value.getInteger(); });
+        break;
+    case DataType::FLOAT:
+        gather([&vector](size_t i, const Value& value, bool null) { vector.floatBuffer[i] = null ? 0.0 : value.getFloat(); });
+        break;
+    default:
+        gather([&vector](size_t i, const Value& value, bool null) {
+            vector.stringBuffer[i] = null ? &NULL_STRING : &value.getString();
+        });
+        break;
+    }
+    vector.integers = vector.integerBuffer.data();
+    vector.floats = vector.floatBuffer.data();
+    vector.strings = vector.stringBuffer.data();
+    vector.nulls = vector.nullBuffer.data();
+}
+
+// Keep the elements of a vector whose flag is not set, preserving their order.
+// Reserve room for a number of elements, at least doubling the capacity when it has to grow.
+template <typename T>
+static void grow(std::vector<T>& data, size_t count) {
+    if (count > data.capacity())
+        data.reserve(std::max(count, data.capacity() * 2));
+}
+
+template <typename T>
+static void compact(std::vector<T>& data, const std::vector<char>& doomed) {
+    size_t out = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (!doomed[i]) {
+            if (out != i)
+                data[out] = std::move(data[i]);
+            ++out;
+        }
+    }
+    data.resize(out);
+}
+
+//---------------------------------------------------------------------
+// RowStorage
+//---------------------------------------------------------------------
+RowStorage::RowStorage() {
+    // Starts empty.
+}
+
+RowStorage::~RowStorage() {
+    // No dynamic resources to release.
+}
+
+std::unique_ptr<TableStorage> RowStorage::clone() const {
+    return std::unique_ptr<TableStorage>(new RowStorage(*this));
+}
+
+StorageLayout RowStorage::getLayout() const {
+    return StorageLayout::ROW;
+}
+
+size_t RowStorage::size() const {
+    return records.size();
+}
+
+void RowStorage::reserve(size_t rows) {
+    grow(records, rows);
+}
+
+void RowStorage::append(const Record& record) {
+    records.push_back(record);
+}
+
+Record RowStorage::getRecord(size_t row) const {
+    return records[row];
+}
+
+Value RowStorage::getValue(size_t row, size_t ordinal) const {
+    return records[row].getValue(ordinal);
+}
+
+bool RowStorage::isNull(size_t row, size_t ordinal) const {
+    return records[row].getValue(ordinal).isNull();
+}
+
+void RowStorage::setValue(size_t row, size_t ordinal, const Value& value) {
+    records[row].setValue(ordinal, value);
+}
+
+void RowStorage::eraseRows(const std::vector<char>& doomed) {
+    compact(records, doomed);
+}
+
+void RowStorage::removeRow(size_t row) {
+    if (row + 1 < records.size())
+        records[row] = std::move(records.back());
+    records.pop_back();
+}
+
+void RowStorage::clear() {
+    records.clear();
+}
+
+void RowStorage::eraseColumn(size_t ordinal) {
+    for (auto& record : records) {
+        record.eraseValue(ordinal);
+    }
+}
+
+int RowStorage::compareValue(size_t row, size_t ordinal, const Value& value) const {
+    return records[row].getValue(ordinal).compare(value);
+}
+
+void RowStorage::readColumn(size_t ordinal, size_t begin, size_t count, ColumnVector& vector) const {
+    gatherRecords(records, ordinal, count, [begin](size_t i) { return begin + i; }, vector);
+}
+
+void RowStorage::gatherColumn(size_t ordinal, const size_t* rows, size_t count, ColumnVector& vector) const {
+    gatherRecords(records, ordinal, count, [rows](size_t i) { return rows[i]; }, vector);
+}
+
+//---------------------------------------------------------------------
+// ColumnarStorage
+//---------------------------------------------------------------------
+bool ColumnarStorage::ColumnData::isNull(size_t row) const {
+    return (nulls[row >> 6] >> (row & 63)) & 1;
+}
+
+void ColumnarStorage::ColumnData::setNull(size_t row, bool null) {
+    uint64_t bit = uint64_t(1) << (row & 63);
+    if (null)
+        nulls[row >> 6] |= bit;
+    else
+        nulls[row >> 6] &= ~bit;
+}
+
+ColumnarStorage::ColumnarStorage(const Schema& schema)
+    : rowCount(0)
+{
+    for (const auto& column : schema.getColumns()) {
+        ColumnData data;
+        data.type = column.getType();
+        columns.push_back(std::move(data));
+    }
+}
+
+ColumnarStorage::~ColumnarStorage() {
+    // The column vectors release their own memory.
+}
+
+std::unique_ptr<TableStorage> ColumnarStorage::clone() const {
+    return std::unique_ptr<TableStorage>(new ColumnarStorage(*this));
+}
+
+StorageLayout ColumnarStorage::getLayout() const {
+    return StorageLayout::COLUMNAR;
+}
+
+size_t ColumnarStorage::size() const {
+    return rowCount;
+}
+
+void ColumnarStorage::reserve(size_t rows) {
+    for (auto& column : columns) {
+        switch (column.type) {
+        case DataType::INTEGER: grow(column.integers, rows); break;
+        case DataType::FLOAT: grow(column.floats, rows); break;
+        default: grow(column.strings, rows); break;
+        }
+        grow(column.nulls, (rows + 63) / 64);
+    }
+}
+
+void ColumnarStorage::append(const Record& record) {
+    size_t row = rowCount++;
+    for (size_t ordinal = 0; ordinal < columns.size(); ++ordinal) {
+        ColumnData& column = columns[ordinal];
+        switch (column.type) {
+        case DataType::INTEGER: column.integers.push_back(0); break;
+        case DataType::FLOAT: column.floats.push_back(0.0); break;
+        default: column.strings.emplace_back(); break;
+        }
+        if ((row & 63) == 0)
+            column.nulls.push_back(0);
+        setValue(row, ordinal, record.getValue(ordinal));
+    }
+}
+
+Record ColumnarStorage::getRecord(size_t row) const {
+    Record record(columns.size());
+    for (size_t ordinal = 0; ordinal < columns.size(); ++ordinal) {
+        record.setValue(ordinal, getValue(row, ordinal));
+    }
+    return record;
+}
+
+Value ColumnarStorage::getValue(size_t row, size_t ordinal) const {
+    const ColumnData& column = columns[ordinal];
+    if (column.isNull(row))
+        return Value();
+    switch (column.type) {
+    case DataType::INTEGER: return Value(column.integers[row]);
+    case DataType::FLOAT: return Value(column.floats[row]);
+    default: return Value(column.strings[row]);
+    }
+}
+
+bool ColumnarStorage::isNull(size_t row, size_t ordinal) const {
+    return columns[ordinal].isNull(row);
+}
+
+int ColumnarStorage::compareValue(size_t row, size_t ordinal, const Value& value) const {
+    const ColumnData& column = columns[ordinal];
+    switch (column.type) {
+    case DataType::INTEGER:
+        if (value.getType() == DataType::INTEGER) {
+            int64_t integer = value.getInteger();
+            return (column.integers[row] < integer) ? -1 : (column.integers[row] > integer) ? 1 : 0;
+        }
+        break;
+    case DataType::FLOAT:
+        if (value.getType() != DataType::STRING) {
+            double number = value.getFloat();
+            return (column.floats[row] < number) ? -1 : (column.floats[row] > number) ? 1 : 0;
+        }
+        break;
+    default:
+        if (value.getType() == DataType::STRING)
+            return column.strings[row].compare(value.getString());
+        break;
+    }
+    // The value is not of the column's type: fall back to the typed comparison of Value.
+    return getValue(row, ordinal).compare(value);
+}
+
+void ColumnarStorage::setValue(size_t row, size_t ordinal, const Value& value) {
+    ColumnData& column = columns[ordinal];
+    column.setNull(row, value.isNull());
+    switch (column.type) {
+    case DataType::INTEGER: column.integers[row] = value.isNull() ? 0 : value.getInteger(); break;
+    case DataType::FLOAT: column.floats[row] = value.isNull() ? 0.0 : value.getFloat(); break;
+    default:
+        if (value.isNull())
+            column.strings[row].clear();
+        else
+            column.strings[row] = value.getString();
+        break;
+    }
+}
+
+void ColumnarStorage::eraseRows(const std::vector<char>& doomed) {
+    for (auto& column : columns) {
+        compact(column.integers, doomed);
+        compact(column.floats, doomed);
+        compact(column.strings, doomed);
+
+        // Re-pack the null bits of the surviving rows.
+        std::vector<uint64_t> nulls;
+        size_t out = 0;
+        for (size_t i = 0; i < rowCount; ++i) {
+            if (doomed[i])
+                continue;
+            if ((out & 63) == 0)
+                nulls.push_back(0);
+            if (column.isNull(i))
+                nulls[out >> 6] |= uint64_t(1) << (out & 63);
+            ++out;
+        }
+        column.nulls.swap(nulls);
+    }
+    size_t remaining = 0;
+    for (size_t i = 0; i < rowCount; ++i) {
+        if (!doomed[i])
+            ++remaining;
+    }
+    rowCount = remaining;
+}
+
+void ColumnarStorage::removeRow(size_t row) {
+    size_t last = rowCount - 1;
+    for (auto& column : columns) {
+        // Only the vector of the column's type holds values.
+        if (!column.integers.empty()) {
+            column.integers[row] = column.integers[last];
+            column.integers.pop_back();
+        }
+        if (!column.floats.empty()) {
+            column.floats[row] = column.floats[last];
+            column.floats.pop_back();
+        }
+        if (!column.strings.empty()) {
+            if (row != last)
+                column.strings[row] = std::move(column.strings[last]);
+            column.strings.pop_back();
+        }
+        column.setNull(row, column.isNull(last));
+        column.setNull(last, false);
+        if ((last & 63) == 0)
+            column.nulls.pop_back();
+    }
+    rowCount = last;
+}
+
+void ColumnarStorage::clear() {
+    for (auto& column : columns) {
+        column.integers.clear();
+        column.floats.clear();
+        column.strings.clear();
+        column.nulls.clear();
+    }
+    rowCount = 0;
+}
+
+void ColumnarStorage::eraseColumn(size_t ordinal) {
+    columns.erase(columns.begin() + ordinal);
+}
+
+void ColumnarStorage::readColumn(size_t ordinal, size_t begin, size_t count, ColumnVector& vector) const {
+    const ColumnData& column = columns[ordinal];
+    // The bitmap is used in place when the rows start on one of its words.
+    if (begin % 64 == 0)
+        vector.nulls = column.nulls.data() + begin / 64;
+    else {
+        vector.nullBuffer.assign((count + 63) / 64, 0);
+        for (size_t i = 0; i < count; ++i)
+            vector.nullBuffer[i >> 6] |= uint64_t(column.isNull(begin + i)) << (i & 63);
+        vector.nulls = vector.nullBuffer.data();
+    }
+    switch (column.type) {
+    case DataType::INTEGER:
+        vector.integers = column.integers.data() + begin;
+        break;
+    case DataType::FLOAT:
+        vector.floats = column.floats.data() + begin;
+        break;
+    default:
+        vector.stringBuffer.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            vector.stringBuffer[i] = &column.strings[begin + i];
+        vector.strings = vector.stringBuffer.data();
+        break;
+    }
+}
+
+void ColumnarStorage::gatherColumn(size_t ordinal, const size_t* rows, size_t count, ColumnVector& vector) const {
+    const ColumnData& column = columns[ordinal];
+    vector.nullBuffer.assign((count + 63) / 64, 0);
+    for (size_t i = 0; i < count; ++i)
+        vector.nullBuffer[i >> 6] |= uint64_t(column.isNull(rows[i])) << (i & 63);
+    vector.nulls = vector.nullBuffer.data();
+    switch (column.type) {
+    case DataType::INTEGER:
+        vector.integerBuffer.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            vector.integerBuffer[i] = column.integers[rows[i]];
+        vector.integers = vector.integerBuffer.data();
+        break;
+    case DataType::FLOAT:
+        vector.floatBuffer.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            vector.floatBuffer[i] = column.floats[rows[i]];
+        vector.floats = vector.floatBuffer.data();
+        break;
+    default:
+        vector.stringBuffer.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            vector.stringBuffer[i] = &column.strings[rows[i]];
+        vector.strings = vector.stringBuffer.data();
+        break;
+    }
+}
@@ -0,0 +1,258 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "Schema.h"
+#include "Record.h"
+
+/**
+ * @brief Enumeration for the physical layouts a table can be stored in.
+ */
+enum class StorageLayout {
+    ROW,      // One Record per row (default).
+    COLUMNAR, // One contiguous typed vector per column plus a null bitmap.
+};
+
+/**
+ * @brief The values of one column for a batch of rows, laid out for tight loops (see Batch).
+ *
+ * Only the array matching the type is set. Where the storage keeps the values contiguously they are not
+ * copied: the arrays point into it. Otherwise the storage gathers them into the buffers and the arrays
+ * point there.
+ */
+struct ColumnVector {
+    DataType type = DataType::STRING;
+    const int64_t* integers = nullptr;
+    const double* floats = nullptr;
+    const std::string* const* strings = nullptr;
+    const uint64_t* nulls = nullptr; // Bit i is set when value i is NULL; the slot of a NULL holds a placeholder.
+
+    std::vector<int64_t> integerBuffer;
+    std::vector<double> floatBuffer;
+    std::vector<const std::string*> stringBuffer;
+    std::vector<uint64_t> nullBuffer;
+};
+
+/**
+ * @brief Base class for the physical storage of the rows of a table.
+ *
+ * This abstract class defines how a Table reads and writes its rows by position and column ordinal;
+ * the Table itself handles validation, constraints and indexes on top of it.
+ *
+ * Usage:
+ * - Create the storage for a schema with TableStorage::create().
+ * - Values stored must already match the column type (or be NULL).
+ */
+class TableStorage {
+public:
+    virtual ~TableStorage() {}
+
+    /**
+     * @brief Create an empty storage of the given layout for a schema.
+     * @param layout The storage layout.
+     * @param schema The schema of the table.
+     * @return std::unique_ptr<TableStorage> The new storage.
+     */
+    static std::unique_ptr<TableStorage> create(StorageLayout layout, const Schema& schema);
+
+    /**
+     * @brief Create a copy of the storage and every row in it.
+     * @return std::unique_ptr<TableStorage> The copy.
+     */
+    virtual std::unique_ptr<TableStorage> clone() const = 0;
+
+    /**
+     * @brief Get the layout of the storage.
+     * @return StorageLayout The layout.
+     */
+    virtual StorageLayout getLayout() const = 0;
+
+    /**
+     * @brief Get the number of rows.
+     * @return size_t The number of rows.
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Reserve room for a number of rows.
+     *
+     * Capacity grows at least geometrically, so reserving ahead of every small batch stays amortized O(1) per row.
+     * @param rows The total number of rows expected.
+     */
+    virtual void reserve(size_t rows) = 0;
+
+    /**
+     * @brief Append a row.
+     * @param record The row, with one value per column.
+     */
+    virtual void append(const Record& record) = 0;
+
+    /**
+     * @brief Materialize the row at a position.
+     * @param row The row position.
+     * @return Record The row.
+     */
+    virtual Record getRecord(size_t row) const = 0;
+
+    /**
+     * @brief Get one value of a row.
+     * @param row The row position.
+     * @param ordinal The column ordinal.
+     * @return Value The value.
+     */
+    virtual Value getValue(size_t row, size_t ordinal) const = 0;
+
+    /**
+     * @brief Check whether one value of a row is NULL, without materializing it.
+     * @param row The row position.
+     * @param ordinal The column ordinal.
+     * @return true if the value is NULL; false otherwise.
+     */
+    virtual bool isNull(size_t row, size_t ordinal) const = 0;
+
+    /**
+     * @brief Compare one non-NULL value of a row with a value, where it is stored (without copying it).
+     * @param row The row position.
+     * @param ordinal The column ordinal.
+     * @param value The non-NULL value to compare with, of the column's type.
+     * @return int Negative, zero or positive, as Value::compare() would return.
+     */
+    virtual int compareValue(size_t row, size_t ordinal, const Value& value) const = 0;
+
+    /**
+     * @brief Overwrite one value of a row.
+     * @param row The row position.
+     * @param ordinal The column ordinal.
+     * @param value The new value.
+     */
+    virtual void setValue(size_t row, size_t ordinal, const Value& value) = 0;
+
+    /**
+     * @brief Remove rows in one compaction pass; the remaining rows keep their relative order.
+     * @param doomed One flag per row; rows whose flag is set are removed.
+     */
+    virtual void eraseRows(const std::vector<char>& doomed) = 0;
+
+    /**
+     * @brief Remove one row by moving the last row into its place, in O(1); the order of the rows is not kept.
+     * @param row The row position.
+     */
+    virtual void removeRow(size_t row) = 0;
+
+    /**
+     * @brief Remove every row.
+     */
+    virtual void clear() = 0;
+
+    /**
+     * @brief Remove a column from every row; later columns move down by one ordinal.
+     * @param ordinal The column ordinal.
+     */
+    virtual void eraseColumn(size_t ordinal) = 0;
+
+    /**
+     * @brief Read the values of one column for consecutive rows.
+     * @param ordinal The column ordinal.
+     * @param begin The first row.
+     * @param count The number of rows.
+     * @param vector Holds the column's type; receives the values (valid until the storage changes).
+     */
+    virtual void readColumn(size_t ordinal, size_t begin, size_t count, ColumnVector& vector) const = 0;
+
+    /**
+     * @brief Read the values of one column for the given rows.
+     * @param ordinal The column ordinal.
+     * @param rows The row positions.
+     * @param count The number of rows.
+     * @param vector Holds the column's type; receives the values (valid until the storage changes).
+     */
+    virtual void gatherColumn(size_t ordinal, const size_t* rows, size_t count, ColumnVector& vector) const = 0;
+};
+
+/**
+ * @brief RowStorage keeps each row as a Record.
+ *
+ * Usage:
+ * - The default layout; best when rows are read and written whole.
+ */
+class RowStorage : public TableStorage {
+public:
+    RowStorage();
+    ~RowStorage();
+
+    std::unique_ptr<TableStorage> clone() const override;
+    StorageLayout getLayout() const override;
+    size_t size() const override;
+    void reserve(size_t rows) override;
+    void append(const Record& record) override;
+    Record getRecord(size_t row) const override;
+    Value getValue(size_t row, size_t ordinal) const override;
+    bool isNull(size_t row, size_t ordinal) const override;
+    int compareValue(size_t row, size_t ordinal, const Value& value) const override;
+    void setValue(size_t row, size_t ordinal, const Value& value) override;
+    void eraseRows(const std::vector<char>& doomed) override;
+    void removeRow(size_t row) override;
+    void clear() override;
+    void eraseColumn(size_t ordinal) override;
+    void readColumn(size_t ordinal, size_t begin, size_t count, ColumnVector& vector) const override;
+    void gatherColumn(size_t ordinal, const size_t* rows, size_t count, ColumnVector& vector) const override;
+
+private:
+    std::vector<Record> records;
+};
+
+/**
+ * @brief ColumnarStorage keeps each column in its own contiguous typed vector plus a null bitmap.
+ *
+ * Responsibilities:
+ * - INTEGER columns are stored as int64_t, FLOAT columns as double and STRING columns as std::string.
+ * - A NULL is a set bit in the column's bitmap; its slot in the typed vector holds a placeholder.
+ * - A scan of one column reads only that column's vector and bitmap, in place.
+ *
+ * Usage:
+ * - Selected with CREATE TABLE ... STORAGE COLUMNAR; suits scans that filter or aggregate few columns.
+ */
+class ColumnarStorage : public TableStorage {
+public:
+    /**
+     * @brief Construct an empty ColumnarStorage object.
+     * @param schema The schema of the table, giving the type of every column.
+     */
+    explicit ColumnarStorage(const Schema& schema);
+    ~ColumnarStorage();
+
+    std::unique_ptr<TableStorage> clone() const override;
+    StorageLayout getLayout() const override;
+    size_t size() const override;
+    void reserve(size_t rows) override;
+    void append(const Record& record) override;
+    Record getRecord(size_t row) const override;
+    Value getValue(size_t row, size_t ordinal) const override;
+    bool isNull(size_t row, size_t ordinal) const override;
+    int compareValue(size_t row, size_t ordinal, const Value& value) const override;
+    void setValue(size_t row, size_t ordinal, const Value& value) override;
+    void eraseRows(const std::vector<char>& doomed) override;
+    void removeRow(size_t row) override;
+    void clear() override;
+    void eraseColumn(size_t ordinal) override;
+    void readColumn(size_t ordinal, size_t begin, size_t count, ColumnVector& vector) const override;
+    void gatherColumn(size_t ordinal, const size_t* rows, size_t count, ColumnVector& vector) const override;
+
+private:
+    // The values of one column; only the vector matching the column type is used.
+    struct ColumnData {
+        DataType type;
+        std::vector<int64_t> integers;
+        std::vector<double> floats;
+        std::vector<std::string> strings;
+        std::vector<uint64_t> nulls; // Bit i is set when row i is NULL.
+
+        bool isNull(size_t row) const;
+        void setNull(size_t row, bool null);
+    };
+
+    std::vector<ColumnData> columns;
+    size_t rowCount;
+};
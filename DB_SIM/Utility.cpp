@@ -3,6 +3,12 @@
 #include <sstream>
 #include <iomanip>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace Utility {
 
     std::string generateUUID() {
@@ -73,4 +79,13 @@ namespace Utility {
         }
         return result;
     }
+
+    // Helper function to force the data written to a file down to the disk.
+    bool syncFile(FILE* file) {
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
 } // namespace Utility
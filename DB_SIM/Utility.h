@@ -4,6 +4,7 @@
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
 
 /**
  * @brief The Utility namespace contains helper functions for the database system.
@@ -14,6 +15,7 @@
  * - split() splits a string by a delimiter and trims each token.
  * - removeApostrophe() removes surrounding apostrophes from a string.
  * - toUpper() converts a string to uppercase.
+ * - syncFile() forces what was written to a file down to the disk.
  */
 namespace Utility {
 
@@ -53,4 +55,11 @@ namespace Utility {
      * @return std::string The uppercase version of the string.
      */
     std::string toUpper(const std::string& s);
+
+    /**
+     * @brief Force the data written to a file (and flushed out of its stdio buffer) down to the disk.
+     * @param file The open file.
+     * @return true if the data reached the disk; false otherwise.
+     */
+    bool syncFile(FILE* file);
 }
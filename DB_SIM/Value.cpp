@@ -0,0 +1,189 @@
+﻿#include "Value.h"
+#include "Utility.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Tags placed before each encoded key value; NULL sorts before numbers, numbers before text.
+static const char TAG_NULL = 0x00;
+static const char TAG_NUMBER = 0x01;
+static const char TAG_TEXT = 0x02;
+
+// Append a 64-bit value in big-endian order so that byte order equals numeric order.
+static void appendBigEndian(uint64_t bits, std::string& key) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key += static_cast<char>((bits >> shift) & 0xFF);
+    }
+}
+
+Value::Value()
+    : data()
+{
+    // NULL.
+}
+
+Value::Value(int64_t value)
+    : data(value)
+{
+}
+
+Value::Value(double value)
+    : data(value)
+{
+}
+
+Value::Value(std::string value)
+    : data(std::move(value))
+{
+}
+
+bool Value::parse(DataType type, const std::string& text, Value& value) {
+    std::string trimmed = Utility::trim(text);
+    if (Utility::toUpper(trimmed) == "NULL") {
+        value = Value();
+        return true;
+    }
+    return convert(type, Utility::removeApostrophe(trimmed), value);
+}
+
+bool Value::convert(DataType type, const std::string& literal, Value& value) {
+    switch (type) {
+    case DataType::INTEGER: {
+        if (literal.empty())
+            return false;
+        char* end = nullptr;
+        errno = 0;
+        long long number = std::strtoll(literal.c_str(), &end, 10);
+        if (*end != '\0' || errno != 0)
+            return false;
+        value = Value(static_cast<int64_t>(number));
+        return true;
+    }
+    case DataType::FLOAT: {
+        if (literal.empty())
+            return false;
+        char* end = nullptr;
+        double number = std::strtod(literal.c_str(), &end);
+        if (*end != '\0' || std::isnan(number))
+            return false;
+        value = Value(number);
+        return true;
+    }
+    case DataType::STRING:
+    default:
+        value = Value(literal);
+        return true;
+    }
+}
+
+bool Value::isNull() const {
+    return std::holds_alternative<std::monostate>(data);
+}
+
+DataType Value::getType() const {
+    if (std::holds_alternative<int64_t>(data))
+        return DataType::INTEGER;
+    if (std::holds_alternative<double>(data))
+        return DataType::FLOAT;
+    return DataType::STRING;
+}
+
+int64_t Value::getInteger() const {
+    return std::get<int64_t>(data);
+}
+
+double Value::getFloat() const {
+    if (const int64_t* integer = std::get_if<int64_t>(&data))
+        return static_cast<double>(*integer);
+    return std::get<double>(data);
+}
+
+const std::string& Value::getString() const {
+    return std::get<std::string>(data);
+}
+
+std::string Value::toString() const {
+    if (isNull())
+        return "NULL";
+    if (const int64_t* integer = std::get_if<int64_t>(&data))
+        return std::to_string(*integer);
+    if (const double* number = std::get_if<double>(&data)) {
+        // Use the shortest representation that reads back to the same double.
+        char buffer[32];
+        int precision = 1;
+        for (; precision <= 17; ++precision) {
+            std::snprintf(buffer, sizeof(buffer), "%.*g", precision, *number);
+            if (std::strtod(buffer, nullptr) == *number)
+                break;
+        }
+        // Keep whole numbers such as 10 out of exponent notation (%g would print 1e+01).
+        int exponent = (*number != 0.0) ? static_cast<int>(std::floor(std::log10(std::fabs(*number)))) : 0;
+        if (exponent >= precision && exponent < 17)
+            std::snprintf(buffer, sizeof(buffer), "%.*g", exponent + 1, *number);
+        return buffer;
+    }
+    return std::get<std::string>(data);
+}
+
+int Value::compare(const Value& other) const {
+    if (isNull() || other.isNull())
+        return static_cast<int>(!isNull()) - static_cast<int>(!other.isNull());
+
+    const std::string* text = std::get_if<std::string>(&data);
+    const std::string* otherText = std::get_if<std::string>(&other.data);
+    if (text && otherText)
+        return text->compare(*otherText);
+    if (text || otherText)
+        return text ? 1 : -1; // Numbers sort before text, as in appendKey().
+
+    const int64_t* integer = std::get_if<int64_t>(&data);
+    const int64_t* otherInteger = std::get_if<int64_t>(&other.data);
+    if (integer && otherInteger)
+        return (*integer < *otherInteger) ? -1 : (*integer > *otherInteger) ? 1 : 0;
+    double a = getFloat();
+    double b = other.getFloat();
+    return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+bool Value::operator==(const Value& other) const {
+    return compare(other) == 0;
+}
+
+bool Value::operator!=(const Value& other) const {
+    return compare(other) != 0;
+}
+
+void Value::appendKey(std::string& key) const {
+    if (isNull()) {
+        key += TAG_NULL;
+        return;
+    }
+    if (const int64_t* integer = std::get_if<int64_t>(&data)) {
+        key += TAG_NUMBER;
+        appendBigEndian(static_cast<uint64_t>(*integer) ^ (1ULL << 63), key);
+        return;
+    }
+    if (const double* number = std::get_if<double>(&data)) {
+        double folded = (*number == 0.0) ? 0.0 : *number; // Fold -0.0 into 0.0.
+        uint64_t bits = 0;
+        std::memcpy(&bits, &folded, sizeof(bits));
+        // Negative numbers: invert all bits; positive numbers: set the sign bit.
+        bits = (bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63));
+        key += TAG_NUMBER;
+        appendBigEndian(bits, key);
+        return;
+    }
+
+    // Text: escape NUL bytes and terminate with two NULs, so that a shorter string
+    // sorts before any longer string it prefixes.
+    key += TAG_TEXT;
+    for (char c : std::get<std::string>(data)) {
+        key += c;
+        if (c == '\0')
+            key += static_cast<char>(0xFF);
+    }
+    key += '\0';
+    key += '\0';
+}
@@ -0,0 +1,121 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include "Column.h"
+
+/**
+ * @brief The Value class holds one typed cell of a record: NULL, INTEGER, FLOAT or STRING.
+ *
+ * Responsibilities:
+ * - Stores the value natively (64-bit integer, double or string) instead of as text.
+ * - Parses SQL literals according to a column's DataType and formats values back to text.
+ * - Compares values in typed order and encodes them into byte-comparable index keys.
+ *
+ * Usage:
+ * - Build values with Value::parse() from query text, or directly from native values.
+ * - A default-constructed Value is NULL.
+ */
+class Value {
+public:
+    /**
+     * @brief Construct a NULL value.
+     */
+    Value();
+
+    /**
+     * @brief Construct an INTEGER value.
+     * @param value The integer.
+     */
+    explicit Value(int64_t value);
+
+    /**
+     * @brief Construct a FLOAT value.
+     * @param value The floating-point number.
+     */
+    explicit Value(double value);
+
+    /**
+     * @brief Construct a STRING value.
+     * @param value The string.
+     */
+    explicit Value(std::string value);
+
+    /**
+     * @brief Parse an SQL literal for a column of the given type.
+     *
+     * Surrounding apostrophes are removed; the unquoted keyword NULL (any case) yields NULL.
+     * @param type The data type of the column.
+     * @param text The literal text.
+     * @param value Receives the parsed value.
+     * @return true if the literal is valid for the type; false otherwise.
+     */
+    static bool parse(DataType type, const std::string& text, Value& value);
+
+    /**
+     * @brief Convert raw text (no quotes, no NULL keyword) to a value of the given type.
+     * @param type The data type of the column.
+     * @param text The text.
+     * @param value Receives the converted value.
+     * @return true if the text is valid for the type; false otherwise.
+     */
+    static bool convert(DataType type, const std::string& text, Value& value);
+
+    /**
+     * @brief Check whether the value is NULL.
+     * @return true if NULL; false otherwise.
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Get the data type of a non-NULL value.
+     * @return DataType The data type.
+     */
+    DataType getType() const;
+
+    /**
+     * @brief Get the integer of an INTEGER value.
+     * @return int64_t The integer.
+     */
+    int64_t getInteger() const;
+
+    /**
+     * @brief Get the number of an INTEGER or FLOAT value as a double.
+     * @return double The number.
+     */
+    double getFloat() const;
+
+    /**
+     * @brief Get the string of a STRING value.
+     * @return const std::string& The string.
+     */
+    const std::string& getString() const;
+
+    /**
+     * @brief Format the value as text ("NULL" for NULL).
+     * @return std::string The text.
+     */
+    std::string toString() const;
+
+    /**
+     * @brief Compare with another value. NULL sorts first; INTEGER and FLOAT compare numerically.
+     * @param other The other value.
+     * @return int Negative, zero or positive if this value is less than, equal to or greater than other.
+     */
+    int compare(const Value& other) const;
+
+    bool operator==(const Value& other) const;
+    bool operator!=(const Value& other) const;
+
+    /**
+     * @brief Append an encoding of the value whose byte order matches compare() order for values of one type.
+     *
+     * Encodings are self-delimiting, so the keys of several values can be concatenated.
+     * @param key The key to append to.
+     */
+    void appendKey(std::string& key) const;
+
+private:
+    std::variant<std::monostate, int64_t, double, std::string> data;
+};
@@ -0,0 +1,449 @@
+﻿#include "WriteAheadLog.h"
+#include "Encoding.h"
+#include "Checksum.h"
+#include "Logger.h"
+#include "Utility.h"
+#include "EncryptionHelper.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <vector>
+
+using namespace Encoding;
+
+static const char LOG_MAGIC[] = "DBSIMWAL";
+static const size_t MAGIC_SIZE = 8;
+static const size_t HEADER_SIZE = MAGIC_SIZE + 4 + 8 + 8;
+static const size_t RECORD_HEADER_SIZE = 4 + 4;
+
+// How reading the records of a log ended.
+enum class LogEnd {
+    COMPLETE, // Every byte belongs to an intact record.
+    TORN,     // A record is cut short or fails its checksum (or, at the end of the log, its tag).
+    FORGED,   // A record before the end fails its tag.
+};
+
+// The header of a log.
+static std::string encodeHeader(uint64_t logId, uint64_t nonce) {
+    std::string header(LOG_MAGIC, MAGIC_SIZE);
+    putU32(header, WriteAheadLog::VERSION);
+    putU64(header, logId);
+    putU64(header, nonce);
+    return header;
+}
+
+// The GCM nonce of the record at a file offset: the nonce of the file, then the offset.
+static std::string recordNonce(uint64_t nonce, uint64_t offset) {
+    std::string recordNonce;
+    putU64(recordNonce, nonce);
+    putU64(recordNonce, offset);
+    return recordNonce;
+}
+
+// Append a record (its sequence number and payload) to the bytes of a log that start at a file offset, sealed
+// for the offset it goes to if the log is encrypted.
+static bool appendRecord(std::string& data, uint64_t start, const char* body, size_t size, uint64_t nonce,
+    const std::string& header, const WriteAheadLog::Cipher& cipher) {
+    uint64_t offset = start + data.size();
+    size_t tagSize = cipher.seal ? EncryptionHelper::TAG_SIZE : 0;
+    size_t at = data.size();
+    data.append(RECORD_HEADER_SIZE, '\0');
+    data.append(body, size);
+    data.append(tagSize, '\0');
+    char* sealed = &data[at + RECORD_HEADER_SIZE];
+    if (cipher.seal && !cipher.seal(sealed, size, recordNonce(nonce, offset), header, sealed + size)) {
+        data.resize(at);
+        return false;
+    }
+    // The checksum covers the record as stored, so a torn record is told apart from one that was altered.
+    std::string recordHeader;
+    putU32(recordHeader, static_cast<uint32_t>(size + tagSize));
+    putU32(recordHeader, Checksum::crc32c(sealed, size + tagSize));
+    data.replace(at, RECORD_HEADER_SIZE, recordHeader);
+    return true;
+}
+
+// Read the records of a log that start at an offset of data (at a file offset of start), opening each in place
+// if the log is sealed and handing its body (the sequence number and payload) to visit, until visit returns
+// false. Returns the offset in data where the intact records end.
+static size_t readRecords(std::string& data, size_t offset, uint64_t start, uint64_t nonce, const std::string& header,
+    const WriteAheadLog::RecordCipher& open, LogEnd& end, const std::function<bool(const char* body, size_t size)>& visit) {
+    size_t tagSize = open ? EncryptionHelper::TAG_SIZE : 0;
+    end = LogEnd::COMPLETE;
+    while (offset < data.size()) {
+        Cursor cursor = { data.data() + offset, data.data() + data.size() };
+        uint32_t length = 0, checksum = 0;
+        const char* stored = nullptr;
+        if (!cursor.u32(length) || !cursor.u32(checksum) || length < 8 + tagSize || !cursor.bytes(length, stored)
+            || Checksum::crc32c(stored, length) != checksum) {
+            end = LogEnd::TORN;
+            break;
+        }
+        char* body = &data[offset + RECORD_HEADER_SIZE];
+        size_t size = length - tagSize;
+        if (open && !open(body, size, recordNonce(nonce, start + offset), header, body + size)) {
+            end = cursor.pos == cursor.end ? LogEnd::TORN : LogEnd::FORGED;
+            break;
+        }
+        if (!visit(body, size)) {
+            end = LogEnd::TORN;
+            break;
+        }
+        offset = static_cast<size_t>(cursor.pos - data.data());
+    }
+    return offset;
+}
+
+// Encode a whole log file: the header, then the records (given as the bodies readRecords() opened in data),
+// sealed for the offsets they go to. Returns an empty string if the records could not be sealed.
+static std::string encodeLog(uint64_t logId, uint64_t nonce, const std::string& data,
+    const std::vector<std::pair<size_t, size_t>>& bodies, const WriteAheadLog::Cipher& cipher) {
+    std::string log = encodeHeader(logId, nonce);
+    std::string header = log;
+    for (const auto& body : bodies) {
+        if (!appendRecord(log, 0, data.data() + body.first, body.second, nonce, header, cipher))
+            return std::string();
+    }
+    return log;
+}
+
+// Replace a file through a temporary file forced to disk, so that a failure leaves the previous one intact.
+static bool replaceFile(const std::string& filename, const std::string& data) {
+    std::string tempName = filename + ".tmp";
+    FILE* replacement = std::fopen(tempName.c_str(), "wb");
+    bool written = replacement != nullptr && std::fwrite(data.data(), 1, data.size(), replacement) == data.size()
+        && std::fflush(replacement) == 0 && Utility::syncFile(replacement);
+    if (replacement != nullptr)
+        written = std::fclose(replacement) == 0 && written;
+    // Rename does not overwrite an existing file on every platform.
+    if (written && (std::rename(tempName.c_str(), filename.c_str()) == 0
+            || (std::remove(filename.c_str()) == 0 && std::rename(tempName.c_str(), filename.c_str()) == 0)))
+        return true;
+    if (replacement != nullptr)
+        std::remove(tempName.c_str());
+    return false;
+}
+
+WriteAheadLog::WriteAheadLog()
+    : file(nullptr), logId(0), nonce(0), size(0), position(0), dirty(false),
+      policy(SyncPolicy::STATEMENT), interval(DEFAULT_GROUP_INTERVAL), stopping(false)
+{
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+bool WriteAheadLog::open(const std::string& filename, uint64_t logId, uint64_t position, const Cipher& cipher,
+    const Replay& replay, size_t* replayed) {
+    close();
+    if (replayed)
+        *replayed = 0;
+
+    std::string data;
+    std::ifstream in(filename, std::ios::binary);
+    if (in) {
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        data = buffer.str();
+    }
+    in.close();
+
+    // A log written for another snapshot (e.g. the one a flush was replacing when it stopped) is obsolete.
+    Cursor header = { data.data(), data.data() + data.size() };
+    const char* magic = nullptr;
+    uint32_t version = 0;
+    uint64_t fileLogId = 0, fileNonce = 0;
+    if (!header.bytes(MAGIC_SIZE, magic) || std::string(magic, MAGIC_SIZE) != LOG_MAGIC
+        || !header.u32(version) || version != VERSION || !header.u64(fileLogId) || fileLogId != logId
+        || !header.u64(fileNonce)) {
+        if (!data.empty() && (magic == nullptr || std::string(magic, MAGIC_SIZE) != LOG_MAGIC))
+            std::cerr << "Warning: " << filename << " is not a log of this database; starting a new log." << std::endl;
+        else if (!data.empty() && Logger::isEnabled(LogLevel::VERBOSE))
+            std::cout << "Log " << filename << " belongs to another snapshot; starting a new log.\n";
+        return create(filename, logId, position, cipher);
+    }
+
+    // Replay every intact record; the first torn or corrupted one ends the log.
+    uint64_t last = position;
+    bool first = true;
+    std::vector<std::pair<size_t, size_t>> bodies;
+    LogEnd logEnd = LogEnd::COMPLETE;
+    size_t end = readRecords(data, HEADER_SIZE, 0, fileNonce, data.substr(0, HEADER_SIZE), cipher.open, logEnd,
+        [&](const char* body, size_t size) {
+            Cursor bodyCursor = { body, body + size };
+            uint64_t sequence = 0;
+            bodyCursor.u64(sequence);
+            if (!first && sequence != last + 1)
+                return false;
+            first = false;
+            bodies.emplace_back(static_cast<size_t>(body - data.data()), size);
+            // Records the snapshot already includes are skipped.
+            if (sequence > position) {
+                if (!replay(std::string(bodyCursor.pos, bodyCursor.end)))
+                    std::cerr << "Warning: Logged operation " << sequence << " could not be replayed." << std::endl;
+                else if (replayed)
+                    ++*replayed;
+            }
+            last = std::max(last, sequence);
+            return true;
+        });
+    // A record that was tampered with is not cut off: the log is left as it is for inspection.
+    if (logEnd == LogEnd::FORGED) {
+        std::cerr << "Error: The log record at offset " << end << " of " << filename << " fails authentication; the "
+            << "records from it on were not replayed, and changes are not logged until the next FLUSH." << std::endl;
+        std::lock_guard<std::mutex> lock(mutex);
+        this->position = last;
+        return false;
+    }
+
+    if (end == data.size())
+        return attach(filename, logId, fileNonce, last, end, cipher);
+
+    // Cut off the torn tail. The intact records are sealed anew in a new file under a new nonce, so that new
+    // records are not sealed under the nonces the torn bytes were.
+    std::cerr << "Warning: Discarded " << (data.size() - end) << " byte(s) of incomplete log records at the end of "
+        << filename << "." << std::endl;
+    uint64_t newNonce = EncryptionHelper::newNonce();
+    std::string replacement = encodeLog(logId, newNonce, data, bodies, cipher);
+    if (replacement.empty() || !replaceFile(filename, replacement)) {
+        std::cerr << "Error: Cannot truncate log file: " << filename << std::endl;
+        return false;
+    }
+    return attach(filename, logId, newNonce, last, replacement.size(), cipher);
+}
+
+bool WriteAheadLog::create(const std::string& filename, uint64_t logId, uint64_t position, const Cipher& cipher) {
+    close();
+    uint64_t newNonce = EncryptionHelper::newNonce();
+    std::string header = encodeHeader(logId, newNonce);
+    if (!replaceFile(filename, header)) {
+        std::cerr << "Error: Cannot write log file: " << filename << std::endl;
+        return false;
+    }
+    return attach(filename, logId, newNonce, position, header.size(), cipher);
+}
+
+bool WriteAheadLog::attach(const std::string& filename, uint64_t logId, uint64_t nonce, uint64_t position, uint64_t size,
+    const Cipher& cipher) {
+    FILE* opened = std::fopen(filename.c_str(), "ab");
+    if (opened == nullptr) {
+        std::cerr << "Error: Cannot open log file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->file = opened;
+        this->filename = filename;
+        this->cipher = cipher;
+        this->logId = logId;
+        this->nonce = nonce;
+        this->size = size;
+        this->position = position;
+        this->dirty = false;
+    }
+    startSyncer();
+    if (Logger::isEnabled(LogLevel::VERBOSE))
+        std::cout << "Logging changes to " << filename << " (sync " << toString(policy) << ").\n";
+    return true;
+}
+
+void WriteAheadLog::close() {
+    stopSyncer();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr)
+        return;
+    if (dirty && policy != SyncPolicy::NONE)
+        Utility::syncFile(file);
+    std::fclose(file);
+    file = nullptr;
+    dirty = false;
+}
+
+bool WriteAheadLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr;
+}
+
+bool WriteAheadLog::append(const std::string& payload) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr)
+        return false;
+
+    std::string body;
+    body.reserve(8 + payload.size());
+    putU64(body, position + 1);
+    body.append(payload);
+    std::string record;
+    record.reserve(RECORD_HEADER_SIZE + body.size() + EncryptionHelper::TAG_SIZE);
+    if (!appendRecord(record, size, body.data(), body.size(), nonce, encodeHeader(logId, nonce), cipher)) {
+        std::cerr << "Error: Cannot encrypt a record of log file " << filename << "; changes are no longer logged." << std::endl;
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size() || std::fflush(file) != 0) {
+        // A torn record ends the log on recovery, so nothing may be appended after it.
+        std::cerr << "Error: Cannot write to log file " << filename << "; changes are no longer logged." << std::endl;
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    size += record.size();
+    ++position;
+    if (policy == SyncPolicy::STATEMENT) {
+        if (!Utility::syncFile(file)) {
+            std::cerr << "Error: Cannot sync log file: " << filename << std::endl;
+            return false;
+        }
+    }
+    else {
+        dirty = true;
+    }
+    return true;
+}
+
+uint64_t WriteAheadLog::getPosition() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return position;
+}
+
+uint64_t WriteAheadLog::getLogId() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr ? logId : 0;
+}
+
+std::string WriteAheadLog::getFilename() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr ? filename : std::string();
+}
+
+uint64_t WriteAheadLog::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr ? size : 0;
+}
+
+bool WriteAheadLog::discard(uint64_t offset) {
+    // The syncer holds on to the file outside the lock; it is stopped while the file is replaced.
+    stopSyncer();
+    bool discarded = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string data;
+        uint64_t newNonce = EncryptionHelper::newNonce();
+        if (file != nullptr && offset >= HEADER_SIZE && offset <= size) {
+            // The records after the offset move to a new file, sealed anew under its nonce.
+            std::string tail(static_cast<size_t>(size - offset), '\0');
+            std::ifstream in(filename, std::ios::binary);
+            in.seekg(static_cast<std::streamoff>(offset));
+            std::vector<std::pair<size_t, size_t>> bodies;
+            LogEnd end = LogEnd::COMPLETE;
+            if (in && in.read(&tail[0], static_cast<std::streamsize>(tail.size()))
+                && readRecords(tail, 0, offset, nonce, encodeHeader(logId, nonce), cipher.open, end,
+                    [&](const char* body, size_t length) {
+                        bodies.emplace_back(static_cast<size_t>(body - tail.data()), length);
+                        return true;
+                    }) == tail.size())
+                data = encodeLog(logId, newNonce, tail, bodies, cipher);
+        }
+
+        if (!data.empty()) {
+            // The file is closed while it is replaced: not every platform renames over an open file.
+            std::fclose(file);
+            discarded = replaceFile(filename, data);
+            file = std::fopen(filename.c_str(), "ab");
+            if (file == nullptr)
+                std::cerr << "Error: Cannot open log file " << filename << "; changes are no longer logged." << std::endl;
+            if (discarded) {
+                nonce = newNonce;
+                size = data.size();
+                dirty = false;
+            }
+        }
+        if (!discarded && file != nullptr)
+            std::cerr << "Warning: Cannot shorten log file " << filename << "; it keeps the records the snapshot includes."
+                << std::endl;
+    }
+    startSyncer();
+    return discarded;
+}
+
+void WriteAheadLog::setSyncPolicy(SyncPolicy policy, unsigned interval) {
+    stopSyncer();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Records written under a laxer policy are forced now rather than left behind.
+        if (file != nullptr && dirty && policy != SyncPolicy::NONE) {
+            Utility::syncFile(file);
+            dirty = false;
+        }
+        this->policy = policy;
+        this->interval = std::max(1u, interval);
+    }
+    startSyncer();
+}
+
+void WriteAheadLog::startSyncer() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (policy != SyncPolicy::GROUP || file == nullptr || syncer.joinable())
+        return;
+    stopping = false;
+    syncer = std::thread(&WriteAheadLog::runSyncer, this);
+}
+
+void WriteAheadLog::stopSyncer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (syncer.joinable())
+        syncer.join();
+}
+
+void WriteAheadLog::runSyncer() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wake.wait_for(lock, std::chrono::milliseconds(interval));
+        if (dirty && file != nullptr) {
+            // Sync outside the lock so that statements keep appending meanwhile; the file stays
+            // open until this thread is stopped.
+            dirty = false;
+            FILE* synced = file;
+            lock.unlock();
+            Utility::syncFile(synced);
+            lock.lock();
+        }
+    }
+}
+
+bool WriteAheadLog::parseSyncPolicy(const std::string& name, SyncPolicy& policy) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (upper == "STATEMENT")
+        policy = SyncPolicy::STATEMENT;
+    else if (upper == "GROUP")
+        policy = SyncPolicy::GROUP;
+    else if (upper == "NONE")
+        policy = SyncPolicy::NONE;
+    else
+        return false;
+    return true;
+}
+
+const char* WriteAheadLog::toString(SyncPolicy policy) {
+    switch (policy) {
+    case SyncPolicy::GROUP:
+        return "GROUP";
+    case SyncPolicy::NONE:
+        return "NONE";
+    default:
+        return "STATEMENT";
+    }
+}
@@ -0,0 +1,227 @@
+﻿#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @brief Enumeration for when the write-ahead log forces its records to disk.
+ */
+enum class SyncPolicy {
+    STATEMENT, // Every statement waits for its record to reach the disk (fsync per statement).
+    GROUP,     // A background thread forces the records written in the last interval together.
+    NONE,      // Records are handed to the operating system but never forced; a system crash may lose them.
+};
+
+/**
+ * @brief The WriteAheadLog class appends a record for each change made since the last snapshot.
+ *
+ * Responsibilities:
+ * - Appends records to the log file of a snapshot ("<snapshot>.wal") and forces them to disk per the sync policy.
+ *   Every record reaches the operating system before append() returns, so a crash of the process alone
+ *   loses nothing; the policy decides what a crash of the system may lose.
+ * - Reads the records back on open(), so that they can be replayed on top of the snapshot.
+ * - Drops the records a checkpoint of the snapshot has come to include (see discard()), keeping the ones after it.
+ *
+ * Format (version 3; every integer is little-endian):
+ * - Header: the magic "DBSIMWAL", the uint32 format version, the uint64 log identifier, which the snapshot
+ *   the log continues records in its header (see SnapshotWriter), and the uint64 nonce the records are
+ *   sealed under. The header is not encrypted.
+ * - Records: the uint32 length of the rest of the record, the uint32 CRC-32C of the rest of the record as
+ *   stored, then the uint64 sequence number (increasing by one per record, across logs) and the payload,
+ *   followed in an encrypted log by their tag. A record cut short or failing its checksum marks the end of the
+ *   log: it was being written when the process stopped.
+ *
+ * An encrypted log seals every record on its own with AES-256-GCM (see RecordCipher), under the nonce of the
+ * file followed by the record's file offset and with the header as associated data, so that a record that was
+ * altered, moved or taken from another log fails authentication. Such a record at the end of the log is cut
+ * off like a torn one; before the end, nothing after it is replayed and the log is left as it is.
+ *
+ * Every file gets a new nonce, and the log is never written over in place: records that are kept when the
+ * log is shortened (or when a torn record is cut off) are sealed anew in a new file. A log of another version
+ * is treated like one of another snapshot.
+ *
+ * Usage:
+ * - open() attaches to the log of a loaded snapshot, create() starts a new one after a flush, discard()
+ *   shortens it after a background checkpoint.
+ * - append() writes one record; close() (or the destructor) forces what is left and detaches.
+ */
+class WriteAheadLog {
+public:
+    /**
+     * @brief Seals a record of an encrypted log in place, writing its tag (when writing), or checks the tag and
+     * opens it in place (when reading), under a GCM nonce and the header of the log as associated data; returns
+     * false if it cannot, e.g. because the record fails authentication.
+     */
+    using RecordCipher = std::function<bool(char* data, size_t size, const std::string& nonce, const std::string& header,
+        char* tag)>;
+
+    /**
+     * @brief How the records of a log are encrypted; the members are empty if they are not.
+     */
+    struct Cipher {
+        RecordCipher seal;
+        RecordCipher open;
+    };
+
+    /**
+     * @brief Applies one record read back from the log; returns false if it could not be applied.
+     */
+    using Replay = std::function<bool(const std::string& payload)>;
+
+    /**
+     * @brief The format version this build reads and writes.
+     */
+    static const uint32_t VERSION = 3;
+
+    /**
+     * @brief The default interval of the GROUP policy, in milliseconds.
+     */
+    static const unsigned DEFAULT_GROUP_INTERVAL = 100;
+
+    /**
+     * @brief Construct a new WriteAheadLog object, detached from any file.
+     */
+    WriteAheadLog();
+
+    /**
+     * @brief Destroy the WriteAheadLog object, closing the log.
+     */
+    ~WriteAheadLog();
+
+    /**
+     * @brief Attach to the log that continues a snapshot, replaying its records first.
+     *
+     * Records up to the snapshot's position are already in the snapshot and are skipped. A file that
+     * is missing or belongs to another snapshot is replaced by an empty log.
+     * @param filename The log file name.
+     * @param logId The log identifier recorded in the snapshot.
+     * @param position The sequence number of the last operation the snapshot includes.
+     * @param cipher How the records are encrypted.
+     * @param replay Applies each record that follows the snapshot.
+     * @param replayed If not null, receives the number of records replayed.
+     * @return true if the log was read and is attached; false otherwise, e.g. if a record before the end fails
+     * authentication.
+     */
+    bool open(const std::string& filename, uint64_t logId, uint64_t position, const Cipher& cipher,
+        const Replay& replay, size_t* replayed = nullptr);
+
+    /**
+     * @brief Start a new, empty log, replacing the file if it exists.
+     * @param filename The log file name.
+     * @param logId The log identifier recorded in the snapshot the log continues.
+     * @param position The sequence number of the last operation the snapshot includes.
+     * @param cipher How the records are encrypted.
+     * @return true if the log is attached; false otherwise.
+     */
+    bool create(const std::string& filename, uint64_t logId, uint64_t position, const Cipher& cipher);
+
+    /**
+     * @brief Force the records not yet on disk (unless the policy is NONE) and detach from the file.
+     */
+    void close();
+
+    /**
+     * @brief Check whether a log file is attached.
+     * @return true if records are being appended to a file; false otherwise.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Append one record and force it to disk if the policy is STATEMENT.
+     * @param payload The record payload.
+     * @return true if the record was written; false otherwise.
+     */
+    bool append(const std::string& payload);
+
+    /**
+     * @brief Get the sequence number of the last record.
+     * @return uint64_t The sequence number (the snapshot's position if no record followed it).
+     */
+    uint64_t getPosition() const;
+
+    /**
+     * @brief Get the identifier of the log.
+     * @return uint64_t The log identifier, or 0 if no log is attached.
+     */
+    uint64_t getLogId() const;
+
+    /**
+     * @brief Get the name of the log file.
+     * @return std::string The file name, or an empty string if no log is attached.
+     */
+    std::string getFilename() const;
+
+    /**
+     * @brief Get the size of the log file.
+     * @return uint64_t The size in bytes, or 0 if no log is attached.
+     */
+    uint64_t getSize() const;
+
+    /**
+     * @brief Drop the records a checkpoint of the snapshot now includes: those before an offset.
+     *
+     * The records after it are copied to a new file that replaces the log, so that the log only holds what
+     * the snapshot is missing. If that fails, the log is left as it was (recovery skips the records the
+     * snapshot includes).
+     * @param offset The size of the log when the last operation the checkpoint includes was its last record.
+     * @return true if the records were dropped; false otherwise.
+     */
+    bool discard(uint64_t offset);
+
+    /**
+     * @brief Set the sync policy.
+     * @param policy The policy.
+     * @param interval The interval of the GROUP policy, in milliseconds.
+     */
+    void setSyncPolicy(SyncPolicy policy, unsigned interval = DEFAULT_GROUP_INTERVAL);
+
+    /**
+     * @brief Parse a sync policy name (case-insensitive).
+     * @param name The policy name: STATEMENT, GROUP or NONE.
+     * @param policy Receives the policy.
+     * @return true if the name is a policy; false otherwise.
+     */
+    static bool parseSyncPolicy(const std::string& name, SyncPolicy& policy);
+
+    /**
+     * @brief Get the name of a sync policy.
+     * @param policy The policy.
+     * @return const char* The upper-case name.
+     */
+    static const char* toString(SyncPolicy policy);
+
+private:
+    FILE* file;
+    std::string filename;
+    Cipher cipher;
+    uint64_t logId;
+    uint64_t nonce;
+    uint64_t size;     // Bytes in the file.
+    uint64_t position; // Sequence number of the last record.
+    bool dirty;        // Records were written since the last sync.
+
+    SyncPolicy policy;
+    unsigned interval;
+    std::thread syncer;
+    bool stopping;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    // Start or stop the background thread of the GROUP policy.
+    void startSyncer();
+    void stopSyncer();
+    void runSyncer();
+
+    // Open the file for appending.
+    bool attach(const std::string& filename, uint64_t logId, uint64_t nonce, uint64_t position, uint64_t size,
+        const Cipher& cipher);
+
+    // Disable copying.
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+};
@@ -2,33 +2,53 @@
 #include <sstream>
 #include <string>
 #include "QueryProcessor.h"
+#include "Logger.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     // Create a QueryProcessor instance (it handles all commands).
     QueryProcessor qp;
 
-    std::cout << "Welcome to the Database Management Application." << std::endl;
-    std::cout << "Available commands:" << std::endl;
-    std::cout << "  CREATE TABLE ...      - Create a new table" << std::endl;
-    std::cout << "  DROP TABLE ...        - Drop an existing table" << std::endl;
-    std::cout << "  DROP COLUMN ...       - Drop a column from a table" << std::endl;
-    std::cout << "  FLUSH <filename> <key>;  - Save database to file" << std::endl;
-    std::cout << "  LOAD <filename> <key>;   - Load database from file" << std::endl;
-    std::cout << "  (Valid SQL queries: INSERT, SELECT, UPDATE, DELETE)" << std::endl;
-    std::cout << "  HELP [command]        - Show usage help" << std::endl;
-    std::cout << "  EXIT                  - Exit the application" << std::endl;
+    // --quiet / --verbose select the initial logging level (see SET LOGGING).
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quiet" || arg == "-q")
+            Logger::setLevel(LogLevel::QUIET);
+        else if (arg == "--verbose" || arg == "-v")
+            Logger::setLevel(LogLevel::VERBOSE);
+        else
+            std::cerr << "Warning: Ignoring unknown option '" << arg << "'." << std::endl;
+    }
+
+    if (Logger::isEnabled(LogLevel::NORMAL)) {
+        std::cout << "Welcome to the Database Management Application." << std::endl;
+        std::cout << "Available commands:" << std::endl;
+        std::cout << "  CREATE TABLE ...      - Create a new table" << std::endl;
+        std::cout << "  CREATE INDEX ...      - Create an ordered index on table columns" << std::endl;
+        std::cout << "  DROP TABLE ...        - Drop an existing table" << std::endl;
+        std::cout << "  DROP INDEX ...        - Drop an index" << std::endl;
+        std::cout << "  DROP COLUMN ...       - Drop a column from a table" << std::endl;
+        std::cout << "  FLUSH <filename> <key>;  - Save database to file" << std::endl;
+        std::cout << "  LOAD <filename> <key>;   - Load database from file" << std::endl;
+        std::cout << "  (Valid SQL queries: INSERT, SELECT, UPDATE, DELETE)" << std::endl;
+        std::cout << "  HELP [command]        - Show usage help" << std::endl;
+        std::cout << "  SET LOGGING ...       - Set the logging level (QUIET, NORMAL or VERBOSE)" << std::endl;
+        std::cout << "  SET SYNC ...          - Set when logged changes reach the disk (STATEMENT, GROUP or NONE)" << std::endl;
+        std::cout << "  SET CHECKPOINT ...    - Take checkpoints in the background (INTERVAL <ms>, SIZE <KB> or OFF)" << std::endl;
+        std::cout << "  EXIT                  - Exit the application" << std::endl;
+    }
 
     std::string input;
     while (true) {
         std::cout << "\n> ";
-        std::getline(std::cin, input);
-        if (input == "EXIT" || input == "exit")
+        // End of input (e.g. a piped script without EXIT) also ends the session.
+        if (!std::getline(std::cin, input) || input == "EXIT" || input == "exit")
             break;
         if (!input.empty()) {
             qp.execute(input);
         }
     }
 
-    std::cout << "Exiting application." << std::endl;
+    if (Logger::isEnabled(LogLevel::NORMAL))
+        std::cout << "Exiting application." << std::endl;
     return 0;
 }